@@ -0,0 +1,216 @@
+#include "compare.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <tuple>
+
+namespace tensile {
+
+namespace {
+
+using FeatureKey = std::pair<std::string, std::string>;
+using ProbeKey = std::tuple<std::string, std::string, std::vector<size_t>>;
+
+std::string JoinDims(const std::vector<size_t> &dims) {
+    std::string text;
+    for (size_t k = 0; k < dims.size(); k++) {
+        text += (k ? "x" : "") + std::to_string(dims[k]);
+    }
+    return text;
+}
+
+// Median absolute deviation of @values relative to their @median, 0 for a single value
+double RelativeSpread(const std::vector<double> &values, double median) {
+    if (values.size() < 2 || median <= 0) return 0;
+    std::vector<double> deviations;
+    for (double value : values) deviations.push_back(std::abs(value - median));
+    return Median(std::move(deviations)) / median;
+}
+
+// Where each kind of failure of a feature is first seen: the smallest failing sizes of probes, or
+// empty if only results fail that way
+using Failures = std::map<FeatureKey, std::map<std::string, std::vector<size_t>>>;
+
+Failures CollectFailures(const ResultSet &set) {
+    Failures failures;
+    for (const auto &result : set.results) {
+        if (result.status.code() == Status::SUCCESS) continue;
+        failures[{result.provider, result.feature}].emplace(FailureKind(result.status), std::vector<size_t>());
+    }
+    for (const auto &probe : set.probes) {
+        if (probe.status.code() == Status::SUCCESS) continue;
+        auto &first = failures[{probe.provider, probe.feature}][FailureKind(probe.status)];
+        if (first.empty() || probe.dims < first) first = probe.dims;
+    }
+    return failures;
+}
+
+// Features a sweep has probes or results of
+std::set<FeatureKey> CheckedFeatures(const ResultSet &set) {
+    std::set<FeatureKey> features;
+    for (const auto &probe : set.probes) features.emplace(probe.provider, probe.feature);
+    for (const auto &result : set.results) features.emplace(result.provider, result.feature);
+    return features;
+}
+
+// Latencies of the successful probes of each provider, feature and sizes
+std::map<ProbeKey, std::vector<double>> CollectLatencies(const ResultSet &set) {
+    std::map<ProbeKey, std::vector<double>> latencies;
+    for (const auto &probe : set.probes) {
+        if (probe.status.code() != Status::SUCCESS) continue;
+        latencies[{probe.provider, probe.feature, probe.dims}].push_back(probe.latency.count());
+    }
+    return latencies;
+}
+
+// Limit of each feature, from its first result
+std::map<FeatureKey, size_t> CollectLimits(const ResultSet &set) {
+    std::map<FeatureKey, size_t> limits;
+    for (const auto &result : set.results) limits.emplace(FeatureKey(result.provider, result.feature), result.limit);
+    return limits;
+}
+
+}  // namespace
+
+std::string Change::ToString() const {
+    char text[128];
+    std::string line;
+    switch (kind) {
+        case Kind::LIMIT_DROP:
+        case Kind::LIMIT_GAIN: {
+            line = kind == Kind::LIMIT_DROP ? "limit drop" : "limit gain";
+            line += " " + provider + " / " + feature;
+            const double percent = baseline > 0 ? 100 * (candidate - baseline) / baseline : 0;
+            std::snprintf(text, sizeof(text), ": %.0f -> %.0f (%+.0f%%)", baseline, candidate, percent);
+            line += text;
+            break;
+        }
+        case Kind::SLOWER:
+        case Kind::FASTER:
+            line = kind == Kind::SLOWER ? "slower" : "faster";
+            line += " " + provider + " / " + feature + " n=" + JoinDims(dims);
+            std::snprintf(text, sizeof(text), ": %.0fus -> %.0fus (x%.2f, threshold x%.2f)", baseline, candidate,
+                          baseline > 0 ? candidate / baseline : 0, threshold);
+            line += text;
+            break;
+        case Kind::NEW_FAILURE:
+        case Kind::FIXED_FAILURE:
+            line = kind == Kind::NEW_FAILURE ? "new failure" : "fixed failure";
+            line += " " + provider + " / " + feature;
+            if (!dims.empty()) line += " at n=" + JoinDims(dims);
+            line += ": " + failure;
+            break;
+    }
+    return line;
+}
+
+std::string FailureKind(const Status &status) {
+    const std::string &message = status.message();
+    std::string kind = Status(status.code()).ToString();
+    if (!message.empty()) kind += ": ";
+    bool in_number = false;
+    for (char c : message.substr(0, message.find('\n'))) {
+        const bool digit = std::isdigit(static_cast<unsigned char>(c));
+        if (!digit) {
+            kind += c;
+        } else if (!in_number) {
+            kind += '#';
+        }
+        in_number = digit;
+    }
+    return kind;
+}
+
+std::vector<Change> CompareResults(const ResultSet &baseline, const ResultSet &candidate,
+                                   const CompareOptions &options) {
+    // Changes of each feature, in order of kind
+    std::map<FeatureKey, std::vector<Change>> changes;
+    auto add = [&](Change change) {
+        changes[{change.provider, change.feature}].push_back(std::move(change));
+    };
+
+    const auto baseline_limits = CollectLimits(baseline);
+    for (const auto &[key, candidate_limit] : CollectLimits(candidate)) {
+        auto found = baseline_limits.find(key);
+        if (found == baseline_limits.end()) continue;
+        const double before = found->second;
+        const double after = candidate_limit;
+        Change change;
+        change.provider = key.first;
+        change.feature = key.second;
+        change.baseline = before;
+        change.candidate = after;
+        if (after < before * (1 - options.limit_tolerance)) {
+            change.kind = Change::Kind::LIMIT_DROP;
+            add(std::move(change));
+        } else if (after > before * (1 + options.limit_tolerance)) {
+            change.kind = Change::Kind::LIMIT_GAIN;
+            add(std::move(change));
+        }
+    }
+
+    const auto baseline_latencies = CollectLatencies(baseline);
+    const double min_latency = options.min_latency.count();
+    for (const auto &[key, candidate_latencies] : CollectLatencies(candidate)) {
+        auto found = baseline_latencies.find(key);
+        if (found == baseline_latencies.end()) continue;
+        const double before = Median(found->second);
+        const double after = Median(candidate_latencies);
+        if (std::max(before, after) < min_latency || before <= 0 || after <= 0) continue;
+        const double noise = RelativeSpread(found->second, before) + RelativeSpread(candidate_latencies, after);
+        const double threshold = std::max(options.latency_ratio, 1 + options.noise_factor * noise);
+        Change change;
+        change.provider = std::get<0>(key);
+        change.feature = std::get<1>(key);
+        change.dims = std::get<2>(key);
+        change.baseline = before;
+        change.candidate = after;
+        change.threshold = threshold;
+        if (after > before * threshold) {
+            change.kind = Change::Kind::SLOWER;
+            add(std::move(change));
+        } else if (after * threshold < before) {
+            change.kind = Change::Kind::FASTER;
+            add(std::move(change));
+        }
+    }
+
+    // Failures only compare between features both sweeps checked
+    const Failures baseline_failures = CollectFailures(baseline);
+    const Failures candidate_failures = CollectFailures(candidate);
+    const auto checked = CheckedFeatures(baseline);
+    const auto candidate_checked = CheckedFeatures(candidate);
+    auto compare_failures = [&](const Failures &from, const Failures &against, Change::Kind kind) {
+        for (const auto &[key, kinds] : from) {
+            if (!checked.count(key) || !candidate_checked.count(key)) continue;
+            auto other = against.find(key);
+            for (const auto &[failure, dims] : kinds) {
+                if (other != against.end() && other->second.count(failure)) continue;
+                Change change;
+                change.kind = kind;
+                change.provider = key.first;
+                change.feature = key.second;
+                change.dims = dims;
+                change.failure = failure;
+                add(std::move(change));
+            }
+        }
+    };
+    compare_failures(candidate_failures, baseline_failures, Change::Kind::NEW_FAILURE);
+    compare_failures(baseline_failures, candidate_failures, Change::Kind::FIXED_FAILURE);
+
+    std::vector<Change> ordered;
+    for (auto &[key, feature_changes] : changes) {
+        std::stable_sort(feature_changes.begin(), feature_changes.end(),
+                         [](const Change &a, const Change &b) { return a.kind < b.kind; });
+        for (auto &change : feature_changes) ordered.push_back(std::move(change));
+    }
+    return ordered;
+}
+
+}  // namespace tensile
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "tensile.h"
+
+namespace tensile {
+
+// Probes and results of one sweep, as read by ReadResults
+struct ResultSet {
+    std::vector<Probe> probes;
+    std::vector<Result> results;
+};
+
+// Thresholds of CompareResults
+struct CompareOptions {
+    // Fraction of the baseline limit which the candidate may lose or gain without a change
+    double limit_tolerance = 0.1;
+    // Ratio of median latencies beyond which a probe is slower, or faster below its inverse
+    double latency_ratio = 1.5;
+    // Latencies of repeated probes spread out, so the ratio must also exceed 1 plus this many times
+    // the sum of both sides' median absolute deviations relative to their medians
+    double noise_factor = 3;
+    // Probes faster than this on both sides are not compared, being mostly timer noise
+    std::chrono::microseconds min_latency{100};
+};
+
+// Difference between a baseline and a candidate sweep
+struct Change {
+    enum class Kind {
+        // Limit of a feature dropped or grew beyond the tolerance
+        LIMIT_DROP,
+        LIMIT_GAIN,
+        // Median latency of a probe grew or fell beyond the threshold
+        SLOWER,
+        FASTER,
+        // Kind of failure of a feature seen in only one of the sweeps
+        NEW_FAILURE,
+        FIXED_FAILURE,
+    };
+
+    Kind kind = Kind::LIMIT_DROP;
+    std::string provider;
+    std::string feature;
+    // Sizes of the probe for latency changes, the smallest sizes failing for failures, empty for
+    // limits and for failures only seen in results
+    std::vector<size_t> dims;
+    // Limits, or median latencies in microseconds
+    double baseline = 0;
+    double candidate = 0;
+    // Latency ratio the change exceeded
+    double threshold = 0;
+    // Kind of failure, see FailureKind
+    std::string failure;
+
+    // Whether the candidate is worse, which fails a gate
+    bool regression() const { return kind == Kind::LIMIT_DROP || kind == Kind::SLOWER || kind == Kind::NEW_FAILURE; }
+
+    // One line describing the change
+    std::string ToString() const;
+};
+
+// Code and first line of the message of @status, with numbers replaced by '#', so that failures
+// at different sizes and offsets are of the same kind
+std::string FailureKind(const Status &status);
+
+// Aligns the probes of @baseline and @candidate by provider, feature and sizes, and their results
+// by provider and feature, and reports what changed beyond @options. Limits are the first result
+// of each feature, as Driver::Run reports them; failure kinds come from all failing probes and
+// results. Changes are ordered by provider, feature and kind.
+std::vector<Change> CompareResults(const ResultSet &baseline, const ResultSet &candidate,
+                                   const CompareOptions &options);
+
+}  // namespace tensile
@@ -0,0 +1,102 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include "compare.h"
+
+namespace tensile {
+namespace {
+
+Probe MakeProbe(const std::string &feature, size_t n, int64_t latency_us, Status status = Status()) {
+    Probe probe;
+    probe.provider = "engine";
+    probe.feature = feature;
+    probe.dims = {n};
+    probe.latency = std::chrono::microseconds(latency_us);
+    probe.status = std::move(status);
+    return probe;
+}
+
+Result MakeResult(const std::string &feature, size_t limit, Status status) {
+    Result result;
+    result.provider = "engine";
+    result.feature = feature;
+    result.limit = limit;
+    result.status = std::move(status);
+    return result;
+}
+
+std::vector<std::string> Lines(const std::vector<Change> &changes) {
+    std::vector<std::string> lines;
+    for (const auto &change : changes) lines.push_back(change.ToString());
+    return lines;
+}
+
+TEST(Compare, FailureKind) {
+    EXPECT_EQ("Error: stack depth limit exceeded at offset #",
+              FailureKind(Status(Status::ERROR, "stack depth limit exceeded at offset 46\nselect ((((")));
+    EXPECT_EQ("Timeout", FailureKind(Status(Status::TIMEOUT)));
+    EXPECT_EQ("Crash: signal #.#", FailureKind(Status(Status::CRASH, "signal 11.0")));
+}
+
+TEST(Compare, Limits) {
+    const Status depth(Status::ERROR, "too deep at 513");
+    ResultSet baseline, candidate;
+    baseline.results = {MakeResult("chain join", 1000, Status(Status::TIMEOUT)), MakeResult("cte", 512, depth),
+                        MakeResult("union", 100, depth), MakeResult("gone", 5, depth)};
+    candidate.results = {MakeResult("chain join", 600, Status(Status::TIMEOUT)), MakeResult("cte", 480, depth),
+                         MakeResult("union", 200, depth), MakeResult("new", 5, depth),
+                         // Further findings are not limits
+                         MakeResult("union", 50, depth)};
+    const auto changes = CompareResults(baseline, candidate, CompareOptions());
+    EXPECT_THAT(Lines(changes), testing::ElementsAre("limit drop engine / chain join: 1000 -> 600 (-40%)",
+                                                     "limit gain engine / union: 100 -> 200 (+100%)"));
+    EXPECT_TRUE(changes[0].regression());
+    EXPECT_FALSE(changes[1].regression());
+
+    CompareOptions strict;
+    strict.limit_tolerance = 0;
+    EXPECT_EQ(3, CompareResults(baseline, candidate, strict).size());
+}
+
+TEST(Compare, Latencies) {
+    ResultSet baseline, candidate;
+    baseline.probes = {MakeProbe("cte", 512, 1000), MakeProbe("cte", 1024, 3000), MakeProbe("cte", 2, 10),
+                       MakeProbe("join", 8, 1000)};
+    candidate.probes = {MakeProbe("cte", 512, 2100), MakeProbe("cte", 1024, 1000), MakeProbe("cte", 2, 40),
+                        MakeProbe("join", 8, 1400)};
+    auto changes = CompareResults(baseline, candidate, CompareOptions());
+    EXPECT_THAT(Lines(changes),
+                testing::ElementsAre("slower engine / cte n=512: 1000us -> 2100us (x2.10, threshold x1.50)",
+                                     "faster engine / cte n=1024: 3000us -> 1000us (x0.33, threshold x1.50)"));
+    EXPECT_TRUE(changes[0].regression());
+
+    // Noisy repetitions raise the threshold
+    baseline.probes = {MakeProbe("cte", 512, 600), MakeProbe("cte", 512, 1000), MakeProbe("cte", 512, 1400)};
+    candidate.probes = {MakeProbe("cte", 512, 2100)};
+    changes = CompareResults(baseline, candidate, CompareOptions());
+    EXPECT_TRUE(changes.empty()) << Lines(changes)[0];
+    CompareOptions quiet;
+    quiet.noise_factor = 1;
+    changes = CompareResults(baseline, candidate, quiet);
+    ASSERT_EQ(1, changes.size());
+    EXPECT_EQ(Change::Kind::SLOWER, changes[0].kind);
+    EXPECT_DOUBLE_EQ(1.5, changes[0].threshold);
+}
+
+TEST(Compare, Failures) {
+    ResultSet baseline, candidate;
+    baseline.probes = {MakeProbe("cte", 512, 1000), MakeProbe("cte", 1024, 0, Status(Status::TIMEOUT)),
+                       MakeProbe("join", 8, 0, Status(Status::ERROR, "too many joins: 8"))};
+    candidate.probes = {MakeProbe("cte", 512, 1000), MakeProbe("cte", 4096, 0, Status(Status::CRASH)),
+                        MakeProbe("cte", 1024, 0, Status(Status::CRASH)),
+                        MakeProbe("join", 16, 0, Status(Status::ERROR, "too many joins: 16"))};
+    // Features checked by one sweep only are not compared
+    candidate.results = {MakeResult("other", 1, Status(Status::CRASH))};
+    const auto changes = CompareResults(baseline, candidate, CompareOptions());
+    EXPECT_THAT(Lines(changes), testing::ElementsAre("new failure engine / cte at n=1024: Crash",
+                                                     "fixed failure engine / cte at n=1024: Timeout"));
+    EXPECT_TRUE(changes[0].regression());
+    EXPECT_FALSE(changes[1].regression());
+}
+
+}  // namespace
+}  // namespace tensile
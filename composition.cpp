@@ -0,0 +1,273 @@
+#include "composition.h"
+#include "sql_builder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tensile {
+
+namespace {
+
+std::string_view Fragment(FragmentKind kind, std::string_view sql) {
+    constexpr std::string_view kSelect = "select ";
+    if (kind != FragmentKind::QUERY && sql.substr(0, kSelect.size()) == kSelect) {
+        sql.remove_prefix(kSelect.size());
+    }
+    return sql;
+}
+
+// Starts the SQL of a composed fragment of @kind, which needs "select " unless it is a query.
+SqlBuilder &StartStatement(FragmentKind kind, size_t fragment_size, SqlBuilder &sql) {
+    sql.Clear();
+    if (kind == FragmentKind::QUERY) {
+        return sql.Reserve(fragment_size);
+    }
+    return sql.Reserve(fragment_size + 7).Append("select ");
+}
+
+// Feature built by a combinator, which knows where it placed the holes of its parts. The token of
+// a hole can occur elsewhere in composed SQL, e.g. "1" of nested parentheses in "t1" of a CTE, so
+// holes are tracked by offset rather than searched for.
+class ComposedFeature : public IMultiSQLFeature {
+public:
+    // Offsets of the hole tokens in the SQL generated last
+    const std::vector<size_t> &holes() const { return holes_; }
+
+protected:
+    std::vector<size_t> holes_;
+};
+
+// Sets @holes to the offsets of the hole tokens of @feature in @sql, which it generated last.
+// Features other than composed ones have their token only at their holes.
+void FindHoles(IMultiSQLFeature *feature, std::string_view sql, std::vector<size_t> *holes) {
+    if (auto *composed = dynamic_cast<ComposedFeature *>(feature)) {
+        *holes = composed->holes();
+        return;
+    }
+    holes->clear();
+    const std::string_view token = feature->hole().token;
+    if (token.empty()) return;
+    for (size_t pos = sql.find(token); pos != std::string_view::npos; pos = sql.find(token, pos + token.size())) {
+        holes->push_back(pos);
+    }
+}
+
+// Fragment of the SQL @feature generated last, with the offsets of its holes in @holes.
+std::string_view FragmentWithHoles(IMultiSQLFeature *feature, std::string_view sql, std::vector<size_t> *holes) {
+    FindHoles(feature, sql, holes);
+    const std::string_view fragment = Fragment(feature->fragment_kind(), sql);
+    const size_t removed = sql.size() - fragment.size();
+    for (size_t &hole : *holes) hole -= removed;
+    return fragment;
+}
+
+// Appends @fragment to @sql, and the offsets of its holes @fragment_holes to @holes.
+void AppendWithHoles(std::string_view fragment, const std::vector<size_t> &fragment_holes, SqlBuilder &sql,
+                     std::vector<size_t> *holes) {
+    const size_t at = sql.size();
+    for (size_t hole : fragment_holes) holes->push_back(at + hole);
+    sql.Append(fragment);
+}
+
+class LeafFeature : public IMultiSQLFeature {
+public:
+    explicit LeafFeature(std::unique_ptr<ISQLFeature> feature) : feature_(std::move(feature)) {}
+
+    std::string name() override { return feature_->name(); }
+
+    std::vector<std::string> dimension_names() override { return {feature_->name()}; }
+
+    std::string_view GenerateSQL(const std::vector<size_t> &dims) override { return feature_->GenerateSQL(dims[0]); }
+
+    FragmentKind fragment_kind() const override { return feature_->fragment_kind(); }
+
+    Hole hole() const override { return feature_->hole(); }
+
+private:
+    std::unique_ptr<ISQLFeature> feature_;
+};
+
+// Base for combinators of a single feature, which keep its dimensions.
+class UnaryCombinator : public ComposedFeature {
+public:
+    explicit UnaryCombinator(std::unique_ptr<IMultiSQLFeature> feature) : feature_(std::move(feature)) {}
+
+    std::vector<std::string> dimension_names() override { return feature_->dimension_names(); }
+
+    Hole hole() const override { return feature_->hole(); }
+
+protected:
+    std::unique_ptr<IMultiSQLFeature> feature_;
+    // Holes of the SQL of @feature_, reused between calls
+    std::vector<size_t> feature_holes_;
+};
+
+class NestedFeature : public ComposedFeature {
+public:
+    NestedFeature(std::unique_ptr<IMultiSQLFeature> outer, std::unique_ptr<IMultiSQLFeature> inner, std::string name)
+        : outer_(std::move(outer)), inner_(std::move(inner)), name_(std::move(name)) {
+        if (name_.empty()) name_ = outer_->name() + " x " + inner_->name();
+        outer_dims_.resize(outer_->dimension_names().size());
+        inner_dims_.resize(inner_->dimension_names().size());
+    }
+
+    std::string name() override { return name_; }
+
+    std::vector<std::string> dimension_names() override {
+        auto names = outer_->dimension_names();
+        for (auto &name : inner_->dimension_names()) names.push_back(std::move(name));
+        return names;
+    }
+
+    std::string_view GenerateSQL(const std::vector<size_t> &dims) override {
+        std::copy(dims.begin(), dims.begin() + outer_dims_.size(), outer_dims_.begin());
+        std::copy(dims.begin() + outer_dims_.size(), dims.end(), inner_dims_.begin());
+        const std::string_view outer = outer_->GenerateSQL(outer_dims_);
+        const std::string_view inner =
+                FragmentWithHoles(inner_.get(), inner_->GenerateSQL(inner_dims_), &inner_holes_);
+        FindHoles(outer_.get(), outer, &outer_holes_);
+        const size_t token = outer_->hole().token.size();
+        const size_t tokens = outer_holes_.size();
+        SqlBuilder sql(&sql_);
+        sql.Clear().Reserve(outer.size() + tokens * inner.size() - tokens * token);
+        holes_.clear();
+        size_t pos = 0;
+        for (size_t hole : outer_holes_) {
+            sql.Append(outer.substr(pos, hole - pos));
+            AppendWithHoles(inner, inner_holes_, sql, &holes_);
+            pos = hole + token;
+        }
+        sql.Append(outer.substr(pos));
+        return sql_;
+    }
+
+    FragmentKind fragment_kind() const override { return outer_->fragment_kind(); }
+
+    Hole hole() const override { return inner_->hole(); }
+
+private:
+    std::unique_ptr<IMultiSQLFeature> outer_;
+    std::unique_ptr<IMultiSQLFeature> inner_;
+    std::string name_;
+    // Reused between calls to split the dimensions and to place the holes
+    std::vector<size_t> outer_dims_;
+    std::vector<size_t> inner_dims_;
+    std::vector<size_t> outer_holes_;
+    std::vector<size_t> inner_holes_;
+};
+
+class RepeatedFeature : public UnaryCombinator {
+public:
+    RepeatedFeature(std::unique_ptr<IMultiSQLFeature> feature, size_t k) : UnaryCombinator(std::move(feature)), k_(k) {}
+
+    std::string name() override { return feature_->name() + " x" + std::to_string(k_); }
+
+    std::string_view GenerateSQL(const std::vector<size_t> &dims) override {
+        const FragmentKind kind = feature_->fragment_kind();
+        const std::string_view fragment =
+                FragmentWithHoles(feature_.get(), feature_->GenerateSQL(dims), &feature_holes_);
+        std::string_view open, separator, close;
+        if (kind == FragmentKind::QUERY) {
+            separator = " union all ";
+        } else {
+            open = "(";
+            separator = kind == FragmentKind::PREDICATE ? ") and (" : ") + (";
+            close = ")";
+        }
+        SqlBuilder sql(&sql_);
+        StartStatement(kind, k_ * (fragment.size() + separator.size()) + open.size() + close.size(), sql);
+        sql.Append(open);
+        holes_.clear();
+        for (size_t i = 0; i < k_; i++) {
+            if (i > 0) sql.Append(separator);
+            AppendWithHoles(fragment, feature_holes_, sql, &holes_);
+        }
+        sql.Append(close);
+        return sql_;
+    }
+
+    FragmentKind fragment_kind() const override { return feature_->fragment_kind(); }
+
+private:
+    size_t k_;
+};
+
+class WrappedFeature : public UnaryCombinator {
+public:
+    WrappedFeature(std::unique_ptr<IMultiSQLFeature> feature, std::string text, FragmentKind kind)
+        : UnaryCombinator(std::move(feature)), text_(std::move(text)), kind_(kind) {}
+
+    std::string name() override { return feature_->name() + " in " + text_; }
+
+    std::string_view GenerateSQL(const std::vector<size_t> &dims) override {
+        const std::string_view fragment =
+                FragmentWithHoles(feature_.get(), feature_->GenerateSQL(dims), &feature_holes_);
+        const std::string_view text = text_;
+        const size_t at = text.find(kPlaceholder);
+        SqlBuilder sql(&sql_);
+        StartStatement(kind_, text.size() + fragment.size(), sql);
+        sql.Append(text.substr(0, at));
+        holes_.clear();
+        AppendWithHoles(fragment, feature_holes_, sql, &holes_);
+        sql.Append(text.substr(at + kPlaceholder.size()));
+        return sql_;
+    }
+
+    FragmentKind fragment_kind() const override { return kind_; }
+
+    static constexpr std::string_view kPlaceholder = "...";
+
+private:
+    std::string text_;
+    FragmentKind kind_;
+};
+
+}  // namespace
+
+std::unique_ptr<IMultiSQLFeature> Leaf(std::unique_ptr<ISQLFeature> feature) {
+    return std::make_unique<LeafFeature>(std::move(feature));
+}
+
+std::unique_ptr<IMultiSQLFeature> Nest(std::unique_ptr<IMultiSQLFeature> outer, std::unique_ptr<IMultiSQLFeature> inner,
+                                       std::string name) {
+    if (outer->hole().kind == FragmentKind::NONE || outer->hole().token.empty()) {
+        throw std::invalid_argument(outer->name() + " has no hole");
+    }
+    if (outer->hole().kind != inner->fragment_kind()) {
+        throw std::invalid_argument(inner->name() + " does not fit into the hole of " + outer->name());
+    }
+    return std::make_unique<NestedFeature>(std::move(outer), std::move(inner), std::move(name));
+}
+
+std::unique_ptr<IMultiSQLFeature> Nest(std::unique_ptr<ISQLFeature> outer, std::unique_ptr<ISQLFeature> inner,
+                                       std::string name) {
+    return Nest(Leaf(std::move(outer)), Leaf(std::move(inner)), std::move(name));
+}
+
+std::unique_ptr<IMultiSQLFeature> Repeat(std::unique_ptr<IMultiSQLFeature> feature, size_t k) {
+    return std::make_unique<RepeatedFeature>(std::move(feature), k);
+}
+
+std::unique_ptr<IMultiSQLFeature> Repeat(std::unique_ptr<ISQLFeature> feature, size_t k) {
+    return Repeat(Leaf(std::move(feature)), k);
+}
+
+std::unique_ptr<IMultiSQLFeature> Wrap(std::unique_ptr<IMultiSQLFeature> feature, std::string text, FragmentKind kind) {
+    if (text.find(WrappedFeature::kPlaceholder) == std::string::npos) {
+        throw std::invalid_argument("no ... in " + text);
+    }
+    return std::make_unique<WrappedFeature>(std::move(feature), std::move(text), kind);
+}
+
+std::unique_ptr<IMultiSQLFeature> Wrap(std::unique_ptr<ISQLFeature> feature, std::string text, FragmentKind kind) {
+    return Wrap(Leaf(std::move(feature)), std::move(text), kind);
+}
+
+std::unique_ptr<ISQLFeature> GetFeature(const std::string &name) {
+    for (auto &feature : GetBuiltinFeatures()) {
+        if (feature->name() == name) return std::move(feature);
+    }
+    return nullptr;
+}
+
+}  // namespace tensile
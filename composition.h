@@ -0,0 +1,45 @@
+#pragma once
+
+#include "tensile.h"
+
+namespace tensile {
+
+// Combinators building new features out of existing ones through their fragment form (see
+// FragmentKind and Hole). Fragment of a feature is its SQL without the leading "select " for
+// expressions and predicates, and the whole SQL for queries. The result has the dimensions of
+// its parts, outer ones first, so that for example
+//
+//     Nest(Leaf(GetFeature("CTE")), Repeat(Wrap(GetFeature("nested CASE"), "select ... x"), 200))
+//
+// asks how deep CASE can nest inside 200 UNION ALL branches inside a CTE.
+
+// One-dimensional multi feature of @feature.
+std::unique_ptr<IMultiSQLFeature> Leaf(std::unique_ptr<ISQLFeature> feature);
+
+// Replaces every hole of @outer with the fragment of @inner. @inner must be of the kind of the
+// hole. The result keeps the kind of @outer and takes the holes of @inner, so nesting again goes
+// further in. Holes of composed features are tracked by offset, so other occurrences of their
+// token in the SQL, like "1" in "t1", are left alone. Name defaults to "<outer> x <inner>". Throws std::invalid_argument if @outer
+// has no hole or @inner does not fit into it.
+std::unique_ptr<IMultiSQLFeature> Nest(std::unique_ptr<IMultiSQLFeature> outer, std::unique_ptr<IMultiSQLFeature> inner,
+                                       std::string name = "");
+std::unique_ptr<IMultiSQLFeature> Nest(std::unique_ptr<ISQLFeature> outer, std::unique_ptr<ISQLFeature> inner,
+                                       std::string name = "");
+
+// @k copies of the fragment of @feature: queries joined with UNION ALL, expressions added up and
+// predicates joined with AND.
+std::unique_ptr<IMultiSQLFeature> Repeat(std::unique_ptr<IMultiSQLFeature> feature, size_t k);
+std::unique_ptr<IMultiSQLFeature> Repeat(std::unique_ptr<ISQLFeature> feature, size_t k);
+
+// Fragment of @feature placed into @text at its "...", e.g. "select * from (...) t". The result
+// is a fragment of @kind with the hole of @feature, so @text is a query or an expression without
+// the leading "select ". Throws std::invalid_argument if @text has no "...".
+std::unique_ptr<IMultiSQLFeature> Wrap(std::unique_ptr<IMultiSQLFeature> feature, std::string text,
+                                       FragmentKind kind = FragmentKind::QUERY);
+std::unique_ptr<IMultiSQLFeature> Wrap(std::unique_ptr<ISQLFeature> feature, std::string text,
+                                       FragmentKind kind = FragmentKind::QUERY);
+
+// Builtin feature with the given name, or nullptr.
+std::unique_ptr<ISQLFeature> GetFeature(const std::string &name);
+
+}  // namespace tensile
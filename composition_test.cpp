@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "composition.h"
+#include "reference_parser.h"
+#include "sql_lexer.h"
+
+namespace tensile {
+namespace {
+
+TEST(Composition, NestReplacesHoles) {
+    auto feature = Nest(GetFeature("parenthesis"), GetFeature("nested CASE"));
+    EXPECT_EQ("parenthesis x nested CASE", feature->name());
+    EXPECT_EQ((std::vector<std::string>{"parenthesis", "nested CASE"}), feature->dimension_names());
+    EXPECT_EQ(FragmentKind::EXPRESSION, feature->fragment_kind());
+    EXPECT_EQ("select ((case when true then 1 else 0 end))", feature->GenerateSQL({2, 1}));
+    EXPECT_EQ("select (case when true then case when true then 1 else 0 end else 0 end)",
+              feature->GenerateSQL({1, 2}));
+}
+
+TEST(Composition, NestGoesInward) {
+    // The hole of a nested feature is the hole of its inner part
+    auto feature = Nest(Nest(GetFeature("parenthesis"), GetFeature("nested CASE")), Leaf(GetFeature("parenthesis")));
+    EXPECT_EQ(3, feature->dimension_names().size());
+    EXPECT_EQ("select (case when true then ((1)) else 0 end)", feature->GenerateSQL({1, 1, 2}));
+}
+
+TEST(Composition, NestTwiceAtLargeSizes) {
+    // Past t9 the CTE names contain "1", the token of the hole of parentheses, which only the
+    // holes themselves may be replaced at
+    auto feature = Nest(Nest(Leaf(GetFeature("CTE")), Wrap(GetFeature("parenthesis"), "select ... as x")),
+                        Leaf(GetFeature("binary operator  * ")));
+    for (size_t n : {10, 12, 25}) {
+        const std::string_view sql = feature->GenerateSQL({n, 2, 3});
+        SCOPED_TRACE(std::string(sql));
+        std::string reason;
+        EXPECT_EQ(std::string_view::npos, FindUnbalanced(sql, &reason)) << reason;
+        ReferenceParser parser;
+        EXPECT_TRUE(parser.Run(sql, &reason)) << reason;
+        EXPECT_NE(std::string_view::npos, sql.find(", t1 as (select * from t0), "));
+        EXPECT_EQ(std::string_view::npos, sql.find("t1 * 1"));
+    }
+}
+
+TEST(Composition, Repeat) {
+    EXPECT_EQ("select ((1)) + ((1)) + ((1))", Repeat(GetFeature("parenthesis"), 3)->GenerateSQL({1}));
+    EXPECT_EQ("select (1 in (2)) and (1 in (2))", Repeat(GetFeature("IN list"), 2)->GenerateSQL({1}));
+    EXPECT_EQ("select 1 x union all select 1 x union all select 1 x union all select 1 x",
+              Repeat(GetFeature("union all"), 2)->GenerateSQL({1}));
+}
+
+TEST(Composition, Wrap) {
+    auto feature = Wrap(GetFeature("union all"), "select * from (...) t");
+    EXPECT_EQ(FragmentKind::QUERY, feature->fragment_kind());
+    EXPECT_EQ("select * from (select 1 x union all select 1 x) t", feature->GenerateSQL({1}));
+    EXPECT_EQ("select abs((1)) + 1",
+              Wrap(GetFeature("parenthesis"), "abs(...) + 1", FragmentKind::EXPRESSION)->GenerateSQL({1}));
+}
+
+TEST(Composition, CaseInUnionAllInCTE) {
+    auto feature = Nest(Leaf(GetFeature("CTE")), Repeat(Wrap(GetFeature("nested CASE"), "select ... x"), 2));
+    EXPECT_EQ("with t0 as (select case when true then 1 else 0 end x union all "
+              "select case when true then 1 else 0 end x)  select * from t0",
+              feature->GenerateSQL({1, 1}));
+}
+
+TEST(Composition, Invalid) {
+    // IN list has no hole, and a CTE takes queries rather than expressions
+    EXPECT_THROW(Nest(GetFeature("IN list"), GetFeature("IN list")), std::invalid_argument);
+    EXPECT_THROW(Nest(GetFeature("CTE"), GetFeature("parenthesis")), std::invalid_argument);
+    EXPECT_THROW(Wrap(GetFeature("union all"), "select * from t"), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace tensile
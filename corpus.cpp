@@ -0,0 +1,346 @@
+#include "corpus.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tensile {
+namespace corpus {
+
+namespace {
+
+// Compressed block is a sequence of (literal length, literals, match length, match distance),
+// with lengths and distances as base-128 varints, and the last sequence having only literals.
+// Matches may overlap the bytes they produce, so a run of repeated units costs one sequence.
+constexpr size_t kMinMatch = 4;
+constexpr size_t kHashBits = 16;
+
+void AppendVarint(uint64_t value, std::string *output) {
+    while (value >= 0x80) {
+        output->push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    output->push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(std::string_view input, size_t *pos, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*pos >= input.size()) return false;
+        const uint8_t byte = input[(*pos)++];
+        *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) return true;
+    }
+    return false;
+}
+
+uint32_t Hash(const char *p) {
+    uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return (word * 2654435761u) >> (32 - kHashBits);
+}
+
+}  // namespace
+
+void Compress(std::string_view input, std::string *output) {
+    std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+    size_t literal_start = 0;
+    size_t pos = 0;
+    while (pos + kMinMatch <= input.size()) {
+        uint32_t &slot = table[Hash(input.data() + pos)];
+        // Positions are stored plus one, so that zero means none
+        const size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos + 1);
+        if (candidate == 0 || std::memcmp(input.data() + candidate - 1, input.data() + pos, kMinMatch) != 0) {
+            pos++;
+            continue;
+        }
+        const size_t match = candidate - 1;
+        size_t length = kMinMatch;
+        while (pos + length < input.size() && input[match + length] == input[pos + length]) length++;
+        AppendVarint(pos - literal_start, output);
+        output->append(input.data() + literal_start, pos - literal_start);
+        AppendVarint(length, output);
+        AppendVarint(pos - match, output);
+        pos += length;
+        literal_start = pos;
+    }
+    AppendVarint(input.size() - literal_start, output);
+    output->append(input.data() + literal_start, input.size() - literal_start);
+}
+
+bool Decompress(std::string_view input, size_t raw_size, std::string *output) {
+    output->resize(raw_size);
+    char *out = output->data();
+    size_t size = 0;
+    size_t pos = 0;
+    for (;;) {
+        uint64_t literals;
+        if (!ReadVarint(input, &pos, &literals)) return false;
+        if (literals > input.size() - pos || literals > raw_size - size) return false;
+        std::memcpy(out + size, input.data() + pos, literals);
+        pos += literals;
+        size += literals;
+        if (pos == input.size()) return size == raw_size;
+        uint64_t length, distance;
+        if (!ReadVarint(input, &pos, &length) || !ReadVarint(input, &pos, &distance)) return false;
+        if (distance == 0 || distance > size || length > raw_size - size) return false;
+        const char *from = out + size - distance;
+        if (distance >= length) {
+            std::memcpy(out + size, from, length);
+        } else {
+            for (size_t i = 0; i < length; i++) out[size + i] = from[i];
+        }
+        size += length;
+    }
+}
+
+}  // namespace corpus
+
+CorpusWriter::~CorpusWriter() {
+    if (!is_open()) return;
+    std::string error;
+    if (!Close(&error)) std::cerr << "corpus: " << error << std::endl;
+}
+
+bool CorpusWriter::Open(const std::string &path, std::string *error) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        *error = "cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    path_ = path;
+    error_.clear();
+    offset_ = 0;
+    block_.clear();
+    block_entries_.clear();
+    entries_.clear();
+    keys_.clear();
+    feature_ids_.clear();
+    // The header is written by Close, once the offsets are known
+    const corpus::Header header = {};
+    Write(&header, sizeof(header));
+    return error_.empty();
+}
+
+void CorpusWriter::Add(std::string_view feature, const std::vector<size_t> &dims, std::string_view sql) {
+    if (!is_open() || dims.size() > corpus::kMaxDims) return;
+    if (sql.size() > UINT32_MAX - block_.size()) FlushBlock();
+    if (sql.size() > UINT32_MAX) return;
+
+    auto it = feature_ids_.find(feature);
+    if (it == feature_ids_.end()) {
+        it = feature_ids_.emplace(std::string(feature), static_cast<uint32_t>(feature_ids_.size())).first;
+    }
+    corpus::Entry entry = {};
+    entry.feature = it->second;
+    entry.dims_count = static_cast<uint32_t>(dims.size());
+    std::copy(dims.begin(), dims.end(), entry.dims);
+    if (!keys_.emplace(entry.feature, dims).second) return;
+    entry.sql_offset = static_cast<uint32_t>(block_.size());
+    entry.sql_size = static_cast<uint32_t>(sql.size());
+    block_.append(sql);
+    block_entries_.push_back(entries_.size());
+    entries_.push_back(entry);
+    if (block_.size() >= corpus::kBlockSize) FlushBlock();
+}
+
+bool CorpusWriter::Close(std::string *error) {
+    if (!is_open()) {
+        *error = "corpus is not open";
+        return false;
+    }
+    FlushBlock();
+
+    // Names are written sorted, and the entries renumbered to match
+    std::vector<uint32_t> sorted_ids(feature_ids_.size());
+    corpus::Header header = {};
+    std::memcpy(header.magic, corpus::kMagic, sizeof(header.magic));
+    header.entry_count = entries_.size();
+    header.names_count = feature_ids_.size();
+    const uint64_t padding = 0;
+    Write(&padding, (8 - offset_ % 8) % 8);
+    header.names_offset = offset_;
+    uint64_t name_offset = offset_ + feature_ids_.size() * sizeof(corpus::Name);
+    uint32_t sorted_id = 0;
+    for (const auto &[name, id] : feature_ids_) {
+        const corpus::Name location = {name_offset, name.size()};
+        Write(&location, sizeof(location));
+        name_offset += name.size();
+        sorted_ids[id] = sorted_id++;
+    }
+    for (const auto &[name, id] : feature_ids_) {
+        Write(name.data(), name.size());
+    }
+
+    for (auto &entry : entries_) entry.feature = sorted_ids[entry.feature];
+    std::sort(entries_.begin(), entries_.end(), [](const corpus::Entry &a, const corpus::Entry &b) {
+        if (a.feature != b.feature) return a.feature < b.feature;
+        return std::lexicographical_compare(a.dims, a.dims + a.dims_count, b.dims, b.dims + b.dims_count);
+    });
+    Write(&padding, (8 - offset_ % 8) % 8);
+    header.index_offset = offset_;
+    Write(entries_.data(), entries_.size() * sizeof(corpus::Entry));
+
+    if (error_.empty() &&
+        (std::fseek(file_, 0, SEEK_SET) != 0 || std::fwrite(&header, sizeof(header), 1, file_) != 1)) {
+        error_ = "cannot write " + path_ + ": " + std::strerror(errno);
+    }
+    if (std::fclose(file_) != 0 && error_.empty()) {
+        error_ = "cannot write " + path_ + ": " + std::strerror(errno);
+    }
+    file_ = nullptr;
+    if (!error_.empty()) {
+        *error = error_;
+        return false;
+    }
+    return true;
+}
+
+void CorpusWriter::Write(const void *data, size_t size) {
+    if (size == 0 || !error_.empty()) return;
+    if (std::fwrite(data, size, 1, file_) != 1) {
+        error_ = "cannot write " + path_ + ": " + std::strerror(errno);
+        return;
+    }
+    offset_ += size;
+}
+
+void CorpusWriter::FlushBlock() {
+    if (block_.empty()) return;
+    compressed_.clear();
+    corpus::Compress(block_, &compressed_);
+    for (size_t i : block_entries_) {
+        entries_[i].block_offset = offset_;
+        entries_[i].block_size = static_cast<uint32_t>(compressed_.size());
+        entries_[i].block_raw_size = static_cast<uint32_t>(block_.size());
+    }
+    if (compressed_.size() > UINT32_MAX && error_.empty()) {
+        error_ = "block of " + std::to_string(block_.size()) + " bytes does not compress";
+    }
+    Write(compressed_.data(), compressed_.size());
+    block_.clear();
+    block_entries_.clear();
+}
+
+CorpusReader::~CorpusReader() {
+    if (data_ != nullptr) munmap(const_cast<char *>(data_), size_);
+}
+
+bool CorpusReader::Open(const std::string &path, std::string *error) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        *error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        *error = "cannot open " + path + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void *data = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED) {
+        *error = "cannot map " + path + (size > 0 ? std::string(": ") + std::strerror(errno) : ": empty file");
+        return false;
+    }
+    if (data_ != nullptr) munmap(const_cast<char *>(data_), size_);
+    data_ = static_cast<const char *>(data);
+    size_ = size;
+    names_ = nullptr;
+    entries_ = nullptr;
+    names_count_ = entry_count_ = 0;
+    block_offset_ = 0;
+
+    // Everything the lookups rely on is checked here, so that they need no checks of their own
+    auto fail = [&](const std::string &reason) {
+        *error = path + " is not a valid corpus: " + reason;
+        names_count_ = entry_count_ = 0;
+        return false;
+    };
+    auto in_file = [&](uint64_t offset, uint64_t count, uint64_t item_size) {
+        return offset <= size && count <= (size - offset) / item_size;
+    };
+    if (size < sizeof(corpus::Header)) return fail("too short");
+    corpus::Header header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, corpus::kMagic, sizeof(header.magic)) != 0) return fail("bad magic");
+    if (header.names_offset % 8 != 0 || !in_file(header.names_offset, header.names_count, sizeof(corpus::Name))) {
+        return fail("names out of range");
+    }
+    if (header.index_offset % 8 != 0 || !in_file(header.index_offset, header.entry_count, sizeof(corpus::Entry))) {
+        return fail("index out of range");
+    }
+    names_ = reinterpret_cast<const corpus::Name *>(data_ + header.names_offset);
+    entries_ = reinterpret_cast<const corpus::Entry *>(data_ + header.index_offset);
+    for (size_t id = 0; id < header.names_count; id++) {
+        if (!in_file(names_[id].offset, names_[id].size, 1)) return fail("name out of range");
+        if (id > 0 && !(name(id - 1) < name(id))) {
+            names_count_ = 0;
+            return fail("names not sorted");
+        }
+        names_count_ = id + 1;
+    }
+    for (size_t i = 0; i < header.entry_count; i++) {
+        const corpus::Entry &entry = entries_[i];
+        if (entry.feature >= names_count_ || entry.dims_count > corpus::kMaxDims) return fail("bad entry");
+        if (!in_file(entry.block_offset, entry.block_size, 1) || entry.block_offset < sizeof(corpus::Header) ||
+            entry.sql_offset > entry.block_raw_size || entry.sql_size > entry.block_raw_size - entry.sql_offset) {
+            return fail("statement out of range");
+        }
+    }
+    entry_count_ = header.entry_count;
+    return true;
+}
+
+std::vector<size_t> CorpusReader::dims(size_t i) const {
+    return std::vector<size_t>(entries_[i].dims, entries_[i].dims + entries_[i].dims_count);
+}
+
+size_t CorpusReader::Find(std::string_view feature, const std::vector<size_t> &dims) const {
+    const corpus::Name *name_end = names_ + names_count_;
+    const corpus::Name *found = std::partition_point(names_, name_end, [&](const corpus::Name &n) {
+        return std::string_view(data_ + n.offset, n.size) < feature;
+    });
+    if (found == name_end || name(found - names_) != feature) return kNotFound;
+
+    const uint32_t id = static_cast<uint32_t>(found - names_);
+    auto less = [&](const corpus::Entry &entry) {
+        if (entry.feature != id) return entry.feature < id;
+        return std::lexicographical_compare(entry.dims, entry.dims + entry.dims_count, dims.begin(), dims.end());
+    };
+    const corpus::Entry *end = entries_ + entry_count_;
+    const corpus::Entry *entry = std::partition_point(entries_, end, less);
+    if (entry == end || entry->feature != id ||
+        !std::equal(dims.begin(), dims.end(), entry->dims, entry->dims + entry->dims_count)) {
+        return kNotFound;
+    }
+    return entry - entries_;
+}
+
+bool CorpusReader::Read(size_t i, std::string_view *sql) {
+    const corpus::Entry &entry = entries_[i];
+    if (block_offset_ != entry.block_offset) {
+        block_offset_ = 0;
+        if (!corpus::Decompress(std::string_view(data_ + entry.block_offset, entry.block_size), entry.block_raw_size,
+                                &block_)) {
+            return false;
+        }
+        block_offset_ = entry.block_offset;
+    }
+    *sql = std::string_view(block_).substr(entry.sql_offset, entry.sql_size);
+    return true;
+}
+
+std::string_view CorpusReader::name(size_t id) const {
+    return std::string_view(data_ + names_[id].offset, names_[id].size);
+}
+
+}  // namespace tensile
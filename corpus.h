@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tensile {
+
+// Corpus of generated SQL, so that fuzzers and other engines can replay the probes of a driver
+// run without linking the generators. A corpus is one file of compressed blocks of statements,
+// followed by a table of feature names and an index of the statements sorted by feature and
+// size, which a reader maps into memory and binary searches:
+//
+//     header | block ... block | names | index
+//
+// Blocks hold about kBlockSize bytes of SQL each, compressed with a simple LZ77 which suits the
+// highly repetitive generated SQL. Integers are stored in the byte order of the host.
+namespace corpus {
+
+constexpr char kMagic[8] = {'T', 'N', 'S', 'C', 'R', 'P', 'S', '1'};
+constexpr size_t kBlockSize = 1 << 20;
+// Probes of features with more dimensions are not stored
+constexpr size_t kMaxDims = 4;
+
+struct Header {
+    char magic[8];
+    uint64_t entry_count;
+    uint64_t names_offset;
+    uint64_t names_count;
+    uint64_t index_offset;
+};
+
+// Location of a name in the file. Names are sorted, so that their ids follow their order.
+struct Name {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Index entry of a statement, sorted by (feature, dims)
+struct Entry {
+    uint32_t feature;
+    uint32_t dims_count;
+    uint64_t dims[kMaxDims];
+    uint64_t block_offset;
+    uint32_t block_size;
+    uint32_t block_raw_size;
+    uint32_t sql_offset;
+    uint32_t sql_size;
+};
+
+// Appends @input compressed to @output.
+void Compress(std::string_view input, std::string *output);
+
+// Replaces @output with @input decompressed, which must be @raw_size bytes. Returns false if
+// @input is not a valid compressed block of that size.
+bool Decompress(std::string_view input, size_t raw_size, std::string *output);
+
+}  // namespace corpus
+
+// Writes a corpus file. Statements are compressed and written block by block as they are added,
+// while the index is kept in memory until Close.
+class CorpusWriter {
+public:
+    CorpusWriter() {}
+    CorpusWriter(const CorpusWriter &) = delete;
+    CorpusWriter &operator=(const CorpusWriter &) = delete;
+
+    // Closes the file if still open, reporting a failure to stderr.
+    ~CorpusWriter();
+
+    // Creates the corpus at @path. Returns false with the reason in @error on failure.
+    bool Open(const std::string &path, std::string *error);
+
+    // Adds @sql of @feature with sizes @dims. A probe already in the corpus is skipped, since
+    // the same feature and sizes generate the same SQL.
+    void Add(std::string_view feature, const std::vector<size_t> &dims, std::string_view sql);
+
+    // Writes the last block and the index, and closes the file. Returns false with the reason
+    // in @error if anything failed since Open.
+    bool Close(std::string *error);
+
+    bool is_open() const { return file_ != nullptr; }
+
+    // Number of statements added
+    size_t size() const { return entries_.size(); }
+
+private:
+    void Write(const void *data, size_t size);
+    void FlushBlock();
+
+    std::FILE *file_ = nullptr;
+    std::string path_;
+    std::string error_;
+    uint64_t offset_ = 0;
+    // Statements of the block being filled, and the entries pointing into it
+    std::string block_;
+    std::vector<size_t> block_entries_;
+    std::string compressed_;
+    // Entries with feature ids in the order names were first seen, and those ids
+    std::vector<corpus::Entry> entries_;
+    std::map<std::string, uint32_t, std::less<>> feature_ids_;
+    std::set<std::pair<uint32_t, std::vector<size_t>>> keys_;
+};
+
+// Reads a corpus file mapped into memory. Lookups are binary searches of the mapped index, and
+// only the block holding the statement is decompressed.
+class CorpusReader {
+public:
+    // Returned by Find for a probe not in the corpus
+    static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+    CorpusReader() {}
+    CorpusReader(const CorpusReader &) = delete;
+    CorpusReader &operator=(const CorpusReader &) = delete;
+    ~CorpusReader();
+
+    // Maps the corpus at @path and checks its index. Returns false with the reason in @error if
+    // the file cannot be read or is not a valid corpus.
+    bool Open(const std::string &path, std::string *error);
+
+    // Number of statements, which are numbered in the order of the index
+    size_t size() const { return entry_count_; }
+
+    // Feature and sizes of statement @i
+    std::string_view feature(size_t i) const { return name(entries_[i].feature); }
+    std::vector<size_t> dims(size_t i) const;
+
+    // Number of the statement of @feature with sizes @dims, or kNotFound.
+    size_t Find(std::string_view feature, const std::vector<size_t> &dims) const;
+
+    // Sets @sql to statement @i. The view stays valid until the next call to Read or until the
+    // reader is destroyed. Returns false if the block of the statement is corrupt.
+    bool Read(size_t i, std::string_view *sql);
+
+private:
+    std::string_view name(size_t id) const;
+
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    const corpus::Name *names_ = nullptr;
+    size_t names_count_ = 0;
+    const corpus::Entry *entries_ = nullptr;
+    size_t entry_count_ = 0;
+    // Last block decompressed, since replay reads statements of the same block in a row
+    uint64_t block_offset_ = 0;
+    std::string block_;
+};
+
+}  // namespace tensile
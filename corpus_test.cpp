@@ -0,0 +1,124 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include "corpus.h"
+#include "reference_parser.h"
+
+#include <fstream>
+#include <random>
+
+namespace tensile {
+namespace {
+
+std::string Path(const std::string &name) { return testing::TempDir() + name; }
+
+TEST(Corpus, Compression) {
+    std::mt19937 random(3);
+    const std::string alphabet = "(sel ct)1";
+    for (size_t size : {0, 1, 3, 4, 5, 100, 10000}) {
+        std::string input(size, ' ');
+        for (char &c : input) c = alphabet[random() % alphabet.size()];
+        std::string compressed, output;
+        corpus::Compress(input, &compressed);
+        ASSERT_TRUE(corpus::Decompress(compressed, input.size(), &output));
+        EXPECT_EQ(input, output);
+        EXPECT_FALSE(corpus::Decompress(compressed, input.size() + 1, &output));
+    }
+    // Repeated units take a single overlapping match
+    std::string input = "select " + std::string(1000000, '(') + "1" + std::string(1000000, ')');
+    std::string compressed, output;
+    corpus::Compress(input, &compressed);
+    EXPECT_LT(compressed.size(), 100);
+    ASSERT_TRUE(corpus::Decompress(compressed, input.size(), &output));
+    EXPECT_EQ(input, output);
+}
+
+TEST(Corpus, WriteAndRead) {
+    const std::string path = Path("corpus_write_and_read");
+    CorpusWriter writer;
+    std::string error;
+    ASSERT_TRUE(writer.Open(path, &error)) << error;
+    // Features out of name order, statements spanning several blocks
+    std::map<std::pair<std::string, std::vector<size_t>>, std::string> expected;
+    for (size_t n = 1; n <= 1 << 20; n *= 2) {
+        const std::string sql = "select " + std::string(n, '(') + "1" + std::string(n, ')');
+        writer.Add("parenthesis", {n}, sql);
+        expected[{"parenthesis", {n}}] = sql;
+        writer.Add("join", {n, 3}, "join " + std::to_string(n));
+        expected[{"join", {n, 3}}] = "join " + std::to_string(n);
+    }
+    writer.Add("parenthesis", {1}, "duplicate");
+    EXPECT_EQ(expected.size(), writer.size());
+    ASSERT_TRUE(writer.Close(&error)) << error;
+
+    CorpusReader reader;
+    ASSERT_TRUE(reader.Open(path, &error)) << error;
+    ASSERT_EQ(expected.size(), reader.size());
+    size_t i = 0;
+    for (const auto &[key, sql] : expected) {
+        // Index is sorted by feature and sizes
+        EXPECT_EQ(key.first, reader.feature(i));
+        EXPECT_EQ(key.second, reader.dims(i));
+        EXPECT_EQ(i, reader.Find(key.first, key.second));
+        std::string_view actual;
+        ASSERT_TRUE(reader.Read(i, &actual));
+        EXPECT_EQ(sql, actual);
+        i++;
+    }
+    EXPECT_EQ(CorpusReader::kNotFound, reader.Find("parenthesis", {3}));
+    EXPECT_EQ(CorpusReader::kNotFound, reader.Find("join", {1}));
+    EXPECT_EQ(CorpusReader::kNotFound, reader.Find("joins", {1, 3}));
+    EXPECT_EQ(CorpusReader::kNotFound, reader.Find("", {}));
+}
+
+TEST(Corpus, Invalid) {
+    CorpusReader reader;
+    std::string error;
+    EXPECT_FALSE(reader.Open(Path("corpus_missing"), &error));
+    EXPECT_THAT(error, testing::HasSubstr("cannot open"));
+
+    const std::string path = Path("corpus_invalid");
+    CorpusWriter writer;
+    ASSERT_TRUE(writer.Open(path, &error)) << error;
+    writer.Add("feature", {1}, "select 1");
+    ASSERT_TRUE(writer.Close(&error)) << error;
+    std::string contents;
+    {
+        std::ifstream file(path, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), {});
+    }
+    for (size_t size : {size_t(0), size_t(20), contents.size() - 1}) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << contents.substr(0, size);
+        EXPECT_FALSE(reader.Open(path, &error)) << size;
+    }
+    contents[0] = 'X';
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    EXPECT_FALSE(reader.Open(path, &error));
+    EXPECT_THAT(error, testing::HasSubstr("bad magic"));
+}
+
+TEST(Corpus, DriverExport) {
+    const std::string path = Path("corpus_driver_export");
+    {
+        const std::string flag = "--export_corpus=" + path;
+        const char *argv[] = {"test", flag.c_str(), "--features=parenthesis", "--no_explore_beyond", nullptr};
+        Driver driver(4, const_cast<char **>(argv));
+        ASSERT_NE(nullptr, driver.corpus_writer());
+        ReferenceParser::Limits limits;
+        limits.max_depth = 40;
+        driver.AddProvider(std::make_unique<ReferenceParser>(limits));
+        driver.Run();
+    }
+    CorpusReader reader;
+    std::string error;
+    ASSERT_TRUE(reader.Open(path, &error)) << error;
+    // Doubling up to 64 and bisecting down to 38
+    EXPECT_EQ(12, reader.size());
+    const size_t i = reader.Find("parenthesis", {38});
+    ASSERT_NE(CorpusReader::kNotFound, i);
+    std::string_view sql;
+    ASSERT_TRUE(reader.Read(i, &sql));
+    EXPECT_EQ("select " + std::string(38, '(') + "1" + std::string(38, ')'), sql);
+}
+
+}  // namespace
+}  // namespace tensile
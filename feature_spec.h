@@ -0,0 +1,300 @@
+#pragma once
+
+#include "sql_builder.h"
+#include "tensile.h"
+
+#include <stdexcept>
+#include <string_view>
+
+namespace tensile {
+
+// Declarative description of a feature made of repeated units, laid out as described for
+// IncrementalSQLFeature:
+//
+//     prefix + unit(0) + separator + unit(1) + ... + middle + close(n-1) + ... + close(0) + suffix
+//
+// A unit or closing unit can refer to its index as {i}, or to a neighbouring index as {i+K} or
+// {i-K}; any other '{' is literal text. first_unit / first_close replace unit 0 when the
+// innermost (or leftmost) unit differs from the others. Specs are constexpr, so a malformed
+// placeholder is a compile error, and SpecFeature turns each one into its own generator:
+//
+//     constexpr auto kArray = FeatureSpec("array").Prefix("select array [").Unit("1").Separator(",").Suffix("]");
+//     features.emplace_back(std::make_unique<SpecFeature<kArray>>());
+class FeatureSpec {
+public:
+    struct ExampleSQL {
+        size_t n = 0;
+        std::string_view sql;
+    };
+    static constexpr size_t kMaxExamples = 3;
+
+    constexpr explicit FeatureSpec(std::string_view name) : name_(name) {}
+
+    constexpr FeatureSpec Prefix(std::string_view v) const { auto s = *this; s.prefix_ = v; return s; }
+    constexpr FeatureSpec Unit(std::string_view v) const { auto s = *this; s.unit_ = v; return s; }
+    constexpr FeatureSpec FirstUnit(std::string_view v) const {
+        auto s = *this;
+        s.first_unit_ = v;
+        s.has_first_unit_ = true;
+        return s;
+    }
+    constexpr FeatureSpec Separator(std::string_view v) const { auto s = *this; s.separator_ = v; return s; }
+    constexpr FeatureSpec Middle(std::string_view v) const { auto s = *this; s.middle_ = v; return s; }
+    constexpr FeatureSpec Close(std::string_view v) const { auto s = *this; s.close_ = v; return s; }
+    constexpr FeatureSpec FirstClose(std::string_view v) const {
+        auto s = *this;
+        s.first_close_ = v;
+        s.has_first_close_ = true;
+        return s;
+    }
+    constexpr FeatureSpec Suffix(std::string_view v) const { auto s = *this; s.suffix_ = v; return s; }
+    constexpr FeatureSpec Exponential() const { auto s = *this; s.exponential_ = true; return s; }
+    // Fragment form, see ISQLFeature::fragment_kind() and ISQLFeature::hole().
+    constexpr FeatureSpec Fragment(FragmentKind kind) const { auto s = *this; s.fragment_kind_ = kind; return s; }
+    constexpr FeatureSpec Hole(FragmentKind kind, std::string_view token) const {
+        auto s = *this;
+        s.hole_kind_ = kind;
+        s.hole_token_ = token;
+        return s;
+    }
+
+    // Expected SQL for @n, checked by SelfTest.
+    constexpr FeatureSpec Example(size_t n, std::string_view sql) const {
+        auto s = *this;
+        if (s.num_examples_ == kMaxExamples) throw std::length_error("too many examples");
+        s.examples_[s.num_examples_++] = {n, sql};
+        return s;
+    }
+
+    constexpr std::string_view name() const { return name_; }
+    constexpr std::string_view prefix() const { return prefix_; }
+    constexpr std::string_view unit() const { return unit_; }
+    constexpr bool has_first_unit() const { return has_first_unit_; }
+    constexpr std::string_view first_unit() const { return first_unit_; }
+    constexpr std::string_view separator() const { return separator_; }
+    constexpr std::string_view middle() const { return middle_; }
+    constexpr std::string_view close() const { return close_; }
+    constexpr bool has_first_close() const { return has_first_close_; }
+    constexpr std::string_view first_close() const { return first_close_; }
+    constexpr std::string_view suffix() const { return suffix_; }
+    constexpr bool exponential() const { return exponential_; }
+    constexpr FragmentKind fragment_kind() const { return fragment_kind_; }
+    constexpr FragmentKind hole_kind() const { return hole_kind_; }
+    constexpr std::string_view hole_token() const { return hole_token_; }
+    constexpr size_t num_examples() const { return num_examples_; }
+    constexpr const ExampleSQL &example(size_t i) const { return examples_[i]; }
+
+private:
+    std::string_view name_;
+    std::string_view prefix_;
+    std::string_view unit_;
+    std::string_view first_unit_;
+    std::string_view separator_;
+    std::string_view middle_;
+    std::string_view close_;
+    std::string_view first_close_;
+    std::string_view suffix_;
+    bool has_first_unit_ = false;
+    bool has_first_close_ = false;
+    bool exponential_ = false;
+    FragmentKind fragment_kind_ = FragmentKind::NONE;
+    FragmentKind hole_kind_ = FragmentKind::NONE;
+    std::string_view hole_token_;
+    size_t num_examples_ = 0;
+    ExampleSQL examples_[kMaxExamples] = {};
+};
+
+namespace spec_internal {
+
+// A unit split at its {i} placeholders: text[0] {i+offset[0]} text[1] ... text[fields].
+struct UnitTemplate {
+    static constexpr size_t kMaxFields = 4;
+    std::string_view text[kMaxFields + 1] = {};
+    long offset[kMaxFields] = {};
+    size_t fields = 0;
+    // Bytes of literal text per unit
+    size_t text_size = 0;
+
+    // Bytes taken by units [@begin, @end), without separators.
+    constexpr size_t Size(size_t begin, size_t end) const {
+        size_t size = (end - begin) * text_size;
+        for (size_t k = 0; k < fields; k++) {
+            size += SqlBuilder::DigitsInRange(begin + offset[k], end + offset[k]);
+        }
+        return size;
+    }
+
+    char *Write(size_t i, char *p) const {
+        for (size_t k = 0; k < fields; k++) {
+            p = SqlBuilder::PutNumber(SqlBuilder::Put(p, text[k]), i + offset[k]);
+        }
+        return SqlBuilder::Put(p, text[fields]);
+    }
+};
+
+constexpr UnitTemplate ParseUnit(std::string_view unit) {
+    UnitTemplate t;
+    size_t start = 0;
+    for (size_t pos = 0; pos < unit.size(); pos++) {
+        if (unit[pos] != '{' || pos + 2 >= unit.size() || unit[pos + 1] != 'i') continue;
+        size_t end = pos + 2;
+        long offset = 0;
+        if (unit[end] == '+' || unit[end] == '-') {
+            long sign = unit[end] == '+' ? 1 : -1;
+            size_t digits = ++end;
+            while (end < unit.size() && unit[end] >= '0' && unit[end] <= '9') {
+                offset = offset * 10 + (unit[end++] - '0');
+            }
+            if (end == digits) throw std::invalid_argument("expected a number after {i+ or {i-");
+            offset *= sign;
+        }
+        if (end >= unit.size() || unit[end] != '}') throw std::invalid_argument("unterminated {i} placeholder");
+        if (t.fields == UnitTemplate::kMaxFields) throw std::length_error("too many {i} placeholders");
+        t.text[t.fields] = unit.substr(start, pos - start);
+        t.offset[t.fields++] = offset;
+        start = end + 1;
+        pos = end;
+    }
+    t.text[t.fields] = unit.substr(start);
+    for (size_t k = 0; k <= t.fields; k++) {
+        t.text_size += t.text[k].size();
+    }
+    return t;
+}
+
+}  // namespace spec_internal
+
+// Feature generated from FeatureSpec @kSpec. The layout is known at compile time, so sizes of
+// any run of units are computed exactly without generating them, and runs of identical units
+// are produced by repeated memcpy.
+template <const FeatureSpec &kSpec>
+class SpecFeature : public IncrementalSQLFeature {
+public:
+    std::string name() override { return std::string(kSpec.name()); }
+
+    bool is_exponential() const override { return kSpec.exponential(); }
+
+    FragmentKind fragment_kind() const override { return kSpec.fragment_kind(); }
+
+    tensile::Hole hole() const override { return {kSpec.hole_kind(), kSpec.hole_token()}; }
+
+    void SelfTest(ITestComparer *cmp) override {
+        for (size_t i = 0; i < kSpec.num_examples(); i++) {
+            cmp->ExpectEq(kSpec.example(i).sql, GenerateSQL(kSpec.example(i).n));
+        }
+    }
+
+    // Exact size of the SQL for @n.
+    static constexpr size_t Size(size_t n) {
+        return kSpec.prefix().size() + OpensSize(0, n) + kSpec.middle().size() + ClosesSize(0, n) +
+               kSpec.suffix().size();
+    }
+
+protected:
+    void AppendHead(SqlBuilder *sql) override { sql->Append(kSpec.prefix()); }
+    void AppendOpen(size_t i, SqlBuilder *sql) override { AppendOpens(i, i + 1, sql); }
+    void AppendMiddle(SqlBuilder *sql) override { sql->Append(kSpec.middle()); }
+    void AppendClose(size_t i, SqlBuilder *sql) override { AppendCloses(i, i + 1, sql); }
+    void AppendTail(SqlBuilder *sql) override { sql->Append(kSpec.suffix()); }
+
+    bool UnitSizes(size_t begin, size_t end, size_t *opens, size_t *closes) override {
+        *opens = OpensSize(begin, end);
+        *closes = ClosesSize(begin, end);
+        return true;
+    }
+
+    void AppendOpens(size_t begin, size_t end, SqlBuilder *sql) override {
+        const size_t size = OpensSize(begin, end);
+        if (size == 0) return;
+        char *p = sql->Extend(size);
+        if (begin == 0) {
+            p = WriteFirst(kOpen, kSpec.has_first_unit(), kSpec.first_unit(), p);
+            begin = 1;
+        }
+        // Unit i starts OpensSize(begin, i) bytes after unit @begin, so slices can be written
+        // independently.
+        SqlBuilder::ParallelFill(begin, end, FillThreads(size), [p, begin](size_t b, size_t e) {
+            WriteOpens(b, e, p + OpensSize(begin, b));
+        });
+    }
+
+    void AppendCloses(size_t begin, size_t end, SqlBuilder *sql) override {
+        const size_t size = ClosesSize(begin, end);
+        if (size == 0) return;
+        char *p = sql->Extend(size);
+        const size_t first = begin == 0 ? 1 : begin;
+        // Closing units go in descending order, so unit i - 1 starts ClosesSize(i, @end) bytes in.
+        SqlBuilder::ParallelFill(first, end, FillThreads(size), [p, end](size_t b, size_t e) {
+            WriteCloses(b, e, p + ClosesSize(e, end));
+        });
+        if (begin == 0) {
+            WriteFirst(kClose, kSpec.has_first_close(), kSpec.first_close(), p + ClosesSize(1, end));
+        }
+    }
+
+private:
+    // Bytes each thread fills at least, below which starting a thread costs more than it saves.
+    static constexpr size_t kMinFillPerThread = 256 * 1024;
+
+    static constexpr spec_internal::UnitTemplate kOpen = spec_internal::ParseUnit(kSpec.unit());
+    static constexpr spec_internal::UnitTemplate kClose = spec_internal::ParseUnit(kSpec.close());
+
+    static constexpr size_t OpensSize(size_t begin, size_t end) {
+        if (begin == end) return 0;
+        size_t size = 0;
+        if (begin == 0) {
+            size += kSpec.has_first_unit() ? kSpec.first_unit().size() : kOpen.Size(0, 1);
+            begin = 1;
+        }
+        return size + (end - begin) * kSpec.separator().size() + kOpen.Size(begin, end);
+    }
+
+    static constexpr size_t ClosesSize(size_t begin, size_t end) {
+        if (begin == end) return 0;
+        size_t size = 0;
+        if (begin == 0) {
+            size += kSpec.has_first_close() ? kSpec.first_close().size() : kClose.Size(0, 1);
+            begin = 1;
+        }
+        return size + kClose.Size(begin, end);
+    }
+
+    size_t FillThreads(size_t size) const {
+        const size_t threads = size / kMinFillPerThread;
+        return threads < generation_threads_ ? threads : generation_threads_;
+    }
+
+    // Writes opening units [@begin, @end) to @p, @begin > 0.
+    static void WriteOpens(size_t begin, size_t end, char *p) {
+        if (begin == end) return;
+        constexpr std::string_view sep = kSpec.separator();
+        if (kOpen.fields == 0) {
+            SqlBuilder::Put(SqlBuilder::Put(p, sep), kOpen.text[0]);
+            SqlBuilder::FillRepeated(p, sep.size() + kOpen.text_size, (end - begin) * (sep.size() + kOpen.text_size));
+            return;
+        }
+        for (size_t i = begin; i < end; i++) {
+            p = kOpen.Write(i, SqlBuilder::Put(p, sep));
+        }
+    }
+
+    // Writes closing units [@begin, @end) to @p in descending order, @begin > 0.
+    static void WriteCloses(size_t begin, size_t end, char *p) {
+        if (begin == end) return;
+        if (kClose.fields == 0) {
+            SqlBuilder::Put(p, kClose.text[0]);
+            SqlBuilder::FillRepeated(p, kClose.text_size, (end - begin) * kClose.text_size);
+            return;
+        }
+        for (size_t i = end; i-- > begin;) {
+            p = kClose.Write(i, p);
+        }
+    }
+
+    static char *WriteFirst(const spec_internal::UnitTemplate &unit, bool has_first, std::string_view first,
+                            char *p) {
+        return has_first ? SqlBuilder::Put(p, first) : unit.Write(0, p);
+    }
+};
+
+}  // namespace tensile
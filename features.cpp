@@ -1,57 +1,157 @@
 #include "tensile.h"
+#include "composition.h"
+#include "feature_spec.h"
+#include "sql_builder.h"
+#include "sql_lexer.h"
 
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 #include <string_view>
-#include <iostream>
-#include <iomanip>
 
 namespace tensile {
 
-class Comment : public ISQLFeature {
-public:
-    std::string name() override { return "comment"; }
+bool ISQLFeature::ValidateSQL(size_t n, std::string *reason) {
+    auto sql = GenerateSQL(n);
+    const size_t offset = FindUnbalanced(sql, reason);
+    if (offset != std::string_view::npos) {
+        *reason += " at offset " + std::to_string(offset);
+        return false;
+    }
+    // Extract the first keyword (up to first whitespace or end-of-string)
+    auto first_space = sql.find_first_of(" \t\n\r");
+    auto first_word = (first_space == std::string_view::npos) ? sql : sql.substr(0, first_space);
+    if (first_word != "select" && first_word != "SELECT" &&
+        first_word != "with"  && first_word != "WITH"  &&
+        first_word != "create" && first_word != "CREATE") {
+        *reason = "stmt must start with SELECT, WITH, or CREATE";
+        return false;
+    }
+    return true;
+}
 
-    std::string GenerateSQL(size_t n) override {
-        return "select /*" + std::string(n, '.') + "*/ 1";
+std::string_view IncrementalSQLFeature::GenerateSQL(size_t n) {
+    if (!built_) {
+        Reset();
     }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select /*...*/ 1", GenerateSQL(3));
+    if (n < n_) {
+        Shrink(n);
     }
-};
+    if (n > n_) {
+        Grow(n);
+    }
+    return sql_;
+}
 
-class Identifier : public ISQLFeature {
-public:
-    std::string name() override { return "identifier"; }
+void IncrementalSQLFeature::Reset() {
+    SqlBuilder sql(&sql_);
+    AppendHead(&sql.Clear());
+    open_end_ = sql_.size();
+    AppendMiddle(&sql);
+    middle_size_ = sql_.size() - open_end_;
+    AppendTail(&sql);
+    open_marks_.assign(1, open_end_);
+    close_marks_.assign(1, sql_.size() - open_end_ - middle_size_);
+    n_ = 0;
+    built_ = true;
+}
 
-    std::string GenerateSQL(size_t n) override {
-        return "select 1 as " + std::string(n, 'x');
+void IncrementalSQLFeature::Grow(size_t n) {
+    const size_t first_mark = n_ / kMarkStride + 1;
+    const size_t last_mark = n / kMarkStride;
+    const size_t close_size = sql_.size() - open_end_ - middle_size_;
+    SqlBuilder opens(&opens_);
+    SqlBuilder closes(&closes_);
+    opens.Clear();
+    closes.Clear();
+
+    size_t opens_size, closes_size;
+    if (UnitSizes(n_, n, &opens_size, &closes_size)) {
+        // Sizes are known up front: stage all units in one go and compute the marks.
+        AppendOpens(n_, n, &opens.Reserve(opens_size));
+        AppendCloses(n_, n, &closes.Reserve(closes_size));
+        for (size_t j = first_mark; j <= last_mark; j++) {
+            UnitSizes(n_, j * kMarkStride, &opens_size, &closes_size);
+            open_marks_.push_back(open_end_ + opens_size);
+            close_marks_.push_back(close_size + closes_size);
+        }
+    } else {
+        // Stage opening units in ascending order, stopping at every mark to record it.
+        size_t begin = n_;
+        for (size_t j = first_mark; j <= last_mark; j++) {
+            AppendOpens(begin, j * kMarkStride, &opens);
+            open_marks_.push_back(open_end_ + opens_.size());
+            begin = j * kMarkStride;
+        }
+        AppendOpens(begin, n, &opens);
+
+        // Stage closing units in descending order. A mark is the suffix size at that unit count,
+        // which is only known once all new closing units are staged, so first record how much
+        // was staged above each mark and convert it afterwards.
+        const size_t marks_before = close_marks_.size();
+        size_t end = n;
+        for (size_t j = last_mark; j >= first_mark; j--) {
+            AppendCloses(j * kMarkStride, end, &closes);
+            close_marks_.push_back(closes_.size());
+            end = j * kMarkStride;
+        }
+        AppendCloses(n_, end, &closes);
+        std::reverse(close_marks_.begin() + marks_before, close_marks_.end());
+        for (size_t j = marks_before; j < close_marks_.size(); j++) {
+            close_marks_[j] = close_size + closes_.size() - close_marks_[j];
+        }
     }
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 as xxx", GenerateSQL(3));
-    }
-};
+    // Open a gap for each part and move the middle and the old suffix out of the way.
+    const size_t old_size = sql_.size();
+    const size_t close_begin = open_end_ + middle_size_;
+    const size_t a = opens_.size();
+    const size_t b = closes_.size();
+    sql_.resize(old_size + a + b);
+    char *p = &sql_[0];
+    memmove(p + close_begin + a + b, p + close_begin, old_size - close_begin);
+    memcpy(p + close_begin + a, closes_.data(), b);
+    memmove(p + open_end_ + a, p + open_end_, middle_size_);
+    memcpy(p + open_end_, opens_.data(), a);
+    open_end_ += a;
+    n_ = n;
+}
 
-class Parenthesis : public ISQLFeature {
-public:
-    std::string name() override { return "parenthesis"; }
+void IncrementalSQLFeature::Shrink(size_t n) {
+    // Cut back to the closest mark at or below @n; Grow() adds the remaining units.
+    const size_t j = n / kMarkStride;
+    const size_t new_open_end = open_marks_[j];
+    const size_t new_close_size = close_marks_[j];
+    char *p = &sql_[0];
+    memmove(p + new_open_end, p + open_end_, middle_size_);
+    memmove(p + new_open_end + middle_size_, p + sql_.size() - new_close_size, new_close_size);
+    sql_.resize(new_open_end + middle_size_ + new_close_size);
+    open_end_ = new_open_end;
+    open_marks_.resize(j + 1);
+    close_marks_.resize(j + 1);
+    n_ = j * kMarkStride;
+}
 
-    std::string GenerateSQL(size_t n) override {
-        return "select " + std::string(n, '(') + "1" + std::string(n, ')');
-    }
+// Room for the fixed text around the repeated units, reserved by hand-written features
+// together with the exact size of the units.
+constexpr size_t kFixedSize = 128;
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select (((1)))", GenerateSQL(3));
-    }
-};
+constexpr auto kComment = FeatureSpec("comment").Prefix("select /*").Unit(".").Suffix("*/ 1")
+        .Example(3, "select /*...*/ 1");
+
+constexpr auto kIdentifier = FeatureSpec("identifier").Prefix("select 1 as ").Unit("x")
+        .Example(3, "select 1 as xxx");
+
+constexpr auto kParenthesis = FeatureSpec("parenthesis").Prefix("select ").Unit("(").Middle("1").Close(")")
+        .Fragment(FragmentKind::EXPRESSION).Hole(FragmentKind::EXPRESSION, "1")
+        .Example(3, "select (((1)))");
 
 class PositiveIntegerLiteral : public ISQLFeature {
 public:
     std::string name() override { return "positive integer"; }
 
-    std::string GenerateSQL(size_t n) override {
-        return "select " + std::to_string(n);
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select ").AppendNumber(n);
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -63,8 +163,9 @@ class NegativeIntegerLiteral : public ISQLFeature {
 public:
     std::string name() override { return "negative integer"; }
 
-    std::string GenerateSQL(size_t n) override {
-        return "select -" + std::to_string(n);
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select -").AppendNumber(n);
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -72,25 +173,16 @@ public:
     }
 };
 
-class NumericLiteral : public ISQLFeature {
-public:
-    std::string name() override { return "numeric literal"; }
-
-    std::string GenerateSQL(size_t n) override {
-        return "select numeric '" + std::string(n, '9') + "'";
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select numeric '9999'", GenerateSQL(4));
-    }
-};
+constexpr auto kNumericLiteral = FeatureSpec("numeric literal").Prefix("select numeric '").Unit("9").Suffix("'")
+        .Example(4, "select numeric '9999'");
 
 class NumericPrecision : public ISQLFeature {
 public:
     std::string name() override { return "numeric precision"; }
 
-    std::string GenerateSQL(size_t n) override {
-        return "select numeric(" + std::to_string(n) + ",0) '1'";
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select numeric(").AppendNumber(n).Append(",0) '1'");
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -102,8 +194,9 @@ class FloatLiteral : public ISQLFeature {
 public:
     std::string name() override { return "floating point literal"; }
 
-    std::string GenerateSQL(size_t n) override {
-        return "select " + std::to_string(n) + ".0";
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select ").AppendNumber(n).Append(".0");
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -115,8 +208,9 @@ class FloatPositiveExp : public ISQLFeature {
 public:
     std::string name() override { return "float positive exponent"; }
 
-    std::string GenerateSQL(size_t n) override {
-        return "select 1E" + std::to_string(n);
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select 1E").AppendNumber(n);
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -128,8 +222,9 @@ class FloatNegativeExp : public ISQLFeature {
 public:
     std::string name() override { return "float negative exponent"; }
 
-    std::string GenerateSQL(size_t n) override {
-        return "select 1E-" + std::to_string(n);
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select 1E-").AppendNumber(n);
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -137,45 +232,19 @@ public:
     }
 };
 
-class TextLiteral : public ISQLFeature {
-public:
-    std::string name() override { return "text literal"; }
-
-    std::string GenerateSQL(size_t n) override {
-        return "select '" + std::string(n, 'x') + "'";
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 'xxxxx'", GenerateSQL(5));
-    }
-};
-
-class ByteaLiteral : public ISQLFeature {
-public:
-    std::string name() override { return "bytea literal"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select bytea '";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("\\001");
-        }
-        sql_.append("'");
-        return sql_;
-    }
+constexpr auto kTextLiteral = FeatureSpec("text literal").Prefix("select '").Unit("x").Suffix("'")
+        .Example(5, "select 'xxxxx'");
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select bytea '\\001\\001\\001\\001\\001'", GenerateSQL(5));
-    }
-};
+constexpr auto kByteaLiteral = FeatureSpec("bytea literal").Prefix("select bytea '").Unit("\\001").Suffix("'")
+        .Example(5, "select bytea '\\001\\001\\001\\001\\001'");
 
 class FutureDateLiteral : public ISQLFeature {
 public:
     std::string name() override { return "future date literal"; }
 
-    std::string GenerateSQL(size_t n) override {
-        std::stringstream ss;
-        ss << std::setw(4) << std::setfill('0') << n;
-        return "select date '" + ss.str() + "-12-31'";
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select date '").AppendNumber(n, 4).Append("-12-31'");
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -187,10 +256,9 @@ class PastDateLiteral : public ISQLFeature {
 public:
     std::string name() override { return "past date literal"; }
 
-    std::string GenerateSQL(size_t n) override {
-        std::stringstream ss;
-        ss << std::setw(4) << std::setfill('0') << n;
-        return "select date '" + ss.str() + "-01-01 BC'";
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select date '").AppendNumber(n, 4).Append("-01-01 BC'");
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -202,10 +270,9 @@ class FutureTimestampLiteral : public ISQLFeature {
 public:
     std::string name() override { return "future timestamp literal"; }
 
-    std::string GenerateSQL(size_t n) override {
-        std::stringstream ss;
-        ss << std::setw(4) << std::setfill('0') << n;
-        return "select timestamp '" + ss.str() + "-12-31 23:59:59.999999'";
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select timestamp '").AppendNumber(n, 4).Append("-12-31 23:59:59.999999'");
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -217,154 +284,57 @@ class PastTimestampLiteral : public ISQLFeature {
 public:
     std::string name() override { return "past timestamp literal"; }
 
-    std::string GenerateSQL(size_t n) override {
-        std::stringstream ss;
-        ss << std::setw(4) << std::setfill('0') << n;
-        return "select timestamp '" + ss.str() + "-01-01 BC 00:00:00'";
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select timestamp '0042-01-01 BC 00:00:00'", GenerateSQL(42));
-    }
-};
-
-class Array : public ISQLFeature {
-public:
-    std::string name() override { return "array"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select array [1";
-        for (size_t i = 0; i < n - 1; i++) {
-            sql_.append(",1");
-        }
-        sql_.append("]");
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select timestamp '").AppendNumber(n, 4).Append("-01-01 BC 00:00:00'");
         return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select array [1,1]", GenerateSQL(2));
+        cmp->ExpectEq("select timestamp '0042-01-01 BC 00:00:00'", GenerateSQL(42));
     }
 };
 
-class NestedArray : public ISQLFeature {
-public:
-    std::string name() override { return "nested array"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++)
-            sql_.append("array [");
-        sql_.append("1");
-        sql_.append(n, ']');
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select array [1]", GenerateSQL(1));
-        cmp->ExpectEq("select array [array [array [array [array [1]]]]]", GenerateSQL(5));
-    }
-};
+constexpr auto kArray = FeatureSpec("array").Prefix("select array [").Unit("1").Separator(",").Suffix("]")
+        .Example(2, "select array [1,1]");
 
-class NestedStruct : public ISQLFeature {
-public:
-    std::string name() override { return "nested struct"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++)
-            sql_.append("{'x':");
-        sql_.append("1");
-        sql_.append(n, '}');
-        return sql_;
-    }
+constexpr auto kNestedArray = FeatureSpec("nested array").Prefix("select ").Unit("array [").Middle("1").Close("]")
+        .Example(1, "select array [1]")
+        .Example(5, "select array [array [array [array [array [1]]]]]");
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select {'x':1}", GenerateSQL(1));
-        cmp->ExpectEq("select {'x':{'x':{'x':{'x':{'x':1}}}}}", GenerateSQL(5));
-    }
-};
+constexpr auto kNestedStruct = FeatureSpec("nested struct").Prefix("select ").Unit("{'x':").Middle("1").Close("}")
+        .Example(1, "select {'x':1}")
+        .Example(5, "select {'x':{'x':{'x':{'x':{'x':1}}}}}");
 
-class MixedStructArray : public ISQLFeature {
+class MixedStructArray : public IncrementalSQLFeature {
 public:
     std::string name() override { return "mixed struct/array"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++) sql_.append((i % 2 == 0) ? "{'x':" : "[");
-        sql_.append("1");
-        for (size_t i = n; i-- > 0;) sql_.append((i % 2 == 0) ? "}" : "]");
-        return sql_;
-    }
+protected:
+    void AppendHead(SqlBuilder *sql) override { sql->Append("select "); }
+    void AppendOpen(size_t i, SqlBuilder *sql) override { sql->Append((i % 2 == 0) ? "{'x':" : "["); }
+    void AppendMiddle(SqlBuilder *sql) override { sql->Append("1"); }
+    void AppendClose(size_t i, SqlBuilder *sql) override { sql->Append((i % 2 == 0) ? "}" : "]"); }
 
+public:
     void SelfTest(ITestComparer *cmp) override {
         cmp->ExpectEq("select {'x':1}", GenerateSQL(1));
         cmp->ExpectEq("select {'x':[{'x':[1]}]}", GenerateSQL(4));
     }
 };
 
-class WideStruct : public ISQLFeature {
-public:
-    std::string name() override { return "wide struct"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select {";
-        for (size_t i = 0; i < n; i++) {
-            if (i) sql_.append(",");
-            sql_.append("'f");
-            sql_.append(std::to_string(i));
-            sql_.append("':1");
-        }
-        sql_.append("}");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select {'f0':1}", GenerateSQL(1));
-        cmp->ExpectEq("select {'f0':1,'f1':1,'f2':1}", GenerateSQL(3));
-    }
-};
-
-class NestedJson : public ISQLFeature {
-public:
-    std::string name() override { return "nested JSON"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select cast('";
-        for (size_t i = 0; i < n; i++)
-            sql_.append("{\"a\":");
-        sql_.append("1");
-        sql_.append(n, '}');
-        sql_.append("' as json)");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select cast('{\"a\":1}' as json)", GenerateSQL(1));
-        cmp->ExpectEq("select cast('{\"a\":{\"a\":{\"a\":1}}}' as json)", GenerateSQL(3));
-    }
-};
-
-class WideJson : public ISQLFeature {
-public:
-    std::string name() override { return "wide JSON"; }
+constexpr auto kWideStruct = FeatureSpec("wide struct").Prefix("select {").Unit("'f{i}':1").Separator(",").Suffix("}")
+        .Example(1, "select {'f0':1}")
+        .Example(3, "select {'f0':1,'f1':1,'f2':1}");
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select cast('{";
-        for (size_t i = 0; i < n; i++) {
-            if (i) sql_.append(",");
-            sql_.append("\"f");
-            sql_.append(std::to_string(i));
-            sql_.append("\":1");
-        }
-        sql_.append("}' as json)");
-        return sql_;
-    }
+constexpr auto kNestedJson = FeatureSpec("nested JSON").Prefix("select cast('").Unit("{\"a\":").Middle("1").Close("}")
+        .Suffix("' as json)")
+        .Example(1, "select cast('{\"a\":1}' as json)")
+        .Example(3, "select cast('{\"a\":{\"a\":{\"a\":1}}}' as json)");
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select cast('{\"f0\":1}' as json)", GenerateSQL(1));
-        cmp->ExpectEq("select cast('{\"f0\":1,\"f1\":1,\"f2\":1}' as json)", GenerateSQL(3));
-    }
-};
+constexpr auto kWideJson = FeatureSpec("wide JSON").Prefix("select cast('{").Unit("\"f{i}\":1").Separator(",")
+        .Suffix("}' as json)")
+        .Example(1, "select cast('{\"f0\":1}' as json)")
+        .Example(3, "select cast('{\"f0\":1,\"f1\":1,\"f2\":1}' as json)");
 
 // Chained json_set: builds JSON with n keys via n nested function calls.
 // Output amplifier (small per-call cost, growing JSON output) — analogue of repeat.
@@ -372,14 +342,12 @@ class JsonSetChain : public ISQLFeature {
 public:
     std::string name() override { return "json_set chain"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++) sql_.append("json_set(");
-        sql_.append("cast('{}' as json)");
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder sql(&sql_);
+        sql.Clear().Reserve(kFixedSize + n * 23 + SqlBuilder::DigitsInRange(0, n));
+        sql.Append("select ").Repeat("json_set(", n).Append("cast('{}' as json)");
         for (size_t i = 0; i < n; i++) {
-            sql_.append(", ['f");
-            sql_.append(std::to_string(i));
-            sql_.append("'], '1')");
+            sql.Append(", ['f").AppendNumber(i).Append("'], '1')");
         }
         return sql_;
     }
@@ -394,75 +362,26 @@ public:
 
 // json_each over a JSON object with n keys: set-returning function producing
 // n output rows from a single input value — analogue of unnest.
-class JsonEach : public ISQLFeature {
-public:
-    std::string name() override { return "json_each"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select * from json_each(cast('{";
-        for (size_t i = 0; i < n; i++) {
-            if (i) sql_.append(",");
-            sql_.append("\"f");
-            sql_.append(std::to_string(i));
-            sql_.append("\":1");
-        }
-        sql_.append("}' as json))");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select * from json_each(cast('{\"f0\":1}' as json))", GenerateSQL(1));
-        cmp->ExpectEq(
-                "select * from json_each(cast('{\"f0\":1,\"f1\":1}' as json))",
-                GenerateSQL(2));
-    }
-};
+constexpr auto kJsonEach = FeatureSpec("json_each").Prefix("select * from json_each(cast('{").Unit("\"f{i}\":1").Separator(",")
+        .Suffix("}' as json))")
+        .Example(1, "select * from json_each(cast('{\"f0\":1}' as json))")
+        .Example(2, "select * from json_each(cast('{\"f0\":1,\"f1\":1}' as json))");
 
 // Dollar-quoted string literal: `$$ ... $$`. Probes lexer length cap on this
 // alternate string form (vs. single-quoted TextLiteral).
-class DollarString : public ISQLFeature {
-public:
-    std::string name() override { return "dollar-quoted string"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select $$";
-        sql_.append(n, 'a');
-        sql_.append("$$");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select $$a$$", GenerateSQL(1));
-        cmp->ExpectEq("select $$aaaaa$$", GenerateSQL(5));
-    }
-};
+constexpr auto kDollarString = FeatureSpec("dollar-quoted string").Prefix("select $$").Unit("a").Suffix("$$")
+        .Example(1, "select $$a$$")
+        .Example(5, "select $$aaaaa$$");
 
 // BETWEEN ... AND chain. The non-parenthesized form `x BETWEEN a AND b BETWEEN
 // c AND d ...` is rejected universally (PostgreSQL / DuckDB / PackDB) as a
 // syntax error, so we parenthesize the prior expression on each step:
 // `(((x BETWEEN a AND b) BETWEEN c AND d) BETWEEN e AND f) ...`. This probes
 // how deep the parser/planner can chain boolean BETWEENs.
-class BetweenChain : public ISQLFeature {
-public:
-    std::string name() override { return "BETWEEN chain"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "1 between 0 and 2";
-        for (size_t i = 1; i < n; i++) {
-            sql_.insert(0, "(");
-            sql_.append(") between false and true");
-        }
-        sql_.insert(0, "select ");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 between 0 and 2", GenerateSQL(1));
-        cmp->ExpectEq(
-                "select ((1 between 0 and 2) between false and true) between false and true",
-                GenerateSQL(3));
-    }
-};
+constexpr auto kBetweenChain = FeatureSpec("BETWEEN chain").Prefix("select ")
+        .FirstUnit("").Unit("(").Middle("1 between 0 and 2").FirstClose("").Close(") between false and true")
+        .Example(1, "select 1 between 0 and 2")
+        .Example(3, "select ((1 between 0 and 2) between false and true) between false and true");
 
 // generate_series: set-returning function producing N rows. Output-amplifier
 // analogue of unnest for synthetic ranges.
@@ -470,10 +389,8 @@ class GenerateSeries : public ISQLFeature {
 public:
     std::string name() override { return "generate_series"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select generate_series(1, ";
-        sql_.append(std::to_string(n));
-        sql_.append(")");
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select generate_series(1, ").AppendNumber(n).Append(")");
         return sql_;
     }
 
@@ -488,16 +405,14 @@ class WideCreateTable : public ISQLFeature {
 public:
     std::string name() override { return "wide CREATE TABLE"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "create table if not exists tw_create_";
-        sql_.append(std::to_string(n));
-        sql_.append(" (c0 int");
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder sql(&sql_);
+        sql.Clear().Reserve(kFixedSize + n * 7 + SqlBuilder::DigitsInRange(1, n));
+        sql.Append("create table if not exists tw_create_").AppendNumber(n).Append(" (c0 int");
         for (size_t i = 1; i < n; i++) {
-            sql_.append(", c");
-            sql_.append(std::to_string(i));
-            sql_.append(" int");
+            sql.Append(", c").AppendNumber(i).Append(" int");
         }
-        sql_.append(")");
+        sql.Append(")");
         return sql_;
     }
 
@@ -508,1331 +423,467 @@ public:
     }
 };
 
-class Tuple : public ISQLFeature {
-public:
-    std::string name() override { return "tuple"; }
+constexpr auto kTuple = FeatureSpec("tuple").Prefix("select (").Unit("1").Separator(",").Suffix(")")
+        .Example(3, "select (1,1,1)");
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select (1";
-        for (size_t i = 0; i < n - 1; i++) {
-            sql_.append(",1");
-        }
-        sql_.append(")");
+constexpr auto kNestedTuple = FeatureSpec("nested tuple").Prefix("select ").Unit("(1").Separator(",").Close(")")
+        .Example(1, "select (1)")
+        .Example(3, "select (1,(1,(1)))");
+
+constexpr auto kSelectList = FeatureSpec("select list").Prefix("select ").Unit("1").Separator(",")
+        .Example(3, "select 1,1,1");
+
+constexpr auto kUnaryPlus = FeatureSpec("unary operator +").Prefix("select ").Unit("+").Middle("1")
+        .Fragment(FragmentKind::EXPRESSION).Hole(FragmentKind::EXPRESSION, "1")
+        .Example(2, "select ++1");
+
+// trailing space in "- " to prevent treating -- as a comment
+constexpr auto kUnaryMinus = FeatureSpec("unary operator - ").Prefix("select ").Unit("- ").Middle("1")
+        .Fragment(FragmentKind::EXPRESSION).Hole(FragmentKind::EXPRESSION, "1")
+        .Example(3, "select - - - 1");
+
+constexpr auto kLogicalNot = FeatureSpec("unary operator NOT ").Prefix("select ").Unit("NOT ").Middle("true")
+        .Fragment(FragmentKind::PREDICATE).Hole(FragmentKind::PREDICATE, "true")
+        .Example(3, "select NOT NOT NOT true");
+
+constexpr auto kBitwiseNot = FeatureSpec("unary operator ~ ").Prefix("select ").Unit("~ ").Middle("1")
+        .Example(3, "select ~ ~ ~ 1");
+
+constexpr auto kAbsOperator = FeatureSpec("unary operator @ ").Prefix("select ").Unit("@ ").Middle("1")
+        .Example(3, "select @ @ @ 1");
+
+constexpr auto kSquareRootOperator = FeatureSpec("unary operator |/ ").Prefix("select ").Unit("|/ ").Middle("1")
+        .Example(3, "select |/ |/ |/ 1");
+
+constexpr auto kCubeRootOperator = FeatureSpec("unary operator ||/ ").Prefix("select ").Unit("||/ ").Middle("1")
+        .Example(3, "select ||/ ||/ ||/ 1");
+
+constexpr auto kPlus = FeatureSpec("binary operator  + ").Prefix("select 0").Unit(" + 0")
+        .Fragment(FragmentKind::EXPRESSION).Hole(FragmentKind::EXPRESSION, "0")
+        .Example(4, "select 0 + 0 + 0 + 0 + 0");
+
+constexpr auto kMinus = FeatureSpec("binary operator  - ").Prefix("select 0").Unit(" - 0")
+        .Example(3, "select 0 - 0 - 0 - 0");
+
+constexpr auto kMultiply = FeatureSpec("binary operator  * ").Prefix("select 1").Unit(" * 1")
+        .Fragment(FragmentKind::EXPRESSION).Hole(FragmentKind::EXPRESSION, "1")
+        .Example(3, "select 1 * 1 * 1 * 1");
+
+constexpr auto kDivide = FeatureSpec("binary operator  / ").Prefix("select 1").Unit(" / 1")
+        .Example(3, "select 1 / 1 / 1 / 1");
+
+constexpr auto kModulo = FeatureSpec("binary operator  % ").Prefix("select 1").Unit(" % 1")
+        .Example(3, "select 1 % 1 % 1 % 1");
+
+constexpr auto kPower = FeatureSpec("binary operator  ^ ").Prefix("select 1").Unit(" ^ 1")
+        .Example(3, "select 1 ^ 1 ^ 1 ^ 1");
+
+constexpr auto kBitwiseAnd = FeatureSpec("binary operator  & ").Prefix("select 1").Unit(" & 1")
+        .Example(3, "select 1 & 1 & 1 & 1");
+
+constexpr auto kBitwiseOr = FeatureSpec("binary operator  | ").Prefix("select 1").Unit(" | 1")
+        .Example(3, "select 1 | 1 | 1 | 1");
+
+constexpr auto kBitwiseXor = FeatureSpec("binary operator  # ").Prefix("select 1").Unit(" # 1")
+        .Example(3, "select 1 # 1 # 1 # 1");
+
+constexpr auto kBitwiseShiftLeft = FeatureSpec("binary operator  << ").Prefix("select 0").Unit(" << 0")
+        .Example(3, "select 0 << 0 << 0 << 0");
+
+constexpr auto kBitwiseShiftRight = FeatureSpec("binary operator  >> ").Prefix("select 0").Unit(" >> 0")
+        .Example(3, "select 0 >> 0 >> 0 >> 0");
+
+constexpr auto kLogicalAnd = FeatureSpec("binary operator  AND ").Prefix("select true").Unit(" AND true")
+        .Fragment(FragmentKind::PREDICATE).Hole(FragmentKind::PREDICATE, "true")
+        .Example(2, "select true AND true AND true");
+
+constexpr auto kLogicalOr = FeatureSpec("binary operator  OR ").Prefix("select true").Unit(" OR true")
+        .Fragment(FragmentKind::PREDICATE).Hole(FragmentKind::PREDICATE, "true")
+        .Example(2, "select true OR true OR true");
+
+constexpr auto kIs = FeatureSpec("binary operator  IS ").Prefix("select true").Unit(" IS true")
+        .Example(2, "select true IS true IS true");
+
+constexpr auto kTextConcat = FeatureSpec("binary operator  || ").Prefix("select 'x'").Unit(" || 'x'")
+        .Example(2, "select 'x' || 'x' || 'x'");
+
+constexpr auto kArrayConcat = FeatureSpec("binary operator  || ").Prefix("select array [1]").Unit(" || array [1]")
+        .Example(1, "select array [1] || array [1]");
+
+constexpr auto kAbs = FeatureSpec("function abs()").Prefix("select ").Unit("abs(").Middle("-1").Close(")")
+        .Fragment(FragmentKind::EXPRESSION).Hole(FragmentKind::EXPRESSION, "-1")
+        .Example(3, "select abs(abs(abs(-1)))");
+
+constexpr auto kTrim = FeatureSpec("trim").Prefix("select ").Unit("trim(' ' from ").Middle("'  x '").Close(")")
+        .Example(2, "select trim(' ' from trim(' ' from '  x '))");
+
+constexpr auto kDateTrunc = FeatureSpec("date_trunc").Prefix("select ").Unit("date_trunc('minute', ")
+        .Middle("timestamp '2000-01-01 10:20:30'").Close(")")
+        .Example(2, "select date_trunc('minute', date_trunc('minute', timestamp '2000-01-01 10:20:30'))");
+
+class StringRepeat : public ISQLFeature {
+    std::string name() override { return "repeat"; }
+
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select repeat('x', ").AppendNumber(n).Append(")");
         return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select (1,1,1)", GenerateSQL(3));
+        cmp->ExpectEq("select repeat('x', 5)", GenerateSQL(5));
     }
 };
 
-class NestedTuple : public ISQLFeature {
-public:
-    std::string name() override { return "nested tuple"; }
+constexpr auto kReplace = FeatureSpec("replace").Prefix("select ").Unit("replace(").Middle("'a'").Close(", 'a', 'aa')").Exponential()
+        .Example(2, "select replace(replace('a', 'a', 'aa'), 'a', 'aa')");
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select (1";
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(",(1");
-        }
-        sql_.append(n, ')');
+class LPad : public ISQLFeature {
+    std::string name() override { return "lpad"; }
+
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select lpad('x', ").AppendNumber(n).Append(", ' ')");
         return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select (1)", GenerateSQL(1));
-        cmp->ExpectEq("select (1,(1,(1)))", GenerateSQL(3));
+        cmp->ExpectEq("select lpad('x', 5, ' ')", GenerateSQL(5));
     }
 };
 
-class SelectList : public ISQLFeature {
-public:
-    std::string name() override { return "select list"; }
+class RPad : public ISQLFeature {
+    std::string name() override { return "rpad"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select 1";
-        for (size_t i = 0; i < n - 1; i++) {
-            sql_.append(",1");
-        }
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select rpad('x', ").AppendNumber(n).Append(", ' ')");
         return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1,1,1", GenerateSQL(3));
+        cmp->ExpectEq("select rpad('x', 5, ' ')", GenerateSQL(5));
     }
 };
 
-class UnaryOperator : public ISQLFeature {
-public:
-    UnaryOperator(std::string_view op, std::string_view value) : op_(op), value_(value) {}
-
-    std::string name() override { return "unary operator " + op_; }
+class Format : public ISQLFeature {
+    std::string name() override { return "format"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(op_);
-        }
-        sql_.append(value_);
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select format('%").AppendNumber(n).Append("s', 'a')");
         return sql_;
     }
 
-private:
-    const std::string op_;
-    const std::string value_;
-};
-
-class UnaryPlus : public UnaryOperator {
-public:
-    UnaryPlus() : UnaryOperator("+", "1") {}
-
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select ++1", GenerateSQL(2));
+        cmp->ExpectEq("select format('%5s', 'a')", GenerateSQL(5));
     }
 };
+constexpr auto kAtTimeZone = FeatureSpec("at time zone").Prefix("select timestamp '2000-01-01 00:00:00'").Unit(" at time zone 'UTC'")
+        .Example(2, "select timestamp '2000-01-01 00:00:00' at time zone 'UTC' at time zone 'UTC'");
 
-// trailing space in "- " to prevent treating -- as a comment
-class UnaryMinus : public UnaryOperator {
-public:
-    UnaryMinus() : UnaryOperator("- ", "1") {}
+constexpr auto kCast = FeatureSpec("cast").Prefix("select ").Unit("cast(").Middle("'1'").Close(" as int)")
+        .Fragment(FragmentKind::EXPRESSION).Hole(FragmentKind::EXPRESSION, "'1'")
+        .Example(2, "select cast(cast('1' as int) as int)");
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select - - - 1", GenerateSQL(3));
-    }
-};
+constexpr auto kCastNestedArray = FeatureSpec("cast as nested array").Prefix("select cast(NULL as int").Unit("[]").Suffix(")")
+        .Example(2, "select cast(NULL as int[][])");
 
-class LogicalNot : public UnaryOperator {
-public:
-    LogicalNot() : UnaryOperator("NOT ", "true") {}
+constexpr auto kCastOperator = FeatureSpec("cast ::").Prefix("select '1'").Unit("::int")
+        .Example(3, "select '1'::int::int::int");
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select NOT NOT NOT true", GenerateSQL(3));
-    }
-};
+class StringAgg : public ISQLFeature {
+    std::string name() override { return "string_agg"; }
 
-class BitwiseNot : public UnaryOperator {
-public:
-    BitwiseNot() : UnaryOperator("~ ", "1") {}
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear()
+                .Append("select string_agg(x::text, '') from generate_series(1,")
+                .AppendNumber(n)
+                .Append(") as t(x)");
+        return sql_;
+    }
 
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select ~ ~ ~ 1", GenerateSQL(3));
+        cmp->ExpectEq("select string_agg(x::text, '') from generate_series(1,3) as t(x)", GenerateSQL(3));
     }
 };
 
-class AbsOperator : public UnaryOperator {
-public:
-    AbsOperator() : UnaryOperator("@ ", "1") {}
+class ArrayAgg : public ISQLFeature {
+    std::string name() override { return "array_agg"; }
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select @ @ @ 1", GenerateSQL(3));
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select array_agg(x) from generate_series(1,").AppendNumber(n).Append(") as t(x)");
+        return sql_;
     }
-};
-
-class SquareRootOperator : public UnaryOperator {
-public:
-    SquareRootOperator() : UnaryOperator("|/ ", "1") {}
 
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select |/ |/ |/ 1", GenerateSQL(3));
+        cmp->ExpectEq("select array_agg(x) from generate_series(1,3) as t(x)", GenerateSQL(3));
     }
 };
 
-class CubeRootOperator : public UnaryOperator {
+constexpr auto kInList = FeatureSpec("IN list").Prefix("select 1 in (").Unit("2").Separator(",").Suffix(")")
+        .Fragment(FragmentKind::PREDICATE)
+        .Example(5, "select 1 in (2,2,2,2,2)");
+
+class Coalesce : public ISQLFeature {
 public:
-    CubeRootOperator() : UnaryOperator("||/ ", "1") {}
+    std::string name() override { return "coalesce"; }
+
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear().Append("select coalesce(null").Repeat(",null", n > 2 ? n - 2 : 0).Append(",1)");
+        return sql_;
+    }
 
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select ||/ ||/ ||/ 1", GenerateSQL(3));
+        cmp->ExpectEq("select coalesce(null,null,null,1)", GenerateSQL(4));
     }
 };
 
-class BinaryOperator : public ISQLFeature {
+constexpr auto kGreatest = FeatureSpec("greatest").Prefix("select greatest(").Unit("{i}").Separator(",").Suffix(")")
+        .Fragment(FragmentKind::EXPRESSION)
+        .Example(4, "select greatest(0,1,2,3)");
+
+constexpr auto kSimpleCase = FeatureSpec("simple CASE").Prefix("select case x ").Unit("when {i} then {i}+1 ")
+        .Suffix("else 0 end from (select 0 x) t")
+        .Example(2, "select case x when 0 then 0+1 when 1 then 1+1 else 0 end from (select 0 x) t");
+
+constexpr auto kSearchedCase = FeatureSpec("searched CASE").Prefix("select case ").Unit("when x > {i} then {i}+1 ")
+        .Suffix("else 0 end from (select 0 x) t")
+        .Example(2, "select case when x > 0 then 0+1 when x > 1 then 1+1 else 0 end from (select 0 x) t");
+
+constexpr auto kNestedCase = FeatureSpec("nested CASE").Prefix("select ").Unit("case when true then ").Middle("1")
+        .Close(" else 0 end")
+        .Fragment(FragmentKind::EXPRESSION).Hole(FragmentKind::EXPRESSION, "1")
+        .Example(2, "select case when true then case when true then 1 else 0 end else 0 end");
+
+class SubSelectFrom : public ISQLFeature {
 public:
-    explicit BinaryOperator(const std::string &op, std::string_view value) : op_(" " + op + " "), value_(value) {}
+    explicit SubSelectFrom() {}
 
-    std::string name() override { return "binary operator " + op_; }
+    std::string name() override { return "subselect in FROM "; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select " + value_;
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder sql(&sql_);
+        sql.Clear().Reserve(kFixedSize + n * 18 + SqlBuilder::DigitsInRange(0, n));
+        sql.Repeat("select * from (", n).Append("select 1 as x");
         for (size_t i = 0; i < n; i++) {
-            sql_.append(op_);
-            sql_.append(value_);
+            sql.Append(") t").AppendNumber(i);
         }
         return sql_;
     }
 
-private:
-    const std::string op_;
-    const std::string value_;
-};
-
-class Plus : public BinaryOperator {
-public:
-    Plus() : BinaryOperator("+", "0") {}
-
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 0 + 0 + 0 + 0 + 0", GenerateSQL(4));
+        cmp->ExpectEq("select * from (select * from (select 1 as x) t0) t1", GenerateSQL(2));
     }
-};
 
-class Minus : public BinaryOperator {
-public:
-    Minus() : BinaryOperator("-", "0") {}
+    FragmentKind fragment_kind() const override { return FragmentKind::QUERY; }
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 0 - 0 - 0 - 0", GenerateSQL(3));
-    }
+    Hole hole() const override { return {FragmentKind::QUERY, "select 1 as x"}; }
 };
 
-class Multiply : public BinaryOperator {
-public:
-    Multiply() : BinaryOperator("*", "1") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 * 1 * 1 * 1", GenerateSQL(3));
-    }
-};
+constexpr auto kSubSelectScalar = FeatureSpec("subselect nested scalar").Unit("select (").Middle("select 1 as x").Close(")")
+        .Example(4, "select (select (select (select (select 1 as x))))");
 
-class Divide : public BinaryOperator {
+class SubSelectInExpr : public ISQLFeature {
 public:
-    Divide() : BinaryOperator("/", "1") {}
+    explicit SubSelectInExpr() {}
 
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 / 1 / 1 / 1", GenerateSQL(3));
-    }
-};
-
-class Modulo : public BinaryOperator {
-public:
-    Modulo() : BinaryOperator("%", "1") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 % 1 % 1 % 1", GenerateSQL(3));
-    }
-};
-
-class Power : public BinaryOperator {
-public:
-    Power() : BinaryOperator("^", "1") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 ^ 1 ^ 1 ^ 1", GenerateSQL(3));
-    }
-};
-
-class BitwiseAnd : public BinaryOperator {
-public:
-    BitwiseAnd() : BinaryOperator("&", "1") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 & 1 & 1 & 1", GenerateSQL(3));
-    }
-};
-
-class BitwiseOr : public BinaryOperator {
-public:
-    BitwiseOr() : BinaryOperator("|", "1") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 | 1 | 1 | 1", GenerateSQL(3));
-    }
-};
-
-class BitwiseXor : public BinaryOperator {
-public:
-    BitwiseXor() : BinaryOperator("#", "1") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 # 1 # 1 # 1", GenerateSQL(3));
-    }
-};
-
-class BitwiseShiftLeft : public BinaryOperator {
-public:
-    BitwiseShiftLeft() : BinaryOperator("<<", "0") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 0 << 0 << 0 << 0", GenerateSQL(3));
-    }
-};
-
-class BitwiseShiftRight : public BinaryOperator {
-public:
-    BitwiseShiftRight() : BinaryOperator(">>", "0") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 0 >> 0 >> 0 >> 0", GenerateSQL(3));
-    }
-};
-
-class LogicalAnd : public BinaryOperator {
-public:
-    LogicalAnd() : BinaryOperator("AND", "true") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select true AND true AND true", GenerateSQL(2));
-    }
-};
-
-class LogicalOr : public BinaryOperator {
-public:
-    LogicalOr() : BinaryOperator("OR", "true") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select true OR true OR true", GenerateSQL(2));
-    }
-};
-
-class Is : public BinaryOperator {
-public:
-    Is() : BinaryOperator("IS", "true") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select true IS true IS true", GenerateSQL(2));
-    }
-};
-
-class TextConcat : public BinaryOperator {
-public:
-    TextConcat() : BinaryOperator("||", "'x'") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 'x' || 'x' || 'x'", GenerateSQL(2));
-    }
-};
-
-class ArrayConcat : public BinaryOperator {
-public:
-    ArrayConcat() : BinaryOperator("||", "array [1]") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select array [1] || array [1]", GenerateSQL(1));
-    }
-};
-
-class UnaryFunction : public ISQLFeature {
-public:
-    explicit UnaryFunction(std::string func, std::string value) : func_(func + "("), value_(value) {}
-
-    std::string name() override { return "function " + func_ + ")"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(func_);
-        }
-        sql_.append(value_);
-        sql_.append(n, ')');
-        return sql_;
-    }
-
-private:
-    const std::string func_;
-    const std::string value_;
-};
-
-class Abs : public UnaryFunction {
-public:
-    Abs() : UnaryFunction("abs", "-1") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select abs(abs(abs(-1)))", GenerateSQL(3));
-    }
-};
-
-class Trim : public ISQLFeature {
-public:
-    std::string name() override { return "trim"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("trim(' ' from ");
-        }
-        sql_.append("'  x '");
-        sql_.append(n, ')');
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select trim(' ' from trim(' ' from '  x '))", GenerateSQL(2));
-    }
-};
-
-class DateTrunc : public ISQLFeature {
-public:
-    std::string name() override { return "date_trunc"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("date_trunc('minute', ");
-        }
-        sql_.append("timestamp '2000-01-01 10:20:30'");
-        sql_.append(n, ')');
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select date_trunc('minute', date_trunc('minute', timestamp '2000-01-01 10:20:30'))",
-                      GenerateSQL(2));
-    }
-};
-
-class Repeat : public ISQLFeature {
-    std::string name() override { return "repeat"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select repeat('x', " + std::to_string(n) + ")";
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select repeat('x', 5)", GenerateSQL(5));
-    }
-};
-
-class Replace : public ISQLFeature {
-    std::string name() override { return "replace"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("replace(");
-        }
-        sql_.append("'a'");
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(", 'a', 'aa')");
-        }
-        return sql_;
-    }
-
-    bool is_exponential() const override { return true; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select replace(replace('a', 'a', 'aa'), 'a', 'aa')", GenerateSQL(2));
-    }
-};
-
-class LPad : public ISQLFeature {
-    std::string name() override { return "lpad"; }
-
-    std::string GenerateSQL(size_t n) override {
-        return "select lpad('x', " + std::to_string(n) + ", ' ')";
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select lpad('x', 5, ' ')", GenerateSQL(5));
-    }
-};
-
-class RPad : public ISQLFeature {
-    std::string name() override { return "rpad"; }
-
-    std::string GenerateSQL(size_t n) override {
-        return "select rpad('x', " + std::to_string(n) + ", ' ')";
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select rpad('x', 5, ' ')", GenerateSQL(5));
-    }
-};
-
-class Format : public ISQLFeature {
-    std::string name() override { return "format"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select format('%" + std::to_string(n) + "s', 'a')";
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select format('%5s', 'a')", GenerateSQL(5));
-    }
-};
-class AtTimeZone : public ISQLFeature {
-    std::string name() override { return "at time zone"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select timestamp '2000-01-01 00:00:00'";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(" at time zone 'UTC'");
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select timestamp '2000-01-01 00:00:00' at time zone 'UTC' at time zone 'UTC'",
-                      GenerateSQL(2));
-    }
-};
-
-class Cast : public ISQLFeature {
-    std::string name() override { return "cast"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("cast(");
-        }
-        sql_.append("'1'");
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(" as int)");
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select cast(cast('1' as int) as int)", GenerateSQL(2));
-    }
-};
-
-class CastNestedArray : public ISQLFeature {
-    std::string name() override { return "cast as nested array"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select cast(NULL as int";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("[]");
-        }
-        sql_.append(")");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select cast(NULL as int[][])", GenerateSQL(2));
-    }
-};
-
-class CastOperator : public ISQLFeature {
-    std::string name() override { return "cast ::"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select '1'";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("::int");
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select '1'::int::int::int", GenerateSQL(3));
-    }
-};
-
-class StringAgg : public ISQLFeature {
-    std::string name() override { return "string_agg"; }
-
-    std::string GenerateSQL(size_t n) override {
-        return "select string_agg(x::text, '') from generate_series(1," + std::to_string(n) + ") as t(x)";
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select string_agg(x::text, '') from generate_series(1,3) as t(x)", GenerateSQL(3));
-    }
-};
-
-class ArrayAgg : public ISQLFeature {
-    std::string name() override { return "array_agg"; }
-
-    std::string GenerateSQL(size_t n) override {
-        return "select array_agg(x) from generate_series(1," + std::to_string(n) + ") as t(x)";
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select array_agg(x) from generate_series(1,3) as t(x)", GenerateSQL(3));
-    }
-};
-
-class InList : public ISQLFeature {
-public:
-    std::string name() override { return "IN list"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select 1 in (2";
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(",2");
-        }
-        sql_.append(")");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 in (2,2,2,2,2)", GenerateSQL(5));
-    }
-};
-
-class Coalesce : public ISQLFeature {
-public:
-    std::string name() override { return "coalesce"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select coalesce(null";
-        for (size_t i = 1; i < n-1; i++) {
-            sql_.append(",null");
-        }
-        sql_.append(",1)");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select coalesce(null,null,null,1)", GenerateSQL(4));
-    }
-};
-
-class Greatest : public ISQLFeature {
-public:
-    std::string name() override { return "greatest"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select greatest(0";
-        for (size_t i = 1; i < n; i++) {
-            sql_.append("," + std::to_string(i));
-        }
-        sql_.append(")");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select greatest(0,1,2,3)", GenerateSQL(4));
-    }
-};
-
-class SimpleCase : public ISQLFeature {
-public:
-    std::string name() override { return "simple CASE"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select case x ";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("when " + std::to_string(i) + " then " + std::to_string(i) + "+1 ");
-        }
-        sql_.append("else 0 end from (select 0 x) t");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select case x when 0 then 0+1 when 1 then 1+1 else 0 end from (select 0 x) t",
-                      GenerateSQL(2));
-    }
-};
-
-class SearchedCase : public ISQLFeature {
-public:
-    std::string name() override { return "searched CASE"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select case ";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("when x > " + std::to_string(i) + " then " + std::to_string(i) + "+1 ");
-        }
-        sql_.append("else 0 end from (select 0 x) t");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select case when x > 0 then 0+1 when x > 1 then 1+1 else 0 end from (select 0 x) t",
-                      GenerateSQL(2));
-    }
-};
-
-class SubSelectFrom : public ISQLFeature {
-public:
-    explicit SubSelectFrom() {}
-
-    std::string name() override { return "subselect in FROM "; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_.clear();
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("select * from (");
-        }
-        sql_.append("select 1 as x");
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(") t" + std::to_string(i));
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select * from (select * from (select 1 as x) t0) t1", GenerateSQL(2));
-    }
-};
-
-class SubSelectScalar : public ISQLFeature {
-public:
-    explicit SubSelectScalar() {}
-
-    std::string name() override { return "subselect nested scalar"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_.clear();
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("select (");
-        }
-        sql_.append("select 1 as x");
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(")");
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select (select (select (select (select 1 as x))))", GenerateSQL(4));
-    }
-};
-
-class SubSelectInExpr : public ISQLFeature {
-public:
-    explicit SubSelectInExpr() {}
-
-    std::string name() override { return "subselect in expression"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_.clear();
-        for (size_t i = 0; i < n; i++) {
-            sql_.append("select 1 + (");
-        }
-        sql_.append("select 1 as x");
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(") t" + std::to_string(i));
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select 1 + (select 1 + (select 1 as x) t0) t1", GenerateSQL(2));
-    }
-};
-
-class CTE : public ISQLFeature {
-public:
-    std::string name() override { return "CTE"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "with ";
-        sql_.append("t0 as (select 1 as x) ");
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(", t" + std::to_string(i) + " as (" + "select * from t" + std::to_string(i - 1) + ")");
-        }
-        sql_.append(" select * from t0");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "with t0 as (select 1 as x) , t1 as (select * from t0), t2 as (select * from t1) select * from t0",
-                GenerateSQL(3));
-    }
-};
-
-class RecursiveCTE : public ISQLFeature {
-public:
-    std::string name() override { return "recursive CTE"; }
-
-    std::string GenerateSQL(size_t n) override {
-        return "with recursive r as (select 1 x union all select x + 1 from r where x < " + std::to_string(n) +
-               ") select max(x) from r";
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "with recursive r as (select 1 x union all select x + 1 from r where x < 100) select max(x) from r",
-                GenerateSQL(100));
-    }
-};
-
-class GroupByList : public ISQLFeature {
-public:
-    std::string name() override { return "GROUP BY list"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select x from (select 1 x) t group by x";
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(",x+");
-            sql_.append(std::to_string(i));
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select x from (select 1 x) t group by x,x+1,x+2", GenerateSQL(3));
-    }
-};
-
-class GroupingOpBase : public ISQLFeature {
-public:
-    explicit GroupingOpBase(std::string_view op) : op_(op) {}
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select x from (select 1 x) t group by ";
-        sql_.append(op_);
-        sql_.append(" ((x)");
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(",(x+" + std::to_string(i) + ")");
-        }
-        sql_.append(")");
-        return sql_;
-    }
-
-protected:
-    const std::string op_;
-};
-
-class GroupingSets : public GroupingOpBase {
-public:
-    GroupingSets() : GroupingOpBase("grouping sets") {}
-    std::string name() override { return "GROUPING SETS"; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select x from (select 1 x) t group by grouping sets ((x),(x+1),(x+2))",
-                GenerateSQL(3));
-    }
-};
-
-class Rollup : public GroupingOpBase {
-public:
-    Rollup() : GroupingOpBase("rollup") {}
-    std::string name() override { return "ROLLUP"; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select x from (select 1 x) t group by rollup ((x),(x+1),(x+2))",
-                GenerateSQL(3));
-    }
-};
-
-class Cube : public GroupingOpBase {
-public:
-    Cube() : GroupingOpBase("cube") {}
-    std::string name() override { return "CUBE"; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select x from (select 1 x) t group by cube ((x),(x+1),(x+2))",
-                GenerateSQL(3));
-    }
-};
-
-class OrderByList : public ISQLFeature {
-public:
-    std::string name() override { return "ORDER BY list"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select x from (select 1 x) t order by x";
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(",x+" + std::to_string(i));
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select x from (select 1 x) t order by x,x+1,x+2", GenerateSQL(3));
-    }
-};
-
-class Aggregation : public ISQLFeature {
-public:
-    std::string name() override { return "aggregation"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select sum(x)";
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(",sum(x+" + std::to_string(i) + ")");
-        }
-        sql_.append(" from (select 1 x) t");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select sum(x),sum(x+1),sum(x+2) from (select 1 x) t", GenerateSQL(3));
-    }
-};
-
-
-class RelOperator : public ISQLFeature {
-public:
-    explicit RelOperator(std::string_view op) : op_(op) {}
-
-    std::string name() override { return op_; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select 1 x";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(" ");
-            sql_.append(op_);
-            sql_.append(" select 1 x");
-        }
-        return sql_;
-    }
-
-private:
-    const std::string op_;
-};
-
-class UnionAll : public RelOperator {
-public:
-    UnionAll() : RelOperator("union all") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select 1 x union all select 1 x union all select 1 x",
-                GenerateSQL(2));
-    }
-};
-
-class Union : public RelOperator {
-public:
-    Union() : RelOperator("union") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select 1 x union select 1 x union select 1 x union select 1 x",
-                GenerateSQL(3));
-    }
-};
-
-class Except : public RelOperator {
-public:
-    Except() : RelOperator("except") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select 1 x except select 1 x",
-                GenerateSQL(1));
-    }
-};
-
-class Intersect : public RelOperator {
-public:
-    Intersect() : RelOperator("intersect") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select 1 x intersect select 1 x",
-                GenerateSQL(1));
-    }
-};
-
-class IntersectAll : public RelOperator {
-public:
-    IntersectAll() : RelOperator("intersect all") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select 1 x intersect all select 1 x",
-                GenerateSQL(1));
-    }
-};
-
-class CorrelatedSubquery : public ISQLFeature {
-public:
-    std::string name() override { return "correlated subquery"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select * from (select 1 x) t0 where exists (";
-        for (size_t i = 1; i <= n; i++) {
-            if (i > 1) sql_ += "exists (";
-            sql_ += "select 1 from (select 1 x) t" + std::to_string(i) + " where ";
-            sql_ += "t" + std::to_string(i - 1) + ".x = t" + std::to_string(i) + ".x";
-            if (i < n) sql_ += " and ";
-        }
-        sql_ += std::string(n, ')');
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 where exists ("
-                "select 1 from (select 1 x) t1 where t0.x = t1.x)",
-                GenerateSQL(1));
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 where exists ("
-                "select 1 from (select 1 x) t1 where t0.x = t1.x and "
-                "exists (select 1 from (select 1 x) t2 where t1.x = t2.x))",
-                GenerateSQL(2));
-    }
-};
-
-class IsDistinctFrom : public ISQLFeature {
-public:
-    std::string name() override { return "is distinct from"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select ";
-        if (n > 1) {
-            for (size_t i = 0; i < n - 1; i++) {
-                sql_ += "(";
-            }
-            sql_ += "true";
-            for (size_t i = 2; i <= n; i++) {
-                sql_ += " is distinct from true)";
-            }
-            sql_ += " is distinct from false";
-        } else {
-            sql_ += "true is distinct from false";
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq("select true is distinct from false", GenerateSQL(1));
-        cmp->ExpectEq("select (true is distinct from true) is distinct from false", GenerateSQL(2));
-        cmp->ExpectEq("select ((true is distinct from true) is distinct from true) is distinct from false", GenerateSQL(3));
-    }
-};
-
-class JoinOperator : public ISQLFeature {
-public:
-    explicit JoinOperator(std::string_view type) : type_(type) {}
-
-    std::string name() override { return type_.empty() ? "join" : type_ + " join"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select * from (select 1 x) t0";
-        for (size_t i = 1; i <= n; i++) {
-            if (!type_.empty()) {
-                sql_.append(" ");
-                sql_.append(type_);
-            }
-            sql_.append(" (select 1 x) t");
-            sql_.append(std::to_string(i));
-            std::string p = predicate(n, i - 1, i);
-            if (!p.empty()) {
-                sql_.append(" ");
-                sql_.append(p);
-            }
-        }
-        return sql_;
-    }
-
-protected:
-    // Function to generate predicate
-    virtual std::string predicate(size_t n, size_t i1, size_t i2) const = 0;
-
-private:
-    const std::string type_;
-};
-
-class CrossJoin : public JoinOperator {
-public:
-    CrossJoin() : JoinOperator("cross join") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 "
-                "cross join (select 1 x) t1 "
-                "cross join (select 1 x) t2 "
-                "cross join (select 1 x) t3 "
-                "cross join (select 1 x) t4",
-                GenerateSQL(4));
-    }
-
-protected:
-    std::string predicate(size_t n, size_t i1, size_t i2) const override { return std::string(); }
-};
-
-class NaturalJoin : public JoinOperator {
-public:
-    NaturalJoin() : JoinOperator("natural join") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 "
-                "natural join (select 1 x) t1 "
-                "natural join (select 1 x) t2 "
-                "natural join (select 1 x) t3",
-                GenerateSQL(3));
-    }
-
-protected:
-    std::string predicate(size_t n, size_t i1, size_t i2) const override { return std::string(); }
-};
-
-class JoinChain : public JoinOperator {
-public:
-    JoinChain() : JoinOperator("join") {}
-
-    std::string name() override { return "chain join"; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 "
-                "join (select 1 x) t1 on t0.x=t1.x "
-                "join (select 1 x) t2 on t1.x=t2.x "
-                "join (select 1 x) t3 on t2.x=t3.x",
-                GenerateSQL(3));
-    }
-
-protected:
-    std::string predicate(size_t n, size_t i1, size_t i2) const override {
-        return "on t" + std::to_string(i1) + ".x=t" + std::to_string(i2) + ".x";
-    }
-};
-
-class JoinChainRight : public ISQLFeature {
-public:
-    std::string name() override { return "join chain right"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select * from (select 1 x) t0";
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(" inner join (select 1 x) t" + std::to_string(i));
-        }
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(" on true");
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 inner join (select 1 x) t1 inner join (select 1 x) t2 on true on true",
-                GenerateSQL(3));
-    }
-};
-
-class JoinStar : public JoinOperator {
-public:
-    JoinStar() : JoinOperator("join") {}
-
-    std::string name() override { return "star join"; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 "
-                "join (select 1 x) t1 on t0.x=t1.x "
-                "join (select 1 x) t2 on t0.x=t2.x "
-                "join (select 1 x) t3 on t0.x=t3.x",
-                GenerateSQL(3));
-    }
-
-protected:
-    std::string predicate(size_t n, size_t i1, size_t i2) const override {
-        return "on t0.x=t" + std::to_string(i2) + ".x";
-    }
-};
-
-class JoinUsingOperator : public JoinOperator {
-public:
-    explicit JoinUsingOperator(std::string_view type) : JoinOperator(type) {}
-
-protected:
-    std::string predicate(size_t n, size_t i1, size_t i2) const override {
-        return "using (x)";
-    }
-};
-
-class InnerJoin : public JoinUsingOperator {
-public:
-    InnerJoin() : JoinUsingOperator("inner join") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 "
-                "inner join (select 1 x) t1 using (x) "
-                "inner join (select 1 x) t2 using (x) "
-                "inner join (select 1 x) t3 using (x)",
-                GenerateSQL(3));
-    }
-
-protected:
-    std::string predicate(size_t n, size_t i1, size_t i2) const override {
-        return "using (x)";
-    }
-};
-
-class LeftOuterJoin : public JoinUsingOperator {
-public:
-    LeftOuterJoin() : JoinUsingOperator("left outer join") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 left outer join (select 1 x) t1 using (x)",
-                GenerateSQL(1));
-    }
-};
-
-class RightOuterJoin : public JoinUsingOperator {
-public:
-    RightOuterJoin() : JoinUsingOperator("right outer join") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 "
-                "right outer join (select 1 x) t1 using (x) "
-                "right outer join (select 1 x) t2 using (x)",
-                GenerateSQL(2));
-    }
-};
-
-class FullOuterJoin : public JoinUsingOperator {
-public:
-    FullOuterJoin() : JoinUsingOperator("full outer join") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 "
-                "full outer join (select 1 x) t1 using (x)",
-                GenerateSQL(1));
-    }
-};
-
-class LateralJoin : public JoinOperator {
-public:
-    LateralJoin() : JoinOperator(", lateral") {}
-
-    std::string name() override { return "lateral join"; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t0 , lateral (select 1 x) t1 , lateral (select 1 x) t2",
-                GenerateSQL(2));
-    }
-
-protected:
-    std::string predicate(size_t n, size_t i1, size_t i2) const override { return std::string(); }
-};
-
-class WhereSemiJoin : public ISQLFeature {
-public:
-    explicit WhereSemiJoin(std::string_view type) : type_(type) {}
-
-    std::string name() override { return type_ + " semijoin"; }
+    std::string name() override { return "subselect in expression"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select * from (select 1 as x) t0";
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder sql(&sql_);
+        sql.Clear().Reserve(kFixedSize + n * 15 + SqlBuilder::DigitsInRange(0, n));
+        sql.Repeat("select 1 + (", n).Append("select 1 as x");
         for (size_t i = 0; i < n; i++) {
-            sql_.append(" where " + type_ + " (select * from (select 1 as x) t" + std::to_string(i + 1));
+            sql.Append(") t").AppendNumber(i);
         }
-        sql_.append(n, ')');
         return sql_;
     }
 
-private:
-    std::string type_;
-};
-
-class InSemiJoin : public WhereSemiJoin {
-public:
-    InSemiJoin() : WhereSemiJoin("x in") {}
-
-    std::string name() override { return "in semijoin"; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 as x) t0 "
-                "where x in (select * from (select 1 as x) t1 "
-                "where x in (select * from (select 1 as x) t2 "
-                "where x in (select * from (select 1 as x) t3)))",
-                GenerateSQL(3));
-    }
-};
-
-class ExistsSemiJoin : public WhereSemiJoin {
-public:
-    ExistsSemiJoin() : WhereSemiJoin("exists") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 as x) t0 "
-                "where exists (select * from (select 1 as x) t1 "
-                "where exists (select * from (select 1 as x) t2))",
-                GenerateSQL(2));
-    }
-};
-
-class AnySemiJoin : public WhereSemiJoin {
-public:
-    AnySemiJoin() : WhereSemiJoin("x > any") {}
-
-    std::string name() override { return "any semijoin"; }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 as x) t0 where x > any (select * from (select 1 as x) t1 where x > any (select * from (select 1 as x) t2))",
-                GenerateSQL(2));
-    }
-};
-
-class AllSemiJoin : public WhereSemiJoin {
-public:
-    AllSemiJoin() : WhereSemiJoin("x < all") {}
-
-    std::string name() override { return "all semijoin"; }
-
     void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 as x) t0 where x < all (select * from (select 1 as x) t1 where x < all (select * from (select 1 as x) t2))",
-                GenerateSQL(2));
+        cmp->ExpectEq("select 1 + (select 1 + (select 1 as x) t0) t1", GenerateSQL(2));
     }
 };
 
-class Unnest : public ISQLFeature {
-public:
-    std::string name() override { return "unnest"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select * from (select 1 x) t";
-        for (size_t i = 0; i < n; i++) {
-            sql_.append(", unnest(array [x]) t" + std::to_string(i));
-        }
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select * from (select 1 x) t, unnest(array [x]) t0, unnest(array [x]) t1",
-                GenerateSQL(2));
-    }
-};
+constexpr auto kCTE = FeatureSpec("CTE").Prefix("with ")
+        .FirstUnit("t0 as (select 1 as x) ").Unit("t{i} as (select * from t{i-1})").Separator(", ")
+        .Suffix(" select * from t0")
+        .Fragment(FragmentKind::QUERY).Hole(FragmentKind::QUERY, "select 1 as x")
+        .Example(3, "with t0 as (select 1 as x) , t1 as (select * from t0), t2 as (select * from t1) select * from t0");
 
-class UnnestList : public ISQLFeature {
+class RecursiveCTE : public ISQLFeature {
 public:
-    std::string name() override { return "unnest list"; }
+    std::string name() override { return "recursive CTE"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select * from unnest(array[1]";
-        for (size_t i = 1; i < n; i++) {
-            sql_.append(", array [1]");
-        }
-        sql_.append(")");
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder(&sql_).Clear()
+                .Append("with recursive r as (select 1 x union all select x + 1 from r where x < ")
+                .AppendNumber(n)
+                .Append(") select max(x) from r");
         return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
         cmp->ExpectEq(
-                "select * from unnest(array[1], array [1], array [1])",
-                GenerateSQL(3));
+                "with recursive r as (select 1 x union all select x + 1 from r where x < 100) select max(x) from r",
+                GenerateSQL(100));
     }
 };
 
-class Windows : public ISQLFeature {
-public:
-    std::string name() override { return "windows"; }
-
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select x";
-        for (size_t i = 1; i <= n; i++) {
-            sql_.append(", row_number() over (order by x+" + std::to_string(i) + ")");
-        }
-        sql_.append(" from (select 1 x) t");
-        return sql_;
-    }
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select x, row_number() over (order by x+1), row_number() over (order by x+2) from (select 1 x) t",
-                GenerateSQL(2));
-    }
-};
+constexpr auto kGroupByList = FeatureSpec("GROUP BY list").Prefix("select x from (select 1 x) t group by ")
+        .FirstUnit("x").Unit("x+{i}").Separator(",")
+        .Example(3, "select x from (select 1 x) t group by x,x+1,x+2");
+
+constexpr auto kGroupingSets = FeatureSpec("GROUPING SETS").Prefix("select x from (select 1 x) t group by grouping sets (")
+        .FirstUnit("(x)").Unit("(x+{i})").Separator(",").Suffix(")")
+        .Example(3, "select x from (select 1 x) t group by grouping sets ((x),(x+1),(x+2))");
+
+constexpr auto kRollup = FeatureSpec("ROLLUP").Prefix("select x from (select 1 x) t group by rollup (")
+        .FirstUnit("(x)").Unit("(x+{i})").Separator(",").Suffix(")")
+        .Example(3, "select x from (select 1 x) t group by rollup ((x),(x+1),(x+2))");
+
+constexpr auto kCube = FeatureSpec("CUBE").Prefix("select x from (select 1 x) t group by cube (")
+        .FirstUnit("(x)").Unit("(x+{i})").Separator(",").Suffix(")")
+        .Example(3, "select x from (select 1 x) t group by cube ((x),(x+1),(x+2))");
+
+constexpr auto kOrderByList = FeatureSpec("ORDER BY list").Prefix("select x from (select 1 x) t order by ")
+        .FirstUnit("x").Unit("x+{i}").Separator(",")
+        .Example(3, "select x from (select 1 x) t order by x,x+1,x+2");
+
+constexpr auto kAggregation = FeatureSpec("aggregation").Prefix("select ").FirstUnit("sum(x)").Unit("sum(x+{i})").Separator(",")
+        .Suffix(" from (select 1 x) t")
+        .Example(3, "select sum(x),sum(x+1),sum(x+2) from (select 1 x) t");
+
+
+constexpr auto kUnionAll = FeatureSpec("union all").Prefix("select 1 x").Unit(" union all select 1 x")
+        .Fragment(FragmentKind::QUERY).Hole(FragmentKind::QUERY, "select 1 x")
+        .Example(2, "select 1 x union all select 1 x union all select 1 x");
+
+constexpr auto kUnion = FeatureSpec("union").Prefix("select 1 x").Unit(" union select 1 x")
+        .Fragment(FragmentKind::QUERY).Hole(FragmentKind::QUERY, "select 1 x")
+        .Example(3, "select 1 x union select 1 x union select 1 x union select 1 x");
+
+constexpr auto kExcept = FeatureSpec("except").Prefix("select 1 x").Unit(" except select 1 x")
+        .Example(1, "select 1 x except select 1 x");
+
+constexpr auto kIntersect = FeatureSpec("intersect").Prefix("select 1 x").Unit(" intersect select 1 x")
+        .Example(1, "select 1 x intersect select 1 x");
+
+constexpr auto kIntersectAll = FeatureSpec("intersect all").Prefix("select 1 x").Unit(" intersect all select 1 x")
+        .Example(1, "select 1 x intersect all select 1 x");
+
+constexpr auto kCorrelatedSubquery = FeatureSpec("correlated subquery").Prefix("select * from (select 1 x) t0 where ")
+        .Unit("exists (select 1 from (select 1 x) t{i+1} where t{i}.x = t{i+1}.x").Separator(" and ").Close(")")
+        .Example(1, "select * from (select 1 x) t0 where exists ("
+                    "select 1 from (select 1 x) t1 where t0.x = t1.x)")
+        .Example(2, "select * from (select 1 x) t0 where exists ("
+                    "select 1 from (select 1 x) t1 where t0.x = t1.x and "
+                    "exists (select 1 from (select 1 x) t2 where t1.x = t2.x))");
+
+constexpr auto kIsDistinctFrom = FeatureSpec("is distinct from").Prefix("select ")
+        .FirstUnit("").Unit("(").Middle("true").FirstClose("").Close(" is distinct from true)")
+        .Suffix(" is distinct from false")
+        .Example(1, "select true is distinct from false")
+        .Example(2, "select (true is distinct from true) is distinct from false")
+        .Example(3, "select ((true is distinct from true) is distinct from true) is distinct from false");
+
+constexpr auto kCrossJoin = FeatureSpec("cross join join").Prefix("select * from (select 1 x) t0").Unit(" cross join (select 1 x) t{i+1}")
+        .Fragment(FragmentKind::QUERY).Hole(FragmentKind::QUERY, "select 1 x")
+        .Example(4, "select * from (select 1 x) t0 "
+                    "cross join (select 1 x) t1 "
+                    "cross join (select 1 x) t2 "
+                    "cross join (select 1 x) t3 "
+                    "cross join (select 1 x) t4");
+
+constexpr auto kNaturalJoin = FeatureSpec("natural join join").Prefix("select * from (select 1 x) t0").Unit(" natural join (select 1 x) t{i+1}")
+        .Example(3, "select * from (select 1 x) t0 "
+                    "natural join (select 1 x) t1 "
+                    "natural join (select 1 x) t2 "
+                    "natural join (select 1 x) t3");
+
+constexpr auto kJoinChain = FeatureSpec("chain join").Prefix("select * from (select 1 x) t0").Unit(" join (select 1 x) t{i+1} on t{i}.x=t{i+1}.x")
+        .Fragment(FragmentKind::QUERY).Hole(FragmentKind::QUERY, "select 1 x")
+        .Example(3, "select * from (select 1 x) t0 "
+                    "join (select 1 x) t1 on t0.x=t1.x "
+                    "join (select 1 x) t2 on t1.x=t2.x "
+                    "join (select 1 x) t3 on t2.x=t3.x");
+
+constexpr auto kJoinChainRight = FeatureSpec("join chain right").Prefix("select * from (select 1 x) t0")
+        .FirstUnit("").Unit(" inner join (select 1 x) t{i}").FirstClose("").Close(" on true")
+        .Example(3, "select * from (select 1 x) t0 inner join (select 1 x) t1 inner join (select 1 x) t2 on true on true");
+
+constexpr auto kJoinStar = FeatureSpec("star join").Prefix("select * from (select 1 x) t0").Unit(" join (select 1 x) t{i+1} on t0.x=t{i+1}.x")
+        .Example(3, "select * from (select 1 x) t0 "
+                    "join (select 1 x) t1 on t0.x=t1.x "
+                    "join (select 1 x) t2 on t0.x=t2.x "
+                    "join (select 1 x) t3 on t0.x=t3.x");
+
+constexpr auto kInnerJoin = FeatureSpec("inner join join").Prefix("select * from (select 1 x) t0").Unit(" inner join (select 1 x) t{i+1} using (x)")
+        .Example(3, "select * from (select 1 x) t0 "
+                    "inner join (select 1 x) t1 using (x) "
+                    "inner join (select 1 x) t2 using (x) "
+                    "inner join (select 1 x) t3 using (x)");
+
+constexpr auto kLeftOuterJoin = FeatureSpec("left outer join join").Prefix("select * from (select 1 x) t0").Unit(" left outer join (select 1 x) t{i+1} using (x)")
+        .Example(1, "select * from (select 1 x) t0 "
+                    "left outer join (select 1 x) t1 using (x)");
+
+constexpr auto kRightOuterJoin = FeatureSpec("right outer join join").Prefix("select * from (select 1 x) t0").Unit(" right outer join (select 1 x) t{i+1} using (x)")
+        .Example(2, "select * from (select 1 x) t0 "
+                    "right outer join (select 1 x) t1 using (x) "
+                    "right outer join (select 1 x) t2 using (x)");
+
+constexpr auto kFullOuterJoin = FeatureSpec("full outer join join").Prefix("select * from (select 1 x) t0").Unit(" full outer join (select 1 x) t{i+1} using (x)")
+        .Example(1, "select * from (select 1 x) t0 "
+                    "full outer join (select 1 x) t1 using (x)");
+
+constexpr auto kLateralJoin = FeatureSpec("lateral join").Prefix("select * from (select 1 x) t0").Unit(" , lateral (select 1 x) t{i+1}")
+        .Example(2, "select * from (select 1 x) t0 "
+                    ", lateral (select 1 x) t1 "
+                    ", lateral (select 1 x) t2");
+
+constexpr auto kInSemiJoin = FeatureSpec("in semijoin").Prefix("select * from (select 1 as x) t0")
+        .Unit(" where x in (select * from (select 1 as x) t{i+1}").Close(")")
+        .Example(3, "select * from (select 1 as x) t0 "
+                    "where x in (select * from (select 1 as x) t1 "
+                    "where x in (select * from (select 1 as x) t2 "
+                    "where x in (select * from (select 1 as x) t3)))");
+
+constexpr auto kExistsSemiJoin = FeatureSpec("exists semijoin").Prefix("select * from (select 1 as x) t0")
+        .Unit(" where exists (select * from (select 1 as x) t{i+1}").Close(")")
+        .Example(2, "select * from (select 1 as x) t0 "
+                    "where exists (select * from (select 1 as x) t1 "
+                    "where exists (select * from (select 1 as x) t2))");
+
+constexpr auto kAnySemiJoin = FeatureSpec("any semijoin").Prefix("select * from (select 1 as x) t0")
+        .Unit(" where x > any (select * from (select 1 as x) t{i+1}").Close(")")
+        .Example(2, "select * from (select 1 as x) t0 "
+                    "where x > any (select * from (select 1 as x) t1 "
+                    "where x > any (select * from (select 1 as x) t2))");
+
+constexpr auto kAllSemiJoin = FeatureSpec("all semijoin").Prefix("select * from (select 1 as x) t0")
+        .Unit(" where x < all (select * from (select 1 as x) t{i+1}").Close(")")
+        .Example(2, "select * from (select 1 as x) t0 "
+                    "where x < all (select * from (select 1 as x) t1 "
+                    "where x < all (select * from (select 1 as x) t2))");
+
+constexpr auto kUnnest = FeatureSpec("unnest").Prefix("select * from (select 1 x) t").Unit(", unnest(array [x]) t{i}")
+        .Example(2, "select * from (select 1 x) t, unnest(array [x]) t0, unnest(array [x]) t1");
+
+constexpr auto kUnnestList = FeatureSpec("unnest list").Prefix("select * from unnest(")
+        .FirstUnit("array[1]").Unit("array [1]").Separator(", ").Suffix(")")
+        .Example(3, "select * from unnest(array[1], array [1], array [1])");
+
+constexpr auto kWindows = FeatureSpec("windows").Prefix("select x").Unit(", row_number() over (order by x+{i+1})")
+        .Suffix(" from (select 1 x) t")
+        .Example(2, "select x, row_number() over (order by x+1), row_number() over (order by x+2) from (select 1 x) t");
 
 class NamedWindow : public ISQLFeature {
 public:
     std::string name() override { return "named window"; }
 
-    std::string GenerateSQL(size_t n) override {
-        sql_ = "select row_number() over w" + std::to_string(n) + " window w0 as (order by 1)";
+    std::string_view GenerateSQL(size_t n) override {
+        SqlBuilder sql(&sql_);
+        sql.Clear().Reserve(kFixedSize + n * 19 + SqlBuilder::DigitsInRange(1, n + 1));
+        sql.Append("select row_number() over w").AppendNumber(n).Append(" window w0 as (order by 1)");
         for (size_t i = 1; i <= n; i++) {
-            sql_.append(" ,w" + std::to_string(i) + " as (order by 1)");
+            sql.Append(" ,w").AppendNumber(i).Append(" as (order by 1)");
         }
         return sql_;
     }
@@ -1844,25 +895,19 @@ public:
     }
 };
 
-class ExceptAll : public RelOperator {
-public:
-    ExceptAll() : RelOperator("except all") {}
-
-    void SelfTest(ITestComparer *cmp) override {
-        cmp->ExpectEq(
-                "select 1 x except all select 1 x",
-                GenerateSQL(1));
-    }
-};
+constexpr auto kExceptAll = FeatureSpec("except all").Prefix("select 1 x").Unit(" except all select 1 x")
+        .Example(1, "select 1 x except all select 1 x");
 
 // Tests the limit of format() output size.
 class FormatOutputSize : public ISQLFeature {
 public:
     std::string name() override { return "format output size"; }
 
-    std::string GenerateSQL(size_t n) override {
-        const std::string w = std::to_string(n * 1048576);  // n MiB per specifier
-        return "select length(format('%" + w + "s%" + w + "s', 'x', 'x'))";
+    std::string_view GenerateSQL(size_t n) override {
+        const size_t w = n * 1048576;  // n MiB per specifier
+        SqlBuilder(&sql_).Clear().Append("select length(format('%").AppendNumber(w).Append("s%").AppendNumber(w).Append(
+                "s', 'x', 'x'))");
+        return sql_;
     }
 
     void SelfTest(ITestComparer *cmp) override {
@@ -1872,120 +917,139 @@ public:
 
 std::vector<std::unique_ptr<ISQLFeature>> GetBuiltinFeatures() {
     std::vector<std::unique_ptr<ISQLFeature>> features;
-    features.emplace_back(std::make_unique<Comment>());
-    features.emplace_back(std::make_unique<Identifier>());
-    features.emplace_back(std::make_unique<Parenthesis>());
+    features.emplace_back(std::make_unique<SpecFeature<kComment>>());
+    features.emplace_back(std::make_unique<SpecFeature<kIdentifier>>());
+    features.emplace_back(std::make_unique<SpecFeature<kParenthesis>>());
     features.emplace_back(std::make_unique<PositiveIntegerLiteral>());
     features.emplace_back(std::make_unique<NegativeIntegerLiteral>());
-    features.emplace_back(std::make_unique<NumericLiteral>());
+    features.emplace_back(std::make_unique<SpecFeature<kNumericLiteral>>());
     features.emplace_back(std::make_unique<NumericPrecision>());
     features.emplace_back(std::make_unique<FloatLiteral>());
     features.emplace_back(std::make_unique<FloatPositiveExp>());
     features.emplace_back(std::make_unique<FloatNegativeExp>());
-    features.emplace_back(std::make_unique<TextLiteral>());
-    features.emplace_back(std::make_unique<ByteaLiteral>());
+    features.emplace_back(std::make_unique<SpecFeature<kTextLiteral>>());
+    features.emplace_back(std::make_unique<SpecFeature<kByteaLiteral>>());
     features.emplace_back(std::make_unique<FutureDateLiteral>());
     features.emplace_back(std::make_unique<PastDateLiteral>());
     features.emplace_back(std::make_unique<FutureTimestampLiteral>());
     features.emplace_back(std::make_unique<PastTimestampLiteral>());
-    features.emplace_back(std::make_unique<Array>());
-    features.emplace_back(std::make_unique<NestedArray>());
-    features.emplace_back(std::make_unique<NestedStruct>());
+    features.emplace_back(std::make_unique<SpecFeature<kArray>>());
+    features.emplace_back(std::make_unique<SpecFeature<kNestedArray>>());
+    features.emplace_back(std::make_unique<SpecFeature<kNestedStruct>>());
     features.emplace_back(std::make_unique<MixedStructArray>());
-    features.emplace_back(std::make_unique<WideStruct>());
-    features.emplace_back(std::make_unique<NestedJson>());
-    features.emplace_back(std::make_unique<WideJson>());
+    features.emplace_back(std::make_unique<SpecFeature<kWideStruct>>());
+    features.emplace_back(std::make_unique<SpecFeature<kNestedJson>>());
+    features.emplace_back(std::make_unique<SpecFeature<kWideJson>>());
     features.emplace_back(std::make_unique<JsonSetChain>());
-    features.emplace_back(std::make_unique<JsonEach>());
-    features.emplace_back(std::make_unique<DollarString>());
-    features.emplace_back(std::make_unique<BetweenChain>());
+    features.emplace_back(std::make_unique<SpecFeature<kJsonEach>>());
+    features.emplace_back(std::make_unique<SpecFeature<kDollarString>>());
+    features.emplace_back(std::make_unique<SpecFeature<kBetweenChain>>());
     features.emplace_back(std::make_unique<GenerateSeries>());
     features.emplace_back(std::make_unique<WideCreateTable>());
-    features.emplace_back(std::make_unique<Tuple>());
-    features.emplace_back(std::make_unique<NestedTuple>());
-    features.emplace_back(std::make_unique<SelectList>());
-    features.emplace_back(std::make_unique<UnaryPlus>());
-    features.emplace_back(std::make_unique<UnaryMinus>());
-    features.emplace_back(std::make_unique<LogicalNot>());
-    features.emplace_back(std::make_unique<BitwiseNot>());
-    features.emplace_back(std::make_unique<AbsOperator>());
-    features.emplace_back(std::make_unique<SquareRootOperator>());
-    features.emplace_back(std::make_unique<CubeRootOperator>());
-    features.emplace_back(std::make_unique<Plus>());
-    features.emplace_back(std::make_unique<Minus>());
-    features.emplace_back(std::make_unique<Multiply>());
-    features.emplace_back(std::make_unique<Divide>());
-    features.emplace_back(std::make_unique<Modulo>());
-    features.emplace_back(std::make_unique<Power>());
-    features.emplace_back(std::make_unique<LogicalAnd>());
-    features.emplace_back(std::make_unique<LogicalOr>());
-    features.emplace_back(std::make_unique<Is>());
-    features.emplace_back(std::make_unique<BitwiseAnd>());
-    features.emplace_back(std::make_unique<BitwiseOr>());
-    features.emplace_back(std::make_unique<BitwiseXor>());
-    features.emplace_back(std::make_unique<BitwiseShiftLeft>());
-    features.emplace_back(std::make_unique<BitwiseShiftRight>());
-    features.emplace_back(std::make_unique<TextConcat>());
-    features.emplace_back(std::make_unique<ArrayConcat>());
-    features.emplace_back(std::make_unique<Abs>());
-    features.emplace_back(std::make_unique<Repeat>());
-    features.emplace_back(std::make_unique<Replace>());
+    features.emplace_back(std::make_unique<SpecFeature<kTuple>>());
+    features.emplace_back(std::make_unique<SpecFeature<kNestedTuple>>());
+    features.emplace_back(std::make_unique<SpecFeature<kSelectList>>());
+    features.emplace_back(std::make_unique<SpecFeature<kUnaryPlus>>());
+    features.emplace_back(std::make_unique<SpecFeature<kUnaryMinus>>());
+    features.emplace_back(std::make_unique<SpecFeature<kLogicalNot>>());
+    features.emplace_back(std::make_unique<SpecFeature<kBitwiseNot>>());
+    features.emplace_back(std::make_unique<SpecFeature<kAbsOperator>>());
+    features.emplace_back(std::make_unique<SpecFeature<kSquareRootOperator>>());
+    features.emplace_back(std::make_unique<SpecFeature<kCubeRootOperator>>());
+    features.emplace_back(std::make_unique<SpecFeature<kPlus>>());
+    features.emplace_back(std::make_unique<SpecFeature<kMinus>>());
+    features.emplace_back(std::make_unique<SpecFeature<kMultiply>>());
+    features.emplace_back(std::make_unique<SpecFeature<kDivide>>());
+    features.emplace_back(std::make_unique<SpecFeature<kModulo>>());
+    features.emplace_back(std::make_unique<SpecFeature<kPower>>());
+    features.emplace_back(std::make_unique<SpecFeature<kLogicalAnd>>());
+    features.emplace_back(std::make_unique<SpecFeature<kLogicalOr>>());
+    features.emplace_back(std::make_unique<SpecFeature<kIs>>());
+    features.emplace_back(std::make_unique<SpecFeature<kBitwiseAnd>>());
+    features.emplace_back(std::make_unique<SpecFeature<kBitwiseOr>>());
+    features.emplace_back(std::make_unique<SpecFeature<kBitwiseXor>>());
+    features.emplace_back(std::make_unique<SpecFeature<kBitwiseShiftLeft>>());
+    features.emplace_back(std::make_unique<SpecFeature<kBitwiseShiftRight>>());
+    features.emplace_back(std::make_unique<SpecFeature<kTextConcat>>());
+    features.emplace_back(std::make_unique<SpecFeature<kArrayConcat>>());
+    features.emplace_back(std::make_unique<SpecFeature<kAbs>>());
+    features.emplace_back(std::make_unique<StringRepeat>());
+    features.emplace_back(std::make_unique<SpecFeature<kReplace>>());
     features.emplace_back(std::make_unique<LPad>());
     features.emplace_back(std::make_unique<RPad>());
     features.emplace_back(std::make_unique<Format>());
-    features.emplace_back(std::make_unique<Trim>());
-    features.emplace_back(std::make_unique<DateTrunc>());
-    features.emplace_back(std::make_unique<AtTimeZone>());
-    features.emplace_back(std::make_unique<Cast>());
-    features.emplace_back(std::make_unique<CastNestedArray>());
-    features.emplace_back(std::make_unique<CastOperator>());
+    features.emplace_back(std::make_unique<SpecFeature<kTrim>>());
+    features.emplace_back(std::make_unique<SpecFeature<kDateTrunc>>());
+    features.emplace_back(std::make_unique<SpecFeature<kAtTimeZone>>());
+    features.emplace_back(std::make_unique<SpecFeature<kCast>>());
+    features.emplace_back(std::make_unique<SpecFeature<kCastNestedArray>>());
+    features.emplace_back(std::make_unique<SpecFeature<kCastOperator>>());
     features.emplace_back(std::make_unique<StringAgg>());
     features.emplace_back(std::make_unique<ArrayAgg>());
-    features.emplace_back(std::make_unique<InList>());
+    features.emplace_back(std::make_unique<SpecFeature<kInList>>());
     features.emplace_back(std::make_unique<Coalesce>());
-    features.emplace_back(std::make_unique<Greatest>());
-    features.emplace_back(std::make_unique<SimpleCase>());
-    features.emplace_back(std::make_unique<SearchedCase>());
+    features.emplace_back(std::make_unique<SpecFeature<kGreatest>>());
+    features.emplace_back(std::make_unique<SpecFeature<kSimpleCase>>());
+    features.emplace_back(std::make_unique<SpecFeature<kSearchedCase>>());
+    features.emplace_back(std::make_unique<SpecFeature<kNestedCase>>());
     features.emplace_back(std::make_unique<SubSelectFrom>());
-    features.emplace_back(std::make_unique<SubSelectScalar>());
+    features.emplace_back(std::make_unique<SpecFeature<kSubSelectScalar>>());
     features.emplace_back(std::make_unique<SubSelectInExpr>());
-    features.emplace_back(std::make_unique<CTE>());
+    features.emplace_back(std::make_unique<SpecFeature<kCTE>>());
     features.emplace_back(std::make_unique<RecursiveCTE>());
-    features.emplace_back(std::make_unique<GroupByList>());
-    features.emplace_back(std::make_unique<GroupingSets>());
-    features.emplace_back(std::make_unique<Rollup>());
-    features.emplace_back(std::make_unique<Cube>());
-    features.emplace_back(std::make_unique<OrderByList>());
-    features.emplace_back(std::make_unique<Aggregation>());
-    features.emplace_back(std::make_unique<UnionAll>());
-    features.emplace_back(std::make_unique<Union>());
-    features.emplace_back(std::make_unique<Except>());
-    features.emplace_back(std::make_unique<Intersect>());
-    features.emplace_back(std::make_unique<IntersectAll>());
-    features.emplace_back(std::make_unique<ExceptAll>());
-    features.emplace_back(std::make_unique<CorrelatedSubquery>());
-    features.emplace_back(std::make_unique<IsDistinctFrom>());
-    features.emplace_back(std::make_unique<CrossJoin>());
-    features.emplace_back(std::make_unique<NaturalJoin>());
-    features.emplace_back(std::make_unique<JoinChain>());
-    features.emplace_back(std::make_unique<JoinChainRight>());
-    features.emplace_back(std::make_unique<JoinStar>());
-    features.emplace_back(std::make_unique<InnerJoin>());
-    features.emplace_back(std::make_unique<LeftOuterJoin>());
-    features.emplace_back(std::make_unique<RightOuterJoin>());
-    features.emplace_back(std::make_unique<FullOuterJoin>());
-    features.emplace_back(std::make_unique<LateralJoin>());
-    features.emplace_back(std::make_unique<InSemiJoin>());
-    features.emplace_back(std::make_unique<ExistsSemiJoin>());
-    features.emplace_back(std::make_unique<AnySemiJoin>());
-    features.emplace_back(std::make_unique<AllSemiJoin>());
-    features.emplace_back(std::make_unique<Unnest>());
-    features.emplace_back(std::make_unique<UnnestList>());
-    features.emplace_back(std::make_unique<Windows>());
+    features.emplace_back(std::make_unique<SpecFeature<kGroupByList>>());
+    features.emplace_back(std::make_unique<SpecFeature<kGroupingSets>>());
+    features.emplace_back(std::make_unique<SpecFeature<kRollup>>());
+    features.emplace_back(std::make_unique<SpecFeature<kCube>>());
+    features.emplace_back(std::make_unique<SpecFeature<kOrderByList>>());
+    features.emplace_back(std::make_unique<SpecFeature<kAggregation>>());
+    features.emplace_back(std::make_unique<SpecFeature<kUnionAll>>());
+    features.emplace_back(std::make_unique<SpecFeature<kUnion>>());
+    features.emplace_back(std::make_unique<SpecFeature<kExcept>>());
+    features.emplace_back(std::make_unique<SpecFeature<kIntersect>>());
+    features.emplace_back(std::make_unique<SpecFeature<kIntersectAll>>());
+    features.emplace_back(std::make_unique<SpecFeature<kExceptAll>>());
+    features.emplace_back(std::make_unique<SpecFeature<kCorrelatedSubquery>>());
+    features.emplace_back(std::make_unique<SpecFeature<kIsDistinctFrom>>());
+    features.emplace_back(std::make_unique<SpecFeature<kCrossJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kNaturalJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kJoinChain>>());
+    features.emplace_back(std::make_unique<SpecFeature<kJoinChainRight>>());
+    features.emplace_back(std::make_unique<SpecFeature<kJoinStar>>());
+    features.emplace_back(std::make_unique<SpecFeature<kInnerJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kLeftOuterJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kRightOuterJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kFullOuterJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kLateralJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kInSemiJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kExistsSemiJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kAnySemiJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kAllSemiJoin>>());
+    features.emplace_back(std::make_unique<SpecFeature<kUnnest>>());
+    features.emplace_back(std::make_unique<SpecFeature<kUnnestList>>());
+    features.emplace_back(std::make_unique<SpecFeature<kWindows>>());
     features.emplace_back(std::make_unique<NamedWindow>());
     features.emplace_back(std::make_unique<FormatOutputSize>());
 
     return features;
 }
 
+constexpr auto kSelectListColumns = FeatureSpec("select list").Prefix("select 1 x").Unit(",1")
+        .Fragment(FragmentKind::QUERY);
+constexpr auto kSelectListColumnsAs = FeatureSpec("select list").Prefix("select 1 as x").Unit(",1")
+        .Fragment(FragmentKind::QUERY);
+
+std::vector<std::unique_ptr<IMultiSQLFeature>> GetBuiltinMultiFeatures() {
+    std::vector<std::unique_ptr<IMultiSQLFeature>> features;
+    features.emplace_back(Nest(std::make_unique<SpecFeature<kJoinChain>>(),
+                               std::make_unique<SpecFeature<kSelectListColumns>>()));
+    features.emplace_back(Nest(std::make_unique<SpecFeature<kUnionAll>>(),
+                               std::make_unique<SpecFeature<kSelectListColumns>>()));
+    features.emplace_back(Nest(std::make_unique<SubSelectFrom>(), std::make_unique<SpecFeature<kSelectListColumnsAs>>(),
+                               "subselect in FROM x select list"));
+    features.emplace_back(Nest(std::make_unique<SpecFeature<kLogicalOr>>(), std::make_unique<SpecFeature<kInList>>(),
+                               "OR chain x IN list"));
+    return features;
+}
+
 }   // namespace tensile
@@ -1,4 +1,7 @@
 #include <gtest/gtest.h>
+#include <map>
+#include "feature_spec.h"
+#include "sql_builder.h"
 #include "tensile.h"
 
 namespace tensile {
@@ -6,7 +9,7 @@ namespace {
 
 class GUnitComparer : public ITestComparer {
 public:
-    void ExpectEq(const std::string& expected, const std::string& actual) override {
+    void ExpectEq(std::string_view expected, std::string_view actual) override {
         EXPECT_EQ(expected, actual);
     }
 };
@@ -28,6 +31,79 @@ TEST(Features, NonEmpty) {
     EXPECT_FALSE(GetBuiltinFeatures().empty());
 }
 
+// Features reuse the previous probe's SQL, so walk them through a doubling and bisection
+// like sequence and compare every step against a feature that never generated anything.
+TEST(Features, IncrementalMatchesFresh) {
+    auto features = GetBuiltinFeatures();
+    for (size_t k = 0; k < features.size(); k++) {
+        SCOPED_TRACE(features[k]->name());
+        if (features[k]->is_exponential()) continue;
+        for (size_t n : {1, 2, 4, 64, 128, 256, 200, 129, 130, 127, 3, 65, 64, 1000, 1}) {
+            auto fresh = GetBuiltinFeatures();
+            EXPECT_EQ(fresh[k]->GenerateSQL(n), features[k]->GenerateSQL(n)) << "n=" << n;
+        }
+    }
+}
+
+constexpr auto kSpecTest = FeatureSpec("spec test").Prefix("select ").FirstUnit("f(").Unit("g{i}(t{i-1}, ")
+        .Middle("x").FirstClose(")").Close(", {i+1})").Separator(" ");
+
+// Large statements are filled in slices on several threads, which must not change the output.
+TEST(Features, ParallelMatchesSerial) {
+    auto serial = GetBuiltinFeatures();
+    auto parallel = GetBuiltinFeatures();
+    for (size_t k = 0; k < serial.size(); k++) {
+        SCOPED_TRACE(serial[k]->name());
+        if (serial[k]->is_exponential() || !dynamic_cast<IncrementalSQLFeature *>(serial[k].get())) continue;
+        parallel[k]->set_generation_threads(4);
+        for (size_t n : {120000, 30000, 150000}) {
+            EXPECT_EQ(serial[k]->GenerateSQL(n), parallel[k]->GenerateSQL(n)) << "n=" << n;
+        }
+    }
+}
+
+TEST(FeatureSpec, PlaceholdersAndExactSize) {
+    SpecFeature<kSpecTest> feature;
+    EXPECT_EQ("select f(x)", feature.GenerateSQL(1));
+    EXPECT_EQ("select f( g1(t0,  g2(t1, x, 3), 2))", feature.GenerateSQL(3));
+    for (size_t n : {1, 9, 10, 11, 99, 100, 1001, 10000}) {
+        EXPECT_EQ(SpecFeature<kSpecTest>::Size(n), feature.GenerateSQL(n).size()) << "n=" << n;
+    }
+    static_assert(SpecFeature<kSpecTest>::Size(3) == sizeof("select f( g1(t0,  g2(t1, x, 3), 2))") - 1);
+}
+
+TEST(SqlBuilder, AppendsAndKeepsBuffer) {
+    std::string sql;
+    SqlBuilder builder(&sql);
+    builder.Reserve(64).Append("select ").AppendNumber(7).Append(", ").AppendNumber(42, 4).Repeat(",1", 3);
+    EXPECT_EQ("select 7, 0042,1,1,1", sql);
+    const size_t capacity = sql.capacity();
+    builder.Clear().Repeat("ab", 0).AppendNumber(0);
+    EXPECT_EQ("0", sql);
+    EXPECT_EQ(capacity, sql.capacity());
+    EXPECT_EQ(SqlBuilder::DigitsInRange(0, 1000), 10 + 90 * 2 + 900 * 3);
+    EXPECT_EQ(SqlBuilder::Digits(std::numeric_limits<size_t>::max()), SqlBuilder::kMaxDigits);
+}
+
+TEST(MultiFeatures, GenerateSQL) {
+    std::map<std::string, std::pair<std::vector<size_t>, std::string>> expected = {
+            {"chain join x select list",
+             {{1, 2}, "select * from (select 1 x,1,1) t0 join (select 1 x,1,1) t1 on t0.x=t1.x"}},
+            {"union all x select list", {{1, 1}, "select 1 x,1 union all select 1 x,1"}},
+            {"subselect in FROM x select list", {{2, 1}, "select * from (select * from (select 1 as x,1) t0) t1"}},
+            {"OR chain x IN list", {{1, 2}, "select 1 in (2,2) OR 1 in (2,2)"}},
+    };
+    auto features = GetBuiltinMultiFeatures();
+    EXPECT_EQ(expected.size(), features.size());
+    for (auto &feature : features) {
+        SCOPED_TRACE(feature->name());
+        EXPECT_EQ(2, feature->dimension_names().size());
+        auto it = expected.find(feature->name());
+        ASSERT_NE(expected.end(), it);
+        EXPECT_EQ(it->second.second, feature->GenerateSQL(it->second.first));
+    }
+}
+
 TEST(SetOp, IntersectGenerateSQL) {
     auto features = GetBuiltinFeatures();
     for (auto& feature : features) {
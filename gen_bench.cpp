@@ -0,0 +1,160 @@
+// Throughput of the builtin SQL generators.
+//
+// Every feature is benchmarked at log-spaced @n. An iteration generates SQL for @n starting
+// from @n = 1, so features that reuse the previous statement still build the whole of it.
+// Reported per feature and @n:
+//     bytes_per_second - size of the SQL for @n over the time to generate it
+//     allocs           - heap allocations per iteration
+// After all runs, features whose time per byte keeps growing with @n are listed, which usually
+// means quadratic generation.
+//
+// FindUnbalanced is also benchmarked on 16 MiB statements of a few features with every
+// instruction set the CPU supports, to compare with memory bandwidth.
+#include <benchmark/benchmark.h>
+#include "composition.h"
+#include "sql_lexer.h"
+#include "tensile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+
+namespace {
+
+size_t allocations = 0;
+
+}  // namespace
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace tensile {
+namespace {
+
+constexpr int64_t kMinN = 8;
+constexpr int64_t kMaxN = 1 << 20;
+// Exponential features double their SQL with every step of @n
+constexpr int64_t kMaxExponentialN = 20;
+constexpr int kRangeMultiplier = 8;
+// Growth of time per byte over the last kGrowthSteps steps of @n, above which the feature is
+// reported. Quadratic generators grow by about kRangeMultiplier per step, while falling out of
+// caches costs at most a few tens in total.
+constexpr size_t kGrowthSteps = 3;
+constexpr double kGrowthThreshold = 64.0;
+
+void BM_Generate(benchmark::State &state, ISQLFeature *feature) {
+    const size_t n = state.range(0);
+    size_t bytes = 0;
+    const size_t allocations_before = allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(feature->GenerateSQL(1));
+        auto sql = feature->GenerateSQL(n);
+        bytes = sql.size();
+        benchmark::DoNotOptimize(sql);
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.counters["allocs"] = benchmark::Counter(allocations - allocations_before,
+                                                  benchmark::Counter::kAvgIterations);
+}
+
+constexpr size_t kValidateSize = 16 << 20;
+const char *const kValidateFeatures[] = {"parenthesis", "mixed struct/array", "text literal", "comment",
+                                         "union all"};
+
+// @sql is generated once by the caller, with the largest @n below kValidateSize bytes.
+void BM_FindUnbalanced(benchmark::State &state, const std::string *sql, lexer_internal::Isa isa) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lexer_internal::FindUnbalanced(*sql, nullptr, isa));
+    }
+    state.SetBytesProcessed(state.iterations() * sql->size());
+}
+
+// SQL of @feature just below kValidateSize bytes.
+std::string GenerateForValidation(ISQLFeature *feature) {
+    size_t lo = 1, hi = 2;
+    while (feature->GenerateSQL(hi).size() < kValidateSize) lo = hi, hi *= 2;
+    while (hi - lo > 1) {
+        const size_t n = lo + (hi - lo) / 2;
+        (feature->GenerateSQL(n).size() < kValidateSize ? lo : hi) = n;
+    }
+    return std::string(feature->GenerateSQL(lo));
+}
+
+// Console reporter which also keeps time per byte of every run, grouped by feature.
+class GrowthReporter : public benchmark::ConsoleReporter {
+public:
+    void ReportRuns(const std::vector<Run> &runs) override {
+        ConsoleReporter::ReportRuns(runs);
+        for (const auto &run : runs) {
+            auto bps = run.counters.find("bytes_per_second");
+            if (run.error_occurred || bps == run.counters.end() || bps->second.value <= 0) continue;
+            series_[run.run_name.function_name].push_back({run.run_name.args, 1e9 / bps->second.value});
+        }
+    }
+
+    // Prints features whose cost per byte grows with @n.
+    void PrintGrowing() const {
+        int growing = 0;
+        for (const auto &[name, points] : series_) {
+            if (points.size() <= kGrowthSteps) continue;
+            const size_t first = points.size() - 1 - kGrowthSteps;
+            if (points.back().ns_per_byte < kGrowthThreshold * points[first].ns_per_byte) continue;
+            if (growing++ == 0) std::printf("\nGenerators with cost per byte growing with n:\n");
+            std::printf("  %s: %.3f ns/byte at %s, %.3f ns/byte at %s\n", name.c_str(), points[first].ns_per_byte,
+                        points[first].n.c_str(), points.back().ns_per_byte, points.back().n.c_str());
+        }
+    }
+
+private:
+    struct Point {
+        std::string n;
+        double ns_per_byte;
+    };
+    std::map<std::string, std::vector<Point>> series_;
+};
+
+}  // namespace
+}  // namespace tensile
+
+int main(int argc, char **argv) {
+    using namespace tensile;
+    auto features = GetBuiltinFeatures();
+    std::map<std::string, int> seen;
+    for (auto &feature : features) {
+        // Several features share a name, and results are grouped by it
+        std::string name = feature->name();
+        if (int count = seen[name]++) name += " #" + std::to_string(count + 1);
+        benchmark::RegisterBenchmark(name.c_str(), BM_Generate, feature.get())
+                ->ArgName("n")
+                ->RangeMultiplier(kRangeMultiplier)
+                ->Range(kMinN, feature->is_exponential() ? kMaxExponentialN : kMaxN);
+    }
+    std::vector<std::string> validate_sql;
+    validate_sql.reserve(std::size(kValidateFeatures));
+    for (const char *name : kValidateFeatures) {
+        validate_sql.push_back(GenerateForValidation(GetFeature(name).get()));
+        const std::pair<lexer_internal::Isa, const char *> isas[] = {
+                {lexer_internal::Isa::SCALAR, "scalar"}, {lexer_internal::Isa::SSE2, "sse2"},
+                {lexer_internal::Isa::AVX2, "avx2"}};
+        for (const auto &[isa, isa_name] : isas) {
+            if (isa > lexer_internal::BestIsa()) continue;
+            benchmark::RegisterBenchmark(("FindUnbalanced/" + std::string(name) + "/" + isa_name).c_str(),
+                                         BM_FindUnbalanced, &validate_sql.back(), isa);
+        }
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    GrowthReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+    reporter.PrintGrowing();
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Overhead of the driver itself: a provider which does nothing is checked through every isolation
+// mode, while the driver's process holds a resident heap of 10 MiB, 1 GiB or 8 GiB, since the
+// cost of forking grows with the memory of the parent. Heaps larger than the available memory are
+// skipped. Reported per mode and heap size:
+//     items_per_second - probes per second
+//     p50_us, p99_us   - time between consecutive probes of a search, in microseconds; not
+//                        reported for batches, whose probes complete together
+// Modes:
+//     in_process - Driver::Run without crash checks
+//     fork       - Driver::Run with crash checks, one checker process per statement
+//     fork_batch - Driver::Replay with crash checks, one checker process per batch
+// Fork is the cost of a bare fork and wait of a child which exits at once, at the same heap sizes.
+#include <benchmark/benchmark.h>
+#include "tensile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace tensile {
+namespace {
+
+constexpr size_t kMiB = 1 << 20;
+constexpr int64_t kHeapSizesMiB[] = {10, 1024, 8192};
+// Probes of a replay, a few batches long
+constexpr size_t kReplayProbes = 64;
+
+class NoopProvider : public ISQLProvider {
+public:
+    std::string name() const override { return "noop"; }
+    bool Run(std::string_view sql, std::string *error_msg) override { return true; }
+};
+
+// Same statement of a few bytes for every @n, so that generation costs nothing
+class ConstantFeature : public ISQLFeature {
+public:
+    std::string name() override { return "constant"; }
+    std::string_view GenerateSQL(size_t n) override { return "select 1"; }
+};
+
+class ProbeTimer : public IProbeListener {
+public:
+    void OnProbe(const Probe &probe) override {
+        const auto now = std::chrono::steady_clock::now();
+        if (probes_++ > 0) intervals_.push_back(std::chrono::duration<double, std::micro>(now - last_).count());
+        last_ = now;
+    }
+
+    // Starts a new search, whose first probe has no interval
+    void Restart() { probes_ = 0; }
+
+    double Percentile(double p) {
+        if (intervals_.empty()) return 0;
+        const size_t k = std::min(intervals_.size() - 1, static_cast<size_t>(p * intervals_.size()));
+        std::nth_element(intervals_.begin(), intervals_.begin() + k, intervals_.end());
+        return intervals_[k];
+    }
+
+    size_t total() const { return intervals_.size(); }
+
+private:
+    size_t probes_ = 0;
+    std::chrono::steady_clock::time_point last_;
+    std::vector<double> intervals_;
+};
+
+// Resident heap of the process, touched so that every page is mapped
+std::vector<char> heap;
+
+size_t AvailableMiB() {
+    std::ifstream meminfo("/proc/meminfo");
+    for (std::string line; std::getline(meminfo, line);) {
+        std::istringstream fields(line);
+        std::string key;
+        size_t kb = 0;
+        if (fields >> key >> kb && key == "MemAvailable:") return kb / 1024;
+    }
+    return 0;
+}
+
+// Resizes the heap to @state.range(0) MiB. Returns false if it does not fit in memory.
+bool SetHeap(benchmark::State &state) {
+    const size_t size_mib = state.range(0);
+    heap.clear();
+    heap.shrink_to_fit();
+    // Leave room for the checker processes and the rest of the system
+    if (size_mib + 256 > AvailableMiB()) {
+        state.SkipWithError("not enough memory for the heap");
+        return false;
+    }
+    heap.resize(size_mib * kMiB);
+    std::memset(heap.data(), 1, heap.size());
+    return true;
+}
+
+// Driver output goes nowhere for the duration of a run
+class QuietCout {
+public:
+    QuietCout() : saved_(std::cout.rdbuf(nullptr)) {}
+    ~QuietCout() { std::cout.rdbuf(saved_); }
+
+private:
+    std::streambuf *saved_;
+};
+
+void BM_Search(benchmark::State &state, bool check_crash) {
+    if (!SetHeap(state)) return;
+    Driver driver;
+    driver.set_check_crash(check_crash);
+    auto timer = std::make_unique<ProbeTimer>();
+    ProbeTimer *probes = timer.get();
+    driver.AddProbeListener(std::move(timer));
+    NoopProvider provider;
+    ConstantFeature feature;
+    QuietCout quiet;
+    size_t searches = 0;
+    for (auto _ : state) {
+        probes->Restart();
+        driver.Run(&provider, &feature);
+        searches++;
+    }
+    // Every search has one probe more than it has intervals
+    state.SetItemsProcessed(probes->total() + searches);
+    state.counters["p50_us"] = probes->Percentile(0.5);
+    state.counters["p99_us"] = probes->Percentile(0.99);
+}
+
+void BM_Replay(benchmark::State &state) {
+    if (!SetHeap(state)) return;
+    Driver driver;
+    driver.set_check_crash(true);
+    driver.AddProvider(std::make_unique<NoopProvider>());
+    Probe probe;
+    probe.provider = "noop";
+    probe.feature = "parenthesis";
+    probe.dims = {1};
+    probe.timeout = std::chrono::milliseconds(100);
+    const std::vector<Probe> probes(kReplayProbes, probe);
+    QuietCout quiet;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(driver.Replay(probes));
+    }
+    state.SetItemsProcessed(state.iterations() * kReplayProbes);
+}
+
+void BM_Fork(benchmark::State &state) {
+    if (!SetHeap(state)) return;
+    for (auto _ : state) {
+        const pid_t pid = fork();
+        if (pid == 0) _exit(0);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+}  // namespace
+}  // namespace tensile
+
+int main(int argc, char **argv) {
+    using namespace tensile;
+    auto configure = [](benchmark::internal::Benchmark *benchmark) {
+        benchmark->ArgName("heap_mib")->UseRealTime()->Unit(benchmark::kMicrosecond);
+        for (int64_t size : kHeapSizesMiB) benchmark->Arg(size);
+    };
+    configure(benchmark::RegisterBenchmark("in_process", BM_Search, false));
+    configure(benchmark::RegisterBenchmark("fork", BM_Search, true));
+    configure(benchmark::RegisterBenchmark("fork_batch", BM_Replay));
+    configure(benchmark::RegisterBenchmark("Fork", BM_Fork));
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
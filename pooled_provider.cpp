@@ -0,0 +1,97 @@
+#include "pooled_provider.h"
+
+#include <utility>
+
+namespace tensile {
+
+PooledSQLProvider::~PooledSQLProvider() {
+    if (getpid() != pid_) {
+        // Sessions of the parent process
+        for (auto &[id, slot] : slots_) slot.session.release();
+    }
+}
+
+bool PooledSQLProvider::Run(std::string_view sql, std::string *error_msg) {
+    Slot &slot = ThreadSlot();
+    ISession *session = Acquire(&slot, error_msg);
+    if (session == nullptr) return false;
+    const bool ok = RunInSession(session, sql, error_msg);
+    Release(&slot, ok);
+    return ok;
+}
+
+void PooledSQLProvider::RunBatch(const std::vector<std::string_view> &sqls, std::vector<Status> *statuses,
+                                 std::vector<std::chrono::microseconds> *latencies) {
+    statuses->assign(sqls.size(), Status());
+    latencies->assign(sqls.size(), std::chrono::microseconds(0));
+    Slot &slot = ThreadSlot();
+    for (size_t i = 0; i < sqls.size(); i++) {
+        std::string error_msg;
+        ISession *session = Acquire(&slot, &error_msg);
+        bool ok = false;
+        if (session != nullptr) {
+            auto start = std::chrono::high_resolution_clock::now();
+            ok = RunInSession(session, sqls[i], &error_msg);
+            const auto finish = std::chrono::high_resolution_clock::now();
+            (*latencies)[i] = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+            Release(&slot, ok);
+        }
+        if (!ok) (*statuses)[i] = Status(Status::ERROR, std::move(error_msg));
+    }
+}
+
+std::chrono::microseconds PooledSQLProvider::TakeSessionTime() {
+    Slot &slot = ThreadSlot();
+    return std::exchange(slot.session_time, std::chrono::microseconds(0));
+}
+
+size_t PooledSQLProvider::sessions_opened() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return getpid() == pid_ ? sessions_opened_ : 0;
+}
+
+PooledSQLProvider::ISession *PooledSQLProvider::Acquire(Slot *slot, std::string *error_msg) {
+    auto start = std::chrono::high_resolution_clock::now();
+    if (slot->session != nullptr && !CheckSession(slot->session.get())) {
+        slot->session.reset();
+    }
+    if (slot->session == nullptr) {
+        slot->session = OpenSession(error_msg);
+        slot->statements = 0;
+        if (slot->session != nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sessions_opened_++;
+        }
+    }
+    AddSessionTime(slot, start);
+    return slot->session.get();
+}
+
+void PooledSQLProvider::Release(Slot *slot, bool ok) {
+    slot->statements++;
+    if ((!ok && recycle_after_error_) ||
+        (max_statements_per_session_ > 0 && slot->statements >= max_statements_per_session_)) {
+        auto start = std::chrono::high_resolution_clock::now();
+        slot->session.reset();
+        AddSessionTime(slot, start);
+    }
+}
+
+PooledSQLProvider::Slot &PooledSQLProvider::ThreadSlot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (getpid() != pid_) {
+        // A forked checker: the connections belong to the parent, which closes them
+        for (auto &[id, slot] : slots_) slot.session.release();
+        slots_.clear();
+        sessions_opened_ = 0;
+        pid_ = getpid();
+    }
+    return slots_[std::this_thread::get_id()];
+}
+
+void PooledSQLProvider::AddSessionTime(Slot *slot, std::chrono::high_resolution_clock::time_point start) {
+    slot->session_time += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start);
+}
+
+}  // namespace tensile
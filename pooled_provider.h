@@ -0,0 +1,93 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+#include "tensile.h"
+
+namespace tensile {
+
+// Base for providers which run statements in sessions that are costly to open, like database
+// connections. Sessions are opened lazily, one per thread and process, and kept across statements
+// so that probes measure the statement rather than the connection. A session is checked with
+// CheckSession before each reuse and reopened when the check fails, after an error, or after
+// max_statements_per_session statements.
+//
+// Time spent opening, checking and closing sessions is reported by TakeSessionTime, apart from
+// statement latencies. With fork-based checking (the default), every checker process opens its
+// own session: sessions inherited from the parent are dropped without being closed, since the
+// connection they hold belongs to the parent. Batches amortize that per-process cost.
+class PooledSQLProvider : public ISQLProvider {
+public:
+    // State of one session, owned by the provider and destroyed to close it
+    class ISession {
+    public:
+        virtual ~ISession() {}
+    };
+
+    PooledSQLProvider() : pid_(getpid()) {}
+
+    ~PooledSQLProvider() override;
+
+    bool Run(std::string_view sql, std::string *error_msg) override;
+
+    // Runs @sqls in one session, where @latencies leave out opening and closing it.
+    void RunBatch(const std::vector<std::string_view> &sqls, std::vector<Status> *statuses,
+                  std::vector<std::chrono::microseconds> *latencies) override;
+
+    // Session time of the calling thread
+    std::chrono::microseconds TakeSessionTime() override;
+
+    // Statements to run in a session before reopening it, or 0 to keep it as long as it is healthy.
+    void set_max_statements_per_session(size_t max) { max_statements_per_session_ = max; }
+
+    // Whether to reopen the session after a statement fails, in case the failure broke it.
+    void set_recycle_after_error(bool recycle) { recycle_after_error_ = recycle; }
+
+    // Sessions opened by this process so far
+    size_t sessions_opened() const;
+
+protected:
+    // Opens a new session, or returns null with the reason in @error_msg.
+    virtual std::unique_ptr<ISession> OpenSession(std::string *error_msg) = 0;
+
+    // Runs @sql in @session like ISQLProvider::Run.
+    virtual bool RunInSession(ISession *session, std::string_view sql, std::string *error_msg) = 0;
+
+    // Whether @session can still run statements, checked before it is reused. The default
+    // trusts it.
+    virtual bool CheckSession(ISession *session) { return true; }
+
+private:
+    struct Slot {
+        std::unique_ptr<ISession> session;
+        size_t statements = 0;
+        // Not yet taken by TakeSessionTime
+        std::chrono::microseconds session_time{0};
+    };
+
+    // Session of @slot, opened or reopened as needed. Returns null with the reason in @error_msg
+    // if it cannot be opened.
+    ISession *Acquire(Slot *slot, std::string *error_msg);
+
+    // Counts a statement run in the session of @slot, and closes the session if it is due for
+    // recycling.
+    void Release(Slot *slot, bool ok);
+
+    // Slot of the calling thread. Drops sessions inherited from a parent process first.
+    Slot &ThreadSlot();
+
+    static void AddSessionTime(Slot *slot, std::chrono::high_resolution_clock::time_point start);
+
+    size_t max_statements_per_session_ = 0;
+    bool recycle_after_error_ = true;
+
+    mutable std::mutex mutex_;
+    pid_t pid_;
+    std::map<std::thread::id, Slot> slots_;
+    size_t sessions_opened_ = 0;
+};
+
+}  // namespace tensile
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "pooled_provider.h"
+
+#include <thread>
+
+namespace tensile {
+namespace {
+
+constexpr std::chrono::milliseconds kOpenTime(5);
+
+// Accepts statements up to @limit characters, in sessions which take kOpenTime to open. "break"
+// succeeds but leaves the session unhealthy.
+class CountingProvider : public PooledSQLProvider {
+public:
+    explicit CountingProvider(size_t limit) : limit_(limit) {}
+
+    std::string name() const override { return "counting"; }
+
+    size_t closed() const { return closed_; }
+
+protected:
+    class Session : public ISession {
+    public:
+        explicit Session(size_t *closed) : closed_(closed) {}
+        ~Session() override { ++*closed_; }
+
+        bool broken = false;
+
+    private:
+        size_t *closed_;
+    };
+
+    std::unique_ptr<ISession> OpenSession(std::string *error_msg) override {
+        std::this_thread::sleep_for(kOpenTime);
+        return std::make_unique<Session>(&closed_);
+    }
+
+    bool RunInSession(ISession *session, std::string_view sql, std::string *error_msg) override {
+        if (sql == "break") static_cast<Session *>(session)->broken = true;
+        if (sql.size() <= limit_) return true;
+        *error_msg = "too long";
+        return false;
+    }
+
+    bool CheckSession(ISession *session) override { return !static_cast<Session *>(session)->broken; }
+
+private:
+    size_t limit_;
+    size_t closed_ = 0;
+};
+
+class LongFeature : public ISQLFeature {
+public:
+    std::string name() override { return "long"; }
+    std::string_view GenerateSQL(size_t n) override {
+        sql_.assign(n, 'x');
+        return sql_;
+    }
+
+private:
+    std::string sql_;
+};
+
+class ProbeCollector : public IProbeListener {
+public:
+    explicit ProbeCollector(std::vector<Probe> *probes) : probes_(probes) {}
+    void OnProbe(const Probe &probe) override { probes_->push_back(probe); }
+
+private:
+    std::vector<Probe> *probes_;
+};
+
+TEST(PooledProvider, Recycling) {
+    CountingProvider provider(10);
+    provider.set_max_statements_per_session(3);
+    std::string error;
+    for (int i = 0; i < 7; i++) EXPECT_TRUE(provider.Run("select", &error));
+    EXPECT_EQ(3, provider.sessions_opened());
+    EXPECT_EQ(2, provider.closed());
+    EXPECT_GE(provider.TakeSessionTime(), 3 * kOpenTime);
+    EXPECT_EQ(0, provider.TakeSessionTime().count());
+
+    // Errors recycle the session unless told otherwise
+    provider.set_max_statements_per_session(0);
+    EXPECT_FALSE(provider.Run("much too long", &error));
+    EXPECT_EQ("too long", error);
+    EXPECT_TRUE(provider.Run("select", &error));
+    EXPECT_EQ(4, provider.sessions_opened());
+    provider.set_recycle_after_error(false);
+    EXPECT_FALSE(provider.Run("much too long", &error));
+    EXPECT_TRUE(provider.Run("select", &error));
+    EXPECT_EQ(4, provider.sessions_opened());
+
+    // Unhealthy sessions are reopened before they run the next statement
+    EXPECT_TRUE(provider.Run("break", &error));
+    EXPECT_EQ(4, provider.sessions_opened());
+    EXPECT_TRUE(provider.Run("select", &error));
+    EXPECT_EQ(5, provider.sessions_opened());
+}
+
+TEST(PooledProvider, BatchAndThreads) {
+    CountingProvider provider(10);
+    std::vector<Status> statuses;
+    std::vector<std::chrono::microseconds> latencies;
+    provider.RunBatch({"select", "much too long", "select"}, &statuses, &latencies);
+    ASSERT_EQ(3, statuses.size());
+    EXPECT_EQ(Status::SUCCESS, statuses[0].code());
+    EXPECT_EQ("too long", statuses[1].message());
+    EXPECT_EQ(Status::SUCCESS, statuses[2].code());
+    EXPECT_EQ(2, provider.sessions_opened());
+    for (auto latency : latencies) EXPECT_LT(latency, kOpenTime);
+
+    // One session per thread, each with its own session time
+    std::thread thread([&] {
+        std::string error;
+        EXPECT_TRUE(provider.Run("select", &error));
+        EXPECT_GE(provider.TakeSessionTime(), kOpenTime);
+    });
+    thread.join();
+    EXPECT_EQ(3, provider.sessions_opened());
+    EXPECT_GE(provider.TakeSessionTime(), 2 * kOpenTime);
+}
+
+TEST(PooledProvider, Driver) {
+    for (bool check_crash : {false, true}) {
+        std::vector<Probe> probes;
+        Driver driver;
+        driver.set_check_crash(check_crash);
+        driver.set_explore_beyond_first_failure(false);
+        driver.AddProbeListener(std::make_unique<ProbeCollector>(&probes));
+        CountingProvider provider(100);
+        LongFeature feature;
+        auto results = driver.Run(&provider, &feature);
+        ASSERT_EQ(1, results.size());
+        EXPECT_EQ(100, results[0].limit);
+        ASSERT_FALSE(probes.empty());
+        if (check_crash) {
+            // Every checker process opens a session; the driver's process opens none
+            EXPECT_EQ(0, provider.sessions_opened());
+            for (const auto &probe : probes) EXPECT_GE(probe.session_time, kOpenTime);
+        } else {
+            // Failures recycle the session, which the next probe reopens
+            size_t failures = 0;
+            for (size_t i = 0; i + 1 < probes.size(); i++) failures += probes[i].status.code() != Status::SUCCESS;
+            EXPECT_EQ(1 + failures, provider.sessions_opened());
+            EXPECT_GE(probes[0].session_time, kOpenTime);
+        }
+        for (const auto &probe : probes) EXPECT_LT(probe.latency, kOpenTime);
+    }
+}
+
+}  // namespace
+}  // namespace tensile
@@ -0,0 +1,67 @@
+#include "probe_log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+namespace tensile {
+
+bool ProbeRecorder::Open(const std::string &path, std::string *error) {
+    file_.open(path, std::ios::out | std::ios::trunc);
+    if (!file_) {
+        *error = "cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void ProbeRecorder::OnProbe(const Probe &probe) {
+    file_ << probe.provider << '\t' << probe.feature << '\t';
+    for (size_t k = 0; k < probe.dims.size(); k++) {
+        file_ << (k ? "x" : "") << probe.dims[k];
+    }
+    file_ << '\t' << probe.timeout.count() << '\t' << probe.status.code() << '\t' << probe.latency.count() << '\n';
+}
+
+bool ReadProbeLog(const std::string &path, std::vector<Probe> *probes, std::string *error) {
+    std::ifstream file(path);
+    if (!file) {
+        *error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    std::string line;
+    for (size_t line_number = 1; std::getline(file, line); line_number++) {
+        if (line.empty()) continue;
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        for (std::string field; std::getline(stream, field, '\t');) fields.push_back(std::move(field));
+
+        Probe probe;
+        bool ok = fields.size() == 6 && !fields[2].empty() && fields[2].back() != 'x';
+        if (ok) {
+            probe.provider = fields[0];
+            probe.feature = fields[1];
+            std::istringstream dims(fields[2]);
+            for (std::string n; ok && std::getline(dims, n, 'x');) {
+                ok = !n.empty() && n.size() < 20 && n.find_first_not_of("0123456789") == std::string::npos;
+                if (ok) probe.dims.push_back(std::stoull(n));
+            }
+            std::istringstream numbers(fields[3] + " " + fields[4] + " " + fields[5]);
+            long long timeout = 0, latency = 0;
+            Status::Code code = Status::SUCCESS;
+            ok = ok && (numbers >> timeout >> code >> latency) && (numbers >> std::ws).eof() &&
+                 code >= Status::SUCCESS && code <= Status::CRASH;
+            probe.timeout = std::chrono::milliseconds(timeout);
+            probe.status = Status(code);
+            probe.latency = std::chrono::microseconds(latency);
+        }
+        if (!ok) {
+            *error = path + ":" + std::to_string(line_number) + ": not a probe: " + line;
+            return false;
+        }
+        probes->push_back(std::move(probe));
+    }
+    return true;
+}
+
+}  // namespace tensile
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <fstream>
+
+#include "tensile.h"
+
+namespace tensile {
+
+// Log of the probes of a driver run, which Driver::Replay checks again. One probe per line, with
+// tab-separated provider, feature, sizes joined by 'x', timeout in milliseconds, status code and
+// latency in microseconds:
+//
+//     reference parser	parenthesis	64	100	1	12
+//
+// Status messages are not kept. Names must not contain tabs or line breaks.
+class ProbeRecorder : public IProbeListener {
+public:
+    // Creates the log at @path. Returns false with the reason in @error on failure.
+    bool Open(const std::string &path, std::string *error);
+
+    void OnProbe(const Probe &probe) override;
+
+private:
+    std::ofstream file_;
+};
+
+// Reads the probes logged by ProbeRecorder at @path into @probes. Returns false with the reason
+// and the line in @error if the log cannot be read.
+bool ReadProbeLog(const std::string &path, std::vector<Probe> *probes, std::string *error);
+
+}  // namespace tensile
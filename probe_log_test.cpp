@@ -0,0 +1,101 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include "probe_log.h"
+#include "reference_parser.h"
+
+namespace tensile {
+namespace {
+
+std::string Path(const std::string &name) { return testing::TempDir() + name; }
+
+std::unique_ptr<ISQLFeature> Parenthesis() {
+    for (auto &feature : GetBuiltinFeatures()) {
+        if (feature->name() == "parenthesis") return std::move(feature);
+    }
+    return nullptr;
+}
+
+std::unique_ptr<ISQLProvider> Parser(size_t max_depth) {
+    ReferenceParser::Limits limits;
+    limits.max_depth = max_depth;
+    return std::make_unique<ReferenceParser>(limits);
+}
+
+TEST(ProbeLog, WriteAndRead) {
+    const std::string path = Path("probe_log_write_and_read");
+    Probe probe;
+    probe.provider = "provider";
+    probe.feature = "subselect in FROM x select list";
+    probe.dims = {3, 40};
+    probe.timeout = std::chrono::milliseconds(100);
+    probe.status = Status(Status::TIMEOUT, "not kept");
+    probe.latency = std::chrono::microseconds(123456);
+    {
+        ProbeRecorder recorder;
+        std::string error;
+        ASSERT_TRUE(recorder.Open(path, &error)) << error;
+        recorder.OnProbe(probe);
+        probe.dims = {7};
+        probe.status = Status(Status::SUCCESS);
+        recorder.OnProbe(probe);
+    }
+    std::vector<Probe> probes;
+    std::string error;
+    ASSERT_TRUE(ReadProbeLog(path, &probes, &error)) << error;
+    ASSERT_EQ(2, probes.size());
+    EXPECT_EQ("provider", probes[0].provider);
+    EXPECT_EQ("subselect in FROM x select list", probes[0].feature);
+    EXPECT_EQ(std::vector<size_t>({3, 40}), probes[0].dims);
+    EXPECT_EQ(100, probes[0].timeout.count());
+    EXPECT_EQ(Status::TIMEOUT, probes[0].status.code());
+    EXPECT_EQ(123456, probes[0].latency.count());
+    EXPECT_EQ(std::vector<size_t>({7}), probes[1].dims);
+    EXPECT_EQ(Status::SUCCESS, probes[1].status.code());
+
+    for (const char *line : {"a\tb\t1\t100\t0", "a\tb\t\t100\t0\t1", "a\tb\t1x\t100\t0\t1", "a\tb\t1\t100\t0\t1 2",
+                             "a\tb\t1\t100\t4\t1", "a\tb\t1\t100\t-1\t1"}) {
+        std::ofstream(path) << "a\tb\t1\t100\t0\t5\n" << line << "\n";
+        EXPECT_FALSE(ReadProbeLog(path, &probes, &error)) << line;
+        EXPECT_THAT(error, testing::HasSubstr(":2: not a probe"));
+    }
+}
+
+TEST(ProbeLog, RecordAndReplay) {
+    const std::string path = Path("probe_log_record_and_replay");
+    {
+        Driver driver;
+        driver.set_explore_beyond_first_failure(false);
+        auto recorder = std::make_unique<ProbeRecorder>();
+        std::string error;
+        ASSERT_TRUE(recorder->Open(path, &error)) << error;
+        driver.AddProbeListener(std::move(recorder));
+        auto provider = Parser(40);
+        auto results = driver.Run(provider.get(), Parenthesis().get());
+        ASSERT_EQ(1, results.size());
+        EXPECT_EQ(38, results[0].limit);
+    }
+    std::vector<Probe> probes;
+    std::string error;
+    ASSERT_TRUE(ReadProbeLog(path, &probes, &error)) << error;
+    // Doubling up to 64 and bisecting down to 38
+    ASSERT_EQ(12, probes.size());
+    Probe unknown = probes[0];
+    unknown.provider = "unknown";
+    probes.push_back(unknown);
+
+    // A lower limit changes the status of the probes between the two limits only
+    Driver driver;
+    driver.AddProvider(Parser(30));
+    auto results = driver.Replay(probes, 3);
+    ASSERT_EQ(probes.size(), results.size());
+    for (size_t i = 0; i + 1 < probes.size(); i++) {
+        const size_t n = results[i].recorded.dims[0];
+        EXPECT_EQ(probes[i].dims, results[i].replayed.dims);
+        EXPECT_EQ(n <= 38 ? Status::SUCCESS : Status::ERROR, results[i].recorded.status.code()) << n;
+        EXPECT_EQ(n <= 28 ? Status::SUCCESS : Status::ERROR, results[i].replayed.status.code()) << n;
+    }
+    EXPECT_EQ("unknown provider", results.back().replayed.status.message());
+}
+
+}  // namespace
+}  // namespace tensile
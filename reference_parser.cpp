@@ -0,0 +1,746 @@
+#include "reference_parser.h"
+
+#include <cstring>
+#include <strings.h>
+
+namespace tensile {
+
+namespace {
+
+struct Token {
+    enum Kind { END, WORD, QUOTED, NUMBER, STRING, PARAM, OP, PUNCT };
+    Kind kind = END;
+    std::string_view text;
+    size_t offset = 0;
+};
+
+// Thrown on the first syntax error and caught by ReferenceParser::Run.
+struct SyntaxError {
+    std::string message;
+    size_t offset;
+};
+
+bool IsWordStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool IsWordChar(char c) { return IsWordStart(c) || (c >= '0' && c <= '9') || c == '$'; }
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+class Lexer {
+public:
+    explicit Lexer(std::string_view sql) : sql_(sql) {}
+
+    Token Next() {
+        SkipSpaceAndComments();
+        Token token;
+        token.offset = pos_;
+        if (pos_ >= sql_.size()) return token;
+        const size_t start = pos_;
+        const char c = sql_[pos_];
+        if (IsWordStart(c)) {
+            while (pos_ < sql_.size() && IsWordChar(sql_[pos_])) pos_++;
+            token.kind = Token::WORD;
+        } else if (IsDigit(c) || (c == '.' && pos_ + 1 < sql_.size() && IsDigit(sql_[pos_ + 1]))) {
+            LexNumber();
+            token.kind = Token::NUMBER;
+        } else if (c == '\'' || c == '"') {
+            LexQuoted(c);
+            token.kind = c == '\'' ? Token::STRING : Token::QUOTED;
+        } else if (c == '$') {
+            token.kind = LexDollar();
+        } else if (std::strchr("()[]{},;:.", c) != nullptr && !Starts("::")) {
+            pos_++;
+            token.kind = Token::PUNCT;
+        } else if (std::strchr("+-*/%^&|#~@<>=!:", c) != nullptr) {
+            for (std::string_view op : {"->>", "||/", "|/", "::", "<<", ">>", "<=", ">=", "<>", "!=", "||", "->"}) {
+                if (Starts(op)) {
+                    pos_ += op.size();
+                    break;
+                }
+            }
+            if (pos_ == start) pos_++;
+            token.kind = Token::OP;
+        } else {
+            throw SyntaxError{"unexpected character", start};
+        }
+        token.text = sql_.substr(start, pos_ - start);
+        return token;
+    }
+
+private:
+    bool Starts(std::string_view text) const { return sql_.substr(pos_, text.size()) == text; }
+
+    void SkipSpaceAndComments() {
+        for (;;) {
+            while (pos_ < sql_.size() && IsSpace(sql_[pos_])) pos_++;
+            if (Starts("--")) {
+                const size_t end = sql_.find('\n', pos_);
+                pos_ = end == std::string_view::npos ? sql_.size() : end + 1;
+            } else if (Starts("/*")) {
+                const size_t start = pos_;
+                size_t depth = 0;
+                do {
+                    const size_t next = sql_.find_first_of("/*", pos_);
+                    if (next == std::string_view::npos || next + 1 >= sql_.size()) {
+                        throw SyntaxError{"unterminated /* comment", start};
+                    }
+                    pos_ = next;
+                    if (Starts("/*")) {
+                        depth++;
+                        pos_ += 2;
+                    } else if (Starts("*/")) {
+                        depth--;
+                        pos_ += 2;
+                    } else {
+                        pos_++;
+                    }
+                } while (depth > 0);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void LexNumber() {
+        while (pos_ < sql_.size() && IsDigit(sql_[pos_])) pos_++;
+        if (pos_ < sql_.size() && sql_[pos_] == '.') {
+            pos_++;
+            while (pos_ < sql_.size() && IsDigit(sql_[pos_])) pos_++;
+        }
+        if (pos_ < sql_.size() && (sql_[pos_] == 'e' || sql_[pos_] == 'E')) {
+            size_t i = pos_ + 1;
+            if (i < sql_.size() && (sql_[i] == '+' || sql_[i] == '-')) i++;
+            if (i < sql_.size() && IsDigit(sql_[i])) {
+                pos_ = i;
+                while (pos_ < sql_.size() && IsDigit(sql_[pos_])) pos_++;
+            }
+        }
+        if (pos_ < sql_.size() && IsWordStart(sql_[pos_])) throw SyntaxError{"trailing junk after numeric literal", pos_};
+    }
+
+    // Quotes inside are doubled.
+    void LexQuoted(char quote) {
+        const size_t start = pos_;
+        for (pos_++;;) {
+            const size_t end = sql_.find(quote, pos_);
+            if (end == std::string_view::npos) {
+                throw SyntaxError{quote == '\'' ? "unterminated quoted string" : "unterminated quoted identifier",
+                                  start};
+            }
+            pos_ = end + 1;
+            if (pos_ >= sql_.size() || sql_[pos_] != quote) return;
+            pos_++;
+        }
+    }
+
+    // $1 or $tag$ ... $tag$
+    Token::Kind LexDollar() {
+        const size_t start = pos_++;
+        if (pos_ < sql_.size() && IsDigit(sql_[pos_])) {
+            while (pos_ < sql_.size() && IsDigit(sql_[pos_])) pos_++;
+            return Token::PARAM;
+        }
+        while (pos_ < sql_.size() && IsWordChar(sql_[pos_]) && sql_[pos_] != '$') pos_++;
+        if (pos_ >= sql_.size() || sql_[pos_] != '$') throw SyntaxError{"unexpected character", start};
+        const std::string_view delimiter = sql_.substr(start, pos_ + 1 - start);
+        const size_t end = sql_.find(delimiter, pos_ + 1);
+        if (end == std::string_view::npos) throw SyntaxError{"unterminated dollar-quoted string", start};
+        pos_ = end + delimiter.size();
+        return Token::STRING;
+    }
+
+    std::string_view sql_;
+    size_t pos_ = 0;
+};
+
+// Words which end an expression or a table reference rather than name an alias.
+constexpr std::string_view kReserved[] = {
+        "all", "and", "any", "array", "as", "asc", "at", "between", "by", "case", "cast", "create", "cross",
+        "desc", "distinct", "else", "end", "except", "exists", "false", "for", "from", "full", "group",
+        "having", "ilike", "in", "inner", "intersect", "into", "is", "join", "lateral", "left", "like",
+        "limit", "natural", "not", "null", "offset", "on", "or", "order", "outer", "over", "right",
+        "select", "some", "table", "then", "true", "union", "using", "when", "where", "window", "with",
+};
+
+// Binding power of binary operators, from the loosest. Prefix NOT binds like kNot and other
+// prefix operators like kUnary.
+enum Precedence {
+    kLowest = 0,
+    kOr,
+    kAnd,
+    kNot,
+    kIs,
+    kComparison,
+    kBetween,  // also IN and LIKE
+    kOtherOp,
+    kAdditive,
+    kMultiplicative,
+    kPower,
+    kUnary,
+    kPostfix,
+};
+
+class Parser {
+public:
+    Parser(std::string_view sql, const ReferenceParser::Limits &limits) : lexer_(sql), limits_(limits) {
+        token_ = lexer_.Next();
+    }
+
+    void ParseStatement() {
+        if (Accept("create")) {
+            ParseCreateTable();
+        } else {
+            ParseQuery();
+        }
+        Accept(";");
+        if (token_.kind != Token::END) Fail();
+    }
+
+private:
+    // Recursion guard for one level of nesting
+    class Nested {
+    public:
+        explicit Nested(Parser *parser) : parser_(parser) {
+            if (++parser_->depth_ > parser_->limits_.max_depth) {
+                throw SyntaxError{"stack depth limit exceeded", parser_->token_.offset};
+            }
+        }
+        ~Nested() { parser_->depth_--; }
+
+    private:
+        Parser *parser_;
+    };
+
+    // Token helpers. Words are matched case-insensitively, and punctuation or operators by text.
+
+    bool Is(std::string_view text) const { return Is(token_, text); }
+
+    static bool Is(const Token &token, std::string_view text) {
+        if (token.kind == Token::WORD) {
+            return token.text.size() == text.size() && strncasecmp(token.text.data(), text.data(), text.size()) == 0;
+        }
+        return (token.kind == Token::PUNCT || token.kind == Token::OP) && token.text == text;
+    }
+
+    bool Accept(std::string_view text) {
+        if (!Is(text)) return false;
+        Advance();
+        return true;
+    }
+
+    void Expect(std::string_view text) {
+        if (!Accept(text)) Fail();
+    }
+
+    void Advance() { token_ = lexer_.Next(); }
+
+    [[noreturn]] void Fail() const {
+        if (token_.kind == Token::END) throw SyntaxError{"syntax error at end of input", token_.offset};
+        throw SyntaxError{"syntax error at or near \"" + std::string(token_.text.substr(0, 32)) + "\"", token_.offset};
+    }
+
+    bool IsReserved() const {
+        if (token_.kind != Token::WORD) return false;
+        for (std::string_view word : kReserved) {
+            if (Is(word)) return true;
+        }
+        return false;
+    }
+
+    bool IsName() const { return token_.kind == Token::QUOTED || (token_.kind == Token::WORD && !IsReserved()); }
+
+    void ExpectName() {
+        if (!IsName()) Fail();
+        Advance();
+    }
+
+    // Parenthesized list of names, e.g. column aliases or USING columns
+    void ParseNames() {
+        Expect("(");
+        do {
+            ExpectName();
+        } while (Accept(","));
+        Expect(")");
+    }
+
+    void ParseCreateTable() {
+        Expect("table");
+        if (Accept("if")) {
+            Expect("not");
+            Expect("exists");
+        }
+        ExpectName();
+        Expect("(");
+        do {
+            ExpectName();
+            ParseType();
+        } while (Accept(","));
+        Expect(")");
+    }
+
+    // Name with optional modifiers and array dimensions, e.g. numeric(2,0) or int[][]
+    void ParseType() {
+        ExpectName();
+        if (Accept("(")) {
+            do {
+                if (token_.kind != Token::NUMBER) Fail();
+                Advance();
+            } while (Accept(","));
+            Expect(")");
+        }
+        while (Accept("[")) Expect("]");
+    }
+
+    void ParseQuery() {
+        Nested nested(this);
+        if (Accept("with")) {
+            Accept("recursive");
+            do {
+                ExpectName();
+                if (Is("(")) ParseNames();
+                Expect("as");
+                Expect("(");
+                ParseQuery();
+                Expect(")");
+            } while (Accept(","));
+        }
+        ParseSelect();
+        while (Accept("union") || Accept("except") || Accept("intersect")) {
+            if (!Accept("all")) Accept("distinct");
+            ParseSelect();
+        }
+        if (Accept("order")) {
+            Expect("by");
+            ParseOrderList();
+        }
+        if (Accept("limit")) ParseExpression();
+        if (Accept("offset")) ParseExpression();
+    }
+
+    void ParseSelect() {
+        if (Accept("(")) {
+            ParseQuery();
+            Expect(")");
+            return;
+        }
+        Expect("select");
+        if (!Accept("distinct")) Accept("all");
+        do {
+            ParseSelectItem();
+        } while (Accept(","));
+        if (Accept("from")) {
+            do {
+                ParseTableReference();
+            } while (Accept(","));
+        }
+        if (Accept("where")) ParseExpression();
+        if (Accept("group")) {
+            Expect("by");
+            ParseGroupingList();
+        }
+        if (Accept("having")) ParseExpression();
+        if (Accept("window")) {
+            do {
+                ExpectName();
+                Expect("as");
+                ParseWindowSpecification();
+            } while (Accept(","));
+        }
+    }
+
+    void ParseSelectItem() {
+        if (Accept("*")) return;
+        ParseExpression();
+        ParseAlias();
+    }
+
+    void ParseAlias() {
+        if (Accept("as") || IsName()) ExpectName();
+    }
+
+    void ParseTableReference() {
+        ParseTablePrimary();
+        for (;;) {
+            const bool natural = Accept("natural");
+            bool cross = false;
+            if (Accept("cross")) {
+                cross = true;
+            } else if (Accept("left") || Accept("right") || Accept("full")) {
+                Accept("outer");
+            } else {
+                Accept("inner");
+            }
+            if (!Accept("join")) {
+                if (natural || cross) Fail();
+                return;
+            }
+            if (natural || cross) {
+                ParseTablePrimary();
+                continue;
+            }
+            // The right side may be a join itself, qualified before this one as in
+            // "a join b join c on x on y"
+            {
+                Nested nested(this);
+                ParseTableReference();
+            }
+            if (Accept("on")) {
+                ParseExpression();
+            } else if (Accept("using")) {
+                ParseNames();
+            } else {
+                Fail();
+            }
+        }
+    }
+
+    void ParseTablePrimary() {
+        Nested nested(this);
+        Accept("lateral");
+        if (Accept("(")) {
+            ParseQuery();
+            Expect(")");
+        } else {
+            ExpectName();
+            if (Accept("(")) {
+                ParseArguments();
+            } else if (Accept(".")) {
+                ExpectName();
+            }
+        }
+        if (Accept("as") || IsName()) {
+            ExpectName();
+            if (Is("(")) ParseNames();
+        }
+    }
+
+    void ParseGroupingList() {
+        do {
+            if (Accept("grouping")) {
+                Expect("sets");
+                ParseGroupingSets();
+            } else if (Accept("rollup") || Accept("cube")) {
+                ParseGroupingSets();
+            } else {
+                ParseExpression();
+            }
+        } while (Accept(","));
+    }
+
+    // Parenthesized grouping elements, which may be empty sets ()
+    void ParseGroupingSets() {
+        Nested nested(this);
+        Expect("(");
+        do {
+            if (Is("(")) {
+                Advance();
+                if (!Accept(")")) {
+                    ParseExpressionList();
+                    Expect(")");
+                }
+            } else {
+                ParseGroupingList();
+            }
+        } while (Accept(","));
+        Expect(")");
+    }
+
+    void ParseOrderList() {
+        do {
+            ParseExpression();
+            if (!Accept("asc")) Accept("desc");
+            if (Accept("nulls")) {
+                if (!Accept("first")) Expect("last");
+            }
+        } while (Accept(","));
+    }
+
+    void ParseWindowSpecification() {
+        Expect("(");
+        if (Accept("partition")) {
+            Expect("by");
+            ParseExpressionList();
+        }
+        if (Accept("order")) {
+            Expect("by");
+            ParseOrderList();
+        }
+        Expect(")");
+    }
+
+    void ParseExpressionList() {
+        do {
+            ParseExpression();
+        } while (Accept(","));
+    }
+
+    // Arguments of a function after its "(", up to and including ")"
+    void ParseArguments() {
+        if (Accept(")")) return;
+        if (Accept("*")) {
+            Expect(")");
+            return;
+        }
+        Accept("distinct");
+        do {
+            ParseExpression();
+            // trim(' ' from x) and similar
+            if (Accept("from")) ParseExpression();
+        } while (Accept(","));
+        if (Accept("order")) {
+            Expect("by");
+            ParseOrderList();
+        }
+        Expect(")");
+    }
+
+    void ParseExpression(int min_precedence = kLowest) {
+        Nested nested(this);
+        ParsePrefix();
+        for (;;) {
+            const int precedence = InfixPrecedence();
+            if (precedence <= min_precedence) return;
+            ParseInfix(precedence);
+        }
+    }
+
+    // Precedence of the operator at the current token, or kLowest if it is not one.
+    int InfixPrecedence() const {
+        if (token_.kind == Token::OP) {
+            const std::string_view op = token_.text;
+            if (op == "::") return kPostfix;
+            if (op == "+" || op == "-") return kAdditive;
+            if (op == "*" || op == "/" || op == "%") return kMultiplicative;
+            if (op == "^") return kPower;
+            if (op == "=" || op == "<" || op == ">" || op == "<=" || op == ">=" || op == "<>" || op == "!=") {
+                return kComparison;
+            }
+            return kOtherOp;
+        }
+        if (token_.kind == Token::PUNCT) return token_.text == "[" ? kPostfix : kLowest;
+        if (token_.kind != Token::WORD) return kLowest;
+        if (Is("or")) return kOr;
+        if (Is("and")) return kAnd;
+        if (Is("is")) return kIs;
+        if (Is("between") || Is("in") || Is("like") || Is("ilike") || Is("not")) return kBetween;
+        if (Is("at")) return kPostfix;
+        return kLowest;
+    }
+
+    void ParseInfix(int precedence) {
+        if (Accept("::")) {
+            ParseType();
+        } else if (Accept("[")) {
+            ParseExpression();
+            if (Accept(":")) ParseExpression();
+            Expect("]");
+        } else if (Accept("at")) {
+            Expect("time");
+            Expect("zone");
+            ParseExpression(kPostfix);
+        } else if (Accept("is")) {
+            Accept("not");
+            if (Accept("distinct")) {
+                Expect("from");
+                ParseExpression(kIs);
+            } else if (!Accept("null") && !Accept("true") && !Accept("false") && !Accept("unknown")) {
+                Fail();
+            }
+        } else if (token_.kind == Token::WORD) {
+            // [NOT] BETWEEN, IN, LIKE
+            if (Accept("and") || Accept("or")) {
+                ParseExpression(precedence);
+                return;
+            }
+            Accept("not");
+            if (Accept("between")) {
+                Accept("symmetric");
+                ParseExpression(kBetween);
+                Expect("and");
+                ParseExpression(kBetween);
+            } else if (Accept("in")) {
+                ParseParenthesized();
+            } else if (Accept("like") || Accept("ilike")) {
+                ParseExpression(kBetween);
+            } else {
+                Fail();
+            }
+        } else {
+            const bool comparison = precedence == kComparison;
+            Advance();
+            if (comparison && (Accept("any") || Accept("all") || Accept("some"))) {
+                ParseParenthesized();
+            } else {
+                ParseExpression(precedence);
+            }
+        }
+    }
+
+    // Subquery or expression list in parentheses, as after IN or ANY
+    void ParseParenthesized() {
+        Nested nested(this);
+        Expect("(");
+        if (Is("select") || Is("with")) {
+            ParseQuery();
+        } else {
+            ParseExpressionList();
+        }
+        Expect(")");
+    }
+
+    void ParsePrefix() {
+        switch (token_.kind) {
+            case Token::NUMBER:
+            case Token::STRING:
+            case Token::PARAM:
+                Advance();
+                return;
+            case Token::OP:
+                if (Is("+") || Is("-") || Is("~") || Is("@") || Is("!") || Is("|/") || Is("||/")) {
+                    Advance();
+                    ParseExpression(kUnary);
+                    return;
+                }
+                Fail();
+            case Token::PUNCT:
+                ParsePunctuation();
+                return;
+            case Token::QUOTED:
+                ParseName();
+                return;
+            case Token::WORD:
+                ParseWord();
+                return;
+            case Token::END:
+                Fail();
+        }
+    }
+
+    void ParsePunctuation() {
+        if (Accept("(")) {
+            if (Is("select") || Is("with")) {
+                ParseQuery();
+            } else {
+                // Parenthesized expression or row
+                ParseExpressionList();
+            }
+            Expect(")");
+        } else if (Accept("[")) {
+            if (!Accept("]")) {
+                ParseExpressionList();
+                Expect("]");
+            }
+        } else if (Accept("{")) {
+            if (Accept("}")) return;
+            do {
+                if (token_.kind != Token::STRING && !IsName()) Fail();
+                Advance();
+                Expect(":");
+                ParseExpression();
+            } while (Accept(","));
+            Expect("}");
+        } else {
+            Fail();
+        }
+    }
+
+    void ParseWord() {
+        if (Accept("null") || Accept("true") || Accept("false")) return;
+        if (Accept("not")) {
+            ParseExpression(kNot);
+        } else if (Accept("exists")) {
+            Nested nested(this);
+            Expect("(");
+            ParseQuery();
+            Expect(")");
+        } else if (Accept("case")) {
+            ParseCase();
+        } else if (Accept("cast")) {
+            Expect("(");
+            ParseExpression();
+            Expect("as");
+            ParseType();
+            Expect(")");
+        } else if (Accept("array")) {
+            if (Accept("(")) {
+                ParseQuery();
+                Expect(")");
+            } else {
+                Expect("[");
+                if (!Accept("]")) {
+                    ParseExpressionList();
+                    Expect("]");
+                }
+            }
+        } else if (IsName()) {
+            ParseName();
+        } else {
+            Fail();
+        }
+    }
+
+    void ParseCase() {
+        if (!Is("when")) ParseExpression();
+        if (!Is("when")) Fail();
+        while (Accept("when")) {
+            ParseExpression();
+            Expect("then");
+            ParseExpression();
+        }
+        if (Accept("else")) ParseExpression();
+        Expect("end");
+    }
+
+    // Column, function call or typed literal, e.g. t.x, abs(x) over w, numeric(2,0) '1'
+    void ParseName() {
+        Advance();
+        if (Accept(".")) {
+            if (!Accept("*")) ExpectName();
+        } else if (Accept("(")) {
+            ParseArguments();
+            if (Accept("over")) {
+                if (Is("(")) {
+                    ParseWindowSpecification();
+                } else {
+                    ExpectName();
+                }
+            }
+        }
+        if (token_.kind == Token::STRING) Advance();
+    }
+
+    Lexer lexer_;
+    const ReferenceParser::Limits &limits_;
+    Token token_;
+    size_t depth_ = 0;
+};
+
+}  // namespace
+
+bool ReferenceParser::Run(std::string_view sql, std::string *error_msg) {
+    if (sql.size() > limits_.max_length) {
+        *error_msg = "statement is " + std::to_string(sql.size()) + " bytes, longer than " +
+                     std::to_string(limits_.max_length);
+        return false;
+    }
+    try {
+        Parser(sql, limits_).ParseStatement();
+    } catch (const SyntaxError &error) {
+        *error_msg = error.message + " at offset " + std::to_string(error.offset);
+        return false;
+    }
+    return true;
+}
+
+bool ReferenceParser::RunPhased(std::string_view sql, Phase stop_after, PhaseTimes *times, std::string *error_msg) {
+    times->Start(Phase::PARSE);
+    const bool ok = Run(sql, error_msg);
+    times->Stop();
+    return ok;
+}
+
+}  // namespace tensile
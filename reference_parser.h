@@ -0,0 +1,43 @@
+#pragma once
+
+#include "tensile.h"
+
+namespace tensile {
+
+// Self-contained recursive-descent parser for the SQL dialect generated by the builtin features:
+// PostgreSQL-style queries, expressions and literals, plus list and struct literals. It only
+// checks syntax and builds nothing, so its latency is small and deterministic, which makes it a
+// baseline provider for benchmarking the driver itself. ValidateSQL overrides can also use it
+// for a real syntax check.
+//
+// Operator chains are parsed iteratively, while every level of nesting (parentheses, unary
+// operators, subqueries, CASE, ...) is one level of recursion, limited by Limits::max_depth.
+class ReferenceParser : public ISQLProvider {
+public:
+    struct Limits {
+        // Levels of nesting, beyond which SQL fails like on a stack depth limit
+        size_t max_depth = 1000;
+        // Bytes of SQL, beyond which it fails without being parsed
+        size_t max_length = 16 << 20;
+    };
+
+    ReferenceParser() {}
+
+    explicit ReferenceParser(Limits limits) : limits_(limits) {}
+
+    std::string name() const override { return "reference parser"; }
+
+    // Parses @sql and on failure sets @error_msg to the reason and where it is in @sql.
+    bool Run(std::string_view sql, std::string *error_msg) override;
+
+    // Parsing is the only phase, so statements stop after it whatever @stop_after.
+    bool has_phases() const override { return true; }
+    bool RunPhased(std::string_view sql, Phase stop_after, PhaseTimes *times, std::string *error_msg) override;
+
+    const Limits &limits() const { return limits_; }
+
+private:
+    Limits limits_;
+};
+
+}  // namespace tensile
@@ -0,0 +1,79 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include "reference_parser.h"
+
+namespace tensile {
+namespace {
+
+TEST(ReferenceParser, AcceptsBuiltinFeatures) {
+    ReferenceParser parser;
+    for (auto &feature : GetBuiltinFeatures()) {
+        SCOPED_TRACE(feature->name());
+        for (size_t n : {1, 2, 10}) {
+            std::string error;
+            EXPECT_TRUE(parser.Run(feature->GenerateSQL(n), &error)) << "n=" << n << ": " << error;
+        }
+    }
+    for (auto &feature : GetBuiltinMultiFeatures()) {
+        SCOPED_TRACE(feature->name());
+        std::string error;
+        EXPECT_TRUE(parser.Run(feature->GenerateSQL({3, 3}), &error)) << error;
+    }
+}
+
+TEST(ReferenceParser, RejectsInvalid) {
+    ReferenceParser parser;
+    std::string error;
+    EXPECT_FALSE(parser.Run("select (1", &error));
+    EXPECT_EQ("syntax error at end of input at offset 9", error);
+    EXPECT_FALSE(parser.Run("select 1 + from t", &error));
+    EXPECT_EQ("syntax error at or near \"from\" at offset 11", error);
+    EXPECT_FALSE(parser.Run("selec 1", &error));
+    EXPECT_EQ("syntax error at or near \"selec\" at offset 0", error);
+    EXPECT_FALSE(parser.Run("select 'abc", &error));
+    EXPECT_EQ("unterminated quoted string at offset 7", error);
+    EXPECT_FALSE(parser.Run("select * from t join u", &error));
+    EXPECT_FALSE(parser.Run("select case end", &error));
+    EXPECT_FALSE(parser.Run("select 1 is 2", &error));
+}
+
+TEST(ReferenceParser, Limits) {
+    ReferenceParser::Limits limits;
+    limits.max_depth = 50;
+    limits.max_length = 100;
+    ReferenceParser parser(limits);
+    std::string error;
+    EXPECT_TRUE(parser.Run("select " + std::string(40, '(') + "1" + std::string(40, ')'), &error)) << error;
+    EXPECT_FALSE(parser.Run("select " + std::string(60, '~') + "1", &error));
+    EXPECT_THAT(error, testing::HasSubstr("stack depth limit exceeded"));
+    // Operator chains are not nested
+    std::string sum = "select 1";
+    for (int i = 0; i < 45; i++) sum += "+1";
+    EXPECT_TRUE(parser.Run(sum, &error)) << error;
+    EXPECT_FALSE(parser.Run(sum + "+1+1", &error));
+    EXPECT_THAT(error, testing::HasSubstr("longer than 100"));
+}
+
+class FailingProvider : public ISQLProvider {
+public:
+    std::string name() const override { return "failing"; }
+    bool Run(std::string_view sql, std::string *error_msg) override { return false; }
+};
+
+TEST(ReferenceParser, RegisteredWithDriver) {
+    RegisterSQLProvider(std::make_unique<FailingProvider>());
+    const char *argv[] = {"test", "--reference_parser", "--reference_max_depth=100", "--features=parenthesis",
+                          "--no_explore_beyond", nullptr};
+    Driver driver(5, const_cast<char **>(argv));
+    auto results = driver.Run();
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ("failing", results[0].provider);
+    EXPECT_EQ(Status::ERROR, results[0].status.code());
+    // The query and the select list take a level of nesting each
+    EXPECT_EQ("reference parser", results[1].provider);
+    EXPECT_EQ(98, results[1].limit);
+    EXPECT_EQ(Status::ERROR, results[1].status.code());
+}
+
+}  // namespace
+}  // namespace tensile
@@ -0,0 +1,575 @@
+#include "results_writer.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <variant>
+
+namespace tensile {
+
+namespace {
+
+constexpr uint8_t kProbeRecord = 1;
+constexpr uint8_t kResultRecord = 2;
+
+const char *const kFormatNames[] = {"jsonl", "csv", "binary"};
+
+const char *const kCsvHeader =
+        "type,provider,feature,dims,sql_bytes,timeout_ms,status,message,latency_us,session_us,cpu_us,parse_us,"
+        "bind_us,optimize_us,execute_us,limit,phase\n";
+
+// Name of the code of @status, as in Status::ToString
+std::string CodeName(const Status &status) { return Status(status.code()).ToString(); }
+
+bool ParseCode(const std::string &name, Status::Code *code) {
+    for (Status::Code k = Status::SUCCESS; k <= Status::CRASH; k++) {
+        if (Status(k).ToString() == name) {
+            *code = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void AppendCsvField(std::string_view text, std::string *out) {
+    if (text.find_first_of(",\"\n\r") == std::string_view::npos) {
+        *out += text;
+        return;
+    }
+    *out += '"';
+    for (char c : text) {
+        if (c == '"') *out += '"';
+        *out += c;
+    }
+    *out += '"';
+}
+
+std::string JoinDims(const std::vector<size_t> &dims) {
+    std::string text;
+    for (size_t k = 0; k < dims.size(); k++) {
+        text += (k ? "x" : "") + std::to_string(dims[k]);
+    }
+    return text;
+}
+
+template <typename T>
+void AppendBinary(T value, std::string *out) {
+    out->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void AppendBinary(std::string_view text, std::string *out) {
+    AppendBinary(static_cast<uint32_t>(text.size()), out);
+    out->append(text);
+}
+
+// Prefixes @record with its size
+std::string SizedRecord(const std::string &record) {
+    std::string out;
+    AppendBinary(static_cast<uint32_t>(record.size()), &out);
+    return out + record;
+}
+
+std::string FormatProbe(const Probe &probe, ResultsWriter::Format format) {
+    std::string out;
+    switch (format) {
+        case ResultsWriter::Format::JSONL: {
+            out += "{\"type\":\"probe\",\"provider\":";
+            AppendJsonString(probe.provider, &out);
+            out += ",\"feature\":";
+            AppendJsonString(probe.feature, &out);
+            out += ",\"dims\":[";
+            for (size_t k = 0; k < probe.dims.size(); k++) out += (k ? "," : "") + std::to_string(probe.dims[k]);
+            out += "],\"sql_bytes\":" + std::to_string(probe.sql_bytes);
+            out += ",\"timeout_ms\":" + std::to_string(probe.timeout.count());
+            out += ",\"status\":";
+            AppendJsonString(CodeName(probe.status), &out);
+            out += ",\"message\":";
+            AppendJsonString(probe.status.message(), &out);
+            out += ",\"latency_us\":" + std::to_string(probe.latency.count());
+            out += ",\"session_us\":" + std::to_string(probe.session_time.count());
+            out += ",\"cpu_us\":" + std::to_string(probe.cpu_time.count());
+            out += ",\"phases_us\":[";
+            for (size_t k = 0; k < kPhaseCount; k++) {
+                out += (k ? "," : "") + std::to_string(probe.phases.time(static_cast<Phase>(k)).count());
+            }
+            out += "]}\n";
+            break;
+        }
+        case ResultsWriter::Format::CSV: {
+            out += "probe,";
+            AppendCsvField(probe.provider, &out);
+            out += ',';
+            AppendCsvField(probe.feature, &out);
+            out += ',' + JoinDims(probe.dims) + ',' + std::to_string(probe.sql_bytes) + ',' +
+                   std::to_string(probe.timeout.count()) + ',' + CodeName(probe.status) + ',';
+            AppendCsvField(probe.status.message(), &out);
+            out += ',' + std::to_string(probe.latency.count()) + ',' + std::to_string(probe.session_time.count()) +
+                   ',' + std::to_string(probe.cpu_time.count());
+            for (size_t k = 0; k < kPhaseCount; k++) {
+                out += ',' + std::to_string(probe.phases.time(static_cast<Phase>(k)).count());
+            }
+            out += ",,\n";
+            break;
+        }
+        case ResultsWriter::Format::BINARY: {
+            std::string record;
+            AppendBinary(kProbeRecord, &record);
+            AppendBinary(std::string_view(probe.provider), &record);
+            AppendBinary(std::string_view(probe.feature), &record);
+            AppendBinary(static_cast<uint32_t>(probe.dims.size()), &record);
+            for (size_t n : probe.dims) AppendBinary(static_cast<uint64_t>(n), &record);
+            AppendBinary(static_cast<uint64_t>(probe.sql_bytes), &record);
+            AppendBinary(static_cast<int64_t>(probe.timeout.count()), &record);
+            AppendBinary(static_cast<int32_t>(probe.status.code()), &record);
+            AppendBinary(std::string_view(probe.status.message()), &record);
+            AppendBinary(static_cast<int64_t>(probe.latency.count()), &record);
+            AppendBinary(static_cast<int64_t>(probe.session_time.count()), &record);
+            AppendBinary(static_cast<int64_t>(probe.cpu_time.count()), &record);
+            for (size_t k = 0; k < kPhaseCount; k++) {
+                AppendBinary(static_cast<int64_t>(probe.phases.time(static_cast<Phase>(k)).count()), &record);
+            }
+            out = SizedRecord(record);
+            break;
+        }
+    }
+    return out;
+}
+
+std::string FormatResult(const Result &result, ResultsWriter::Format format) {
+    std::string out;
+    switch (format) {
+        case ResultsWriter::Format::JSONL:
+            out += "{\"type\":\"result\",\"provider\":";
+            AppendJsonString(result.provider, &out);
+            out += ",\"feature\":";
+            AppendJsonString(result.feature, &out);
+            out += ",\"limit\":" + std::to_string(result.limit);
+            out += ",\"status\":";
+            AppendJsonString(CodeName(result.status), &out);
+            out += ",\"message\":";
+            AppendJsonString(result.status.message(), &out);
+            out += ",\"phase\":";
+            AppendJsonString(PhaseName(result.phase), &out);
+            out += "}\n";
+            break;
+        case ResultsWriter::Format::CSV:
+            out += "result,";
+            AppendCsvField(result.provider, &out);
+            out += ',';
+            AppendCsvField(result.feature, &out);
+            out += ",,,," + CodeName(result.status) + ',';
+            AppendCsvField(result.status.message(), &out);
+            out += ",,,,,,,," + std::to_string(result.limit) + ',' + PhaseName(result.phase) + '\n';
+            break;
+        case ResultsWriter::Format::BINARY: {
+            std::string record;
+            AppendBinary(kResultRecord, &record);
+            AppendBinary(std::string_view(result.provider), &record);
+            AppendBinary(std::string_view(result.feature), &record);
+            AppendBinary(static_cast<uint64_t>(result.limit), &record);
+            AppendBinary(static_cast<int32_t>(result.status.code()), &record);
+            AppendBinary(std::string_view(result.status.message()), &record);
+            AppendBinary(static_cast<uint8_t>(result.phase), &record);
+            out = SizedRecord(record);
+            break;
+        }
+    }
+    return out;
+}
+
+// Value of a JSONL field: a string, a number or an array of numbers
+using JsonValue = std::variant<std::string, int64_t, std::vector<int64_t>>;
+
+// Parses a flat JSON object as written by FormatProbe and FormatResult into @fields
+bool ParseJsonObject(std::string_view line, std::map<std::string, JsonValue> *fields) {
+    size_t pos = 0;
+    auto skip_spaces = [&] {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) pos++;
+    };
+    auto accept = [&](char c) {
+        skip_spaces();
+        if (pos < line.size() && line[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    };
+    auto parse_string = [&](std::string *out) {
+        if (!accept('"')) return false;
+        for (; pos < line.size(); pos++) {
+            char c = line[pos];
+            if (c == '"') {
+                pos++;
+                return true;
+            }
+            if (c != '\\') {
+                *out += c;
+                continue;
+            }
+            if (++pos == line.size()) return false;
+            switch (line[pos]) {
+                case 'n':
+                    *out += '\n';
+                    break;
+                case 't':
+                    *out += '\t';
+                    break;
+                case 'u': {
+                    if (pos + 4 >= line.size()) return false;
+                    const std::string hex(line.substr(pos + 1, 4));
+                    if (hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) return false;
+                    *out += static_cast<char>(std::stoi(hex, nullptr, 16));
+                    pos += 4;
+                    break;
+                }
+                default:
+                    *out += line[pos];
+            }
+        }
+        return false;
+    };
+    auto parse_number = [&](int64_t *out) {
+        skip_spaces();
+        const size_t begin = pos;
+        if (pos < line.size() && line[pos] == '-') pos++;
+        while (pos < line.size() && std::isdigit(static_cast<unsigned char>(line[pos]))) pos++;
+        if (pos == begin || pos - begin > 19) return false;
+        *out = std::stoll(std::string(line.substr(begin, pos - begin)));
+        return true;
+    };
+
+    if (!accept('{')) return false;
+    if (accept('}')) return true;
+    do {
+        std::string key;
+        if (!parse_string(&key) || !accept(':')) return false;
+        skip_spaces();
+        if (pos < line.size() && line[pos] == '"') {
+            std::string value;
+            if (!parse_string(&value)) return false;
+            (*fields)[key] = std::move(value);
+        } else if (accept('[')) {
+            std::vector<int64_t> values;
+            if (!accept(']')) {
+                do {
+                    int64_t value;
+                    if (!parse_number(&value)) return false;
+                    values.push_back(value);
+                } while (accept(','));
+                if (!accept(']')) return false;
+            }
+            (*fields)[key] = std::move(values);
+        } else {
+            int64_t value;
+            if (!parse_number(&value)) return false;
+            (*fields)[key] = value;
+        }
+    } while (accept(','));
+    if (!accept('}')) return false;
+    skip_spaces();
+    return pos == line.size();
+}
+
+bool ReadJsonl(std::istream &file, std::vector<Probe> *probes, std::vector<Result> *results, std::string *error) {
+    std::string line;
+    for (size_t line_number = 1; std::getline(file, line); line_number++) {
+        if (line.empty()) continue;
+        std::map<std::string, JsonValue> fields;
+        bool ok = ParseJsonObject(line, &fields);
+        auto text = [&](const char *key) -> std::string {
+            auto it = fields.find(key);
+            if (it != fields.end() && std::holds_alternative<std::string>(it->second)) {
+                return std::get<std::string>(it->second);
+            }
+            ok = false;
+            return "";
+        };
+        auto number = [&](const char *key) -> int64_t {
+            auto it = fields.find(key);
+            if (it != fields.end() && std::holds_alternative<int64_t>(it->second)) return std::get<int64_t>(it->second);
+            ok = false;
+            return 0;
+        };
+        auto numbers = [&](const char *key) -> std::vector<int64_t> {
+            auto it = fields.find(key);
+            if (it != fields.end() && std::holds_alternative<std::vector<int64_t>>(it->second)) {
+                return std::get<std::vector<int64_t>>(it->second);
+            }
+            ok = false;
+            return {};
+        };
+        Status::Code code = Status::SUCCESS;
+        const std::string type = ok ? text("type") : "";
+        if (ok && type == "probe") {
+            Probe probe;
+            probe.provider = text("provider");
+            probe.feature = text("feature");
+            for (int64_t n : numbers("dims")) probe.dims.push_back(static_cast<size_t>(n));
+            probe.sql_bytes = static_cast<size_t>(number("sql_bytes"));
+            probe.timeout = std::chrono::milliseconds(number("timeout_ms"));
+            ok = ParseCode(text("status"), &code) && ok;
+            probe.status = Status(code, text("message"));
+            probe.latency = std::chrono::microseconds(number("latency_us"));
+            probe.session_time = std::chrono::microseconds(number("session_us"));
+            probe.cpu_time = std::chrono::microseconds(number("cpu_us"));
+            const auto phases = numbers("phases_us");
+            ok = ok && phases.size() == kPhaseCount;
+            for (size_t k = 0; ok && k < kPhaseCount; k++) {
+                probe.phases.set_time(static_cast<Phase>(k), std::chrono::microseconds(phases[k]));
+            }
+            if (ok) probes->push_back(std::move(probe));
+        } else if (ok && type == "result") {
+            Result result;
+            result.provider = text("provider");
+            result.feature = text("feature");
+            result.limit = static_cast<size_t>(number("limit"));
+            ok = ParseCode(text("status"), &code) && ok;
+            result.status = Status(code, text("message"));
+            ok = ParsePhase(text("phase"), &result.phase) && ok;
+            if (ok) results->push_back(std::move(result));
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            *error = std::to_string(line_number) + ": not a record: " + line;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads the fields of a binary record in order, failing once past its end
+class BinaryRecord {
+public:
+    explicit BinaryRecord(std::string_view data) : data_(data) {}
+
+    template <typename T>
+    T Read() {
+        T value{};
+        if (data_.size() - pos_ < sizeof(value)) {
+            ok_ = false;
+            return value;
+        }
+        std::memcpy(&value, data_.data() + pos_, sizeof(value));
+        pos_ += sizeof(value);
+        return value;
+    }
+
+    std::string ReadString() {
+        const uint32_t size = Read<uint32_t>();
+        if (!ok_ || data_.size() - pos_ < size) {
+            ok_ = false;
+            return "";
+        }
+        pos_ += size;
+        return std::string(data_.substr(pos_ - size, size));
+    }
+
+    // Whether all fields were read and nothing is left
+    bool ok() const { return ok_ && pos_ == data_.size(); }
+
+    bool failed() const { return !ok_; }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+bool ReadBinary(const std::string &contents, std::vector<Probe> *probes, std::vector<Result> *results,
+                std::string *error) {
+    size_t pos = sizeof(ResultsWriter::kMagic);
+    while (pos < contents.size()) {
+        uint32_t size;
+        bool ok = contents.size() - pos >= sizeof(size);
+        if (ok) {
+            std::memcpy(&size, contents.data() + pos, sizeof(size));
+            ok = contents.size() - pos - sizeof(size) >= size;
+        }
+        if (ok) {
+            BinaryRecord record(std::string_view(contents).substr(pos + sizeof(size), size));
+            const uint8_t type = record.Read<uint8_t>();
+            if (type == kProbeRecord) {
+                Probe probe;
+                probe.provider = record.ReadString();
+                probe.feature = record.ReadString();
+                const uint32_t count = record.Read<uint32_t>();
+                for (uint32_t k = 0; k < count && !record.failed(); k++) {
+                    probe.dims.push_back(static_cast<size_t>(record.Read<uint64_t>()));
+                }
+                probe.sql_bytes = static_cast<size_t>(record.Read<uint64_t>());
+                probe.timeout = std::chrono::milliseconds(record.Read<int64_t>());
+                const Status::Code code = record.Read<int32_t>();
+                probe.status = Status(code, record.ReadString());
+                probe.latency = std::chrono::microseconds(record.Read<int64_t>());
+                probe.session_time = std::chrono::microseconds(record.Read<int64_t>());
+                probe.cpu_time = std::chrono::microseconds(record.Read<int64_t>());
+                for (size_t k = 0; k < kPhaseCount; k++) {
+                    probe.phases.set_time(static_cast<Phase>(k), std::chrono::microseconds(record.Read<int64_t>()));
+                }
+                ok = record.ok() && code >= Status::SUCCESS && code <= Status::CRASH;
+                if (ok) probes->push_back(std::move(probe));
+            } else if (type == kResultRecord) {
+                Result result;
+                result.provider = record.ReadString();
+                result.feature = record.ReadString();
+                result.limit = static_cast<size_t>(record.Read<uint64_t>());
+                const Status::Code code = record.Read<int32_t>();
+                result.status = Status(code, record.ReadString());
+                const uint8_t phase = record.Read<uint8_t>();
+                result.phase = static_cast<Phase>(phase);
+                ok = record.ok() && phase < kPhaseCount && code >= Status::SUCCESS && code <= Status::CRASH;
+                if (ok) results->push_back(std::move(result));
+            } else {
+                ok = false;
+            }
+        }
+        if (!ok) {
+            *error = "offset " + std::to_string(pos) + ": not a record";
+            return false;
+        }
+        pos += sizeof(size) + size;
+    }
+    return true;
+}
+
+}  // namespace
+
+constexpr char ResultsWriter::kMagic[8];
+
+void AppendJsonString(std::string_view text, std::string *out) {
+    *out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"':
+                *out += "\\\"";
+                break;
+            case '\\':
+                *out += "\\\\";
+                break;
+            case '\n':
+                *out += "\\n";
+                break;
+            case '\t':
+                *out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    *out += escaped;
+                } else {
+                    *out += c;
+                }
+        }
+    }
+    *out += '"';
+}
+
+bool ResultsWriter::ParseFormat(std::string_view name, Format *format) {
+    for (size_t k = 0; k < std::size(kFormatNames); k++) {
+        if (name == kFormatNames[k]) {
+            *format = static_cast<Format>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+ResultsWriter::~ResultsWriter() {
+    std::string error;
+    if (is_open() && !Close(&error)) {
+        std::cerr << "results: " << error << std::endl;
+    }
+}
+
+bool ResultsWriter::Open(const std::string &path, Format format, std::string *error) {
+    if (is_open()) {
+        *error = path_ + " is already open";
+        return false;
+    }
+    file_.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file_) {
+        *error = "cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    path_ = path;
+    format_ = format;
+    closing_ = false;
+    if (format == Format::CSV) pending_ = kCsvHeader;
+    if (format == Format::BINARY) pending_.assign(kMagic, sizeof(kMagic));
+    writer_ = std::thread([this] { Write(); });
+    return true;
+}
+
+void ResultsWriter::OnProbe(const Probe &probe) { Enqueue(FormatProbe(probe, format_)); }
+
+void ResultsWriter::OnResult(const Result &result) { Enqueue(FormatResult(result, format_)); }
+
+bool ResultsWriter::Close(std::string *error) {
+    if (!is_open()) return true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    pending_cv_.notify_one();
+    writer_.join();
+    file_.close();
+    if (file_.fail()) {
+        *error = "cannot write " + path_;
+        return false;
+    }
+    return true;
+}
+
+void ResultsWriter::Enqueue(std::string record) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ += record;
+    }
+    pending_cv_.notify_one();
+}
+
+void ResultsWriter::Write() {
+    std::string batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pending_cv_.wait(lock, [this] { return closing_ || !pending_.empty(); });
+            if (pending_.empty()) break;
+            batch.swap(pending_);
+        }
+        file_.write(batch.data(), batch.size());
+        batch.clear();
+    }
+    file_.flush();
+}
+
+bool ReadResults(const std::string &path, std::vector<Probe> *probes, std::vector<Result> *results,
+                 std::string *error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        *error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    char magic[sizeof(ResultsWriter::kMagic)] = {};
+    file.read(magic, sizeof(magic));
+    const bool binary = file.gcount() == sizeof(magic) && std::memcmp(magic, ResultsWriter::kMagic, sizeof(magic)) == 0;
+    file.clear();
+    file.seekg(0);
+    bool ok;
+    if (binary) {
+        std::string contents(std::istreambuf_iterator<char>(file), {});
+        ok = ReadBinary(contents, probes, results, error);
+    } else {
+        ok = ReadJsonl(file, probes, results, error);
+    }
+    if (!ok) *error = path + ":" + *error;
+    return ok;
+}
+
+}  // namespace tensile
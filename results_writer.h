@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "tensile.h"
+
+namespace tensile {
+
+// Streams every probe and result of a driver to a file, one record each. Records are formatted on
+// the thread which checks the probes and written by a background thread. The driver reports all
+// probes from its own process, so the output is the same whether statements are checked in
+// process, forked or in batches. Formats:
+//
+// JSONL - one object per line, with "type" of "probe" or "result":
+//     {"type":"probe","provider":"p","feature":"f","dims":[3,40],"sql_bytes":120,"timeout_ms":100,
+//      "status":"Error","message":"m","latency_us":12,"session_us":0,"cpu_us":11,
+//      "phases_us":[0,0,0,12]}
+//     {"type":"result","provider":"p","feature":"f","limit":38,"status":"Error","message":"m",
+//      "phase":"execute"}
+//
+// CSV - a header line, then the same fields for both types, with dims joined by 'x', phase times
+// in columns of their own and fields which do not apply left empty.
+//
+// BINARY - kMagic, then records of a 32-bit size of the rest of the record, a byte of type
+// (1 for probe, 2 for result) and the fields in the order of JSONL. Strings are a 32-bit size and
+// the bytes, dims a 32-bit count and 64-bit sizes, the status a 32-bit code, the phase a byte and
+// other numbers 64-bit. Integers are native-endian.
+class ResultsWriter : public IProbeListener {
+public:
+    enum class Format { JSONL, CSV, BINARY };
+
+    static constexpr char kMagic[8] = {'T', 'N', 'S', 'R', 'S', 'L', 'T', '1'};
+
+    // Sets @format from its lowercase name. Returns false if there is no format of that name.
+    static bool ParseFormat(std::string_view name, Format *format);
+
+    ResultsWriter() {}
+
+    // Closes the file, reporting write errors to stderr
+    ~ResultsWriter() override;
+
+    // Creates the file at @path. Returns false with the reason in @error on failure, or if a file
+    // is open already.
+    bool Open(const std::string &path, Format format, std::string *error);
+
+    void OnProbe(const Probe &probe) override;
+
+    void OnResult(const Result &result) override;
+
+    // Writes the pending records and closes the file. Returns false with the reason in @error if
+    // writing failed.
+    bool Close(std::string *error);
+
+    bool is_open() const { return writer_.joinable(); }
+
+private:
+    void Enqueue(std::string record);
+
+    // Body of the background thread
+    void Write();
+
+    Format format_ = Format::JSONL;
+    std::string path_;
+    std::ofstream file_;
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable pending_cv_;
+    // Formatted records not yet written
+    std::string pending_;
+    bool closing_ = false;
+};
+
+// Appends @text to @out as a JSON string, with quotes and escapes
+void AppendJsonString(std::string_view text, std::string *out);
+
+// Reads the probes and results at @path, written by ResultsWriter in JSONL or BINARY format,
+// which is told from the content. Returns false with the reason in @error if the file cannot be
+// read.
+bool ReadResults(const std::string &path, std::vector<Probe> *probes, std::vector<Result> *results,
+                 std::string *error);
+
+}  // namespace tensile
@@ -0,0 +1,196 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include "reference_parser.h"
+#include "results_writer.h"
+
+#include <sstream>
+
+namespace tensile {
+namespace {
+
+std::string Path(const std::string &name) { return testing::TempDir() + name; }
+
+std::string Contents(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+Probe TestProbe() {
+    Probe probe;
+    probe.provider = "provider, \"quoted\"";
+    probe.feature = "subselect in FROM x select list";
+    probe.dims = {3, 40};
+    probe.sql_bytes = 1234;
+    probe.timeout = std::chrono::milliseconds(100);
+    probe.status = Status(Status::ERROR, "line\nbreak\ttab \x01");
+    probe.latency = std::chrono::microseconds(123456);
+    probe.session_time = std::chrono::microseconds(7);
+    probe.cpu_time = std::chrono::microseconds(99);
+    probe.phases.set_time(Phase::OPTIMIZE, std::chrono::microseconds(5));
+    return probe;
+}
+
+Result TestResult() {
+    Result result;
+    result.provider = "provider";
+    result.feature = "parenthesis";
+    result.limit = 38;
+    result.status = Status(Status::CRASH, "stack overflow");
+    result.phase = Phase::BIND;
+    return result;
+}
+
+TEST(ResultsWriter, WriteAndRead) {
+    for (auto format : {ResultsWriter::Format::JSONL, ResultsWriter::Format::BINARY}) {
+        const std::string path = Path("results_write_and_read");
+        {
+            ResultsWriter writer;
+            std::string error;
+            ASSERT_TRUE(writer.Open(path, format, &error)) << error;
+            writer.OnProbe(TestProbe());
+            writer.OnResult(TestResult());
+            ASSERT_TRUE(writer.Close(&error)) << error;
+        }
+        std::vector<Probe> probes;
+        std::vector<Result> results;
+        std::string error;
+        ASSERT_TRUE(ReadResults(path, &probes, &results, &error)) << error;
+        ASSERT_EQ(1, probes.size());
+        const Probe expected = TestProbe();
+        EXPECT_EQ(expected.provider, probes[0].provider);
+        EXPECT_EQ(expected.feature, probes[0].feature);
+        EXPECT_EQ(expected.dims, probes[0].dims);
+        EXPECT_EQ(expected.sql_bytes, probes[0].sql_bytes);
+        EXPECT_EQ(expected.timeout, probes[0].timeout);
+        EXPECT_EQ(expected.status.code(), probes[0].status.code());
+        EXPECT_EQ(expected.status.message(), probes[0].status.message());
+        EXPECT_EQ(expected.latency, probes[0].latency);
+        EXPECT_EQ(expected.session_time, probes[0].session_time);
+        EXPECT_EQ(expected.cpu_time, probes[0].cpu_time);
+        EXPECT_EQ(5, probes[0].phases.time(Phase::OPTIMIZE).count());
+        ASSERT_EQ(1, results.size());
+        EXPECT_EQ("parenthesis", results[0].feature);
+        EXPECT_EQ(38, results[0].limit);
+        EXPECT_EQ(Status::CRASH, results[0].status.code());
+        EXPECT_EQ("stack overflow", results[0].status.message());
+        EXPECT_EQ(Phase::BIND, results[0].phase);
+
+        // Truncated files are rejected
+        const std::string contents = Contents(path);
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << contents.substr(0, contents.size() - 3);
+        EXPECT_FALSE(ReadResults(path, &probes, &results, &error));
+        EXPECT_THAT(error, testing::HasSubstr("not a record"));
+    }
+}
+
+TEST(ResultsWriter, UnknownStatusCode) {
+    // Codes past CRASH only come from corrupt files, and are rejected in every format
+    for (auto format : {ResultsWriter::Format::JSONL, ResultsWriter::Format::BINARY}) {
+        for (bool is_probe : {true, false}) {
+            const std::string path = Path("results_unknown_status_code");
+            {
+                ResultsWriter writer;
+                std::string error;
+                ASSERT_TRUE(writer.Open(path, format, &error)) << error;
+                Probe probe = TestProbe();
+                Result result = TestResult();
+                probe.status = result.status = Status(Status::CRASH + 1);
+                if (is_probe) {
+                    writer.OnProbe(probe);
+                } else {
+                    writer.OnResult(result);
+                }
+            }
+            std::vector<Probe> probes;
+            std::vector<Result> results;
+            std::string error;
+            EXPECT_FALSE(ReadResults(path, &probes, &results, &error));
+        }
+    }
+}
+
+TEST(ResultsWriter, Csv) {
+    const std::string path = Path("results_csv");
+    {
+        ResultsWriter writer;
+        std::string error;
+        ASSERT_TRUE(writer.Open(path, ResultsWriter::Format::CSV, &error)) << error;
+        writer.OnProbe(TestProbe());
+        writer.OnResult(TestResult());
+    }
+    std::istringstream lines(Contents(path));
+    std::string line;
+    std::getline(lines, line);
+    EXPECT_EQ(16, std::count(line.begin(), line.end(), ','));
+    EXPECT_EQ("type", line.substr(0, 4));
+    std::getline(lines, line);
+    EXPECT_EQ("probe,\"provider, \"\"quoted\"\"\",subselect in FROM x select list,3x40,1234,100,Error,\"line", line);
+    std::getline(lines, line);
+    EXPECT_EQ("break\ttab \x01\",123456,7,99,0,0,5,0,,", line);
+    std::getline(lines, line);
+    EXPECT_EQ("result,provider,parenthesis,,,,Crash,stack overflow,,,,,,,,38,bind", line);
+}
+
+TEST(ResultsWriter, OpenTwice) {
+    const std::string path = Path("results_open_twice");
+    ResultsWriter writer;
+    std::string error;
+    ASSERT_TRUE(writer.Open(path, ResultsWriter::Format::JSONL, &error)) << error;
+    EXPECT_FALSE(writer.Open(Path("results_open_twice_again"), ResultsWriter::Format::JSONL, &error));
+    EXPECT_THAT(error, testing::HasSubstr("already open"));
+    writer.OnResult(TestResult());
+    ASSERT_TRUE(writer.Close(&error)) << error;
+    // Once closed, the writer can open another file
+    EXPECT_TRUE(writer.Open(path, ResultsWriter::Format::JSONL, &error)) << error;
+    EXPECT_TRUE(writer.Close(&error)) << error;
+}
+
+TEST(ResultsWriter, SameInEveryMode) {
+    // Probes and results of a search are the same whether checked in process or forked, apart
+    // from their timing, and replaying the search gives the same probes with a result for each
+    const std::string log = Path("results_same_in_every_mode.log");
+    std::vector<std::vector<std::string>> records;
+    std::vector<std::vector<std::string>> probe_records;
+    size_t replayed_results = 0;
+    for (int mode = 0; mode < 3; mode++) {
+        const std::string path = Path("results_same_in_every_mode");
+        {
+            const std::string flag = "--results=" + path;
+            const std::string log_flag = (mode == 2 ? "--replay=" : "--record=") + log;
+            const char *argv[] = {"test", flag.c_str(), "--results_format=binary", "--features=parenthesis",
+                                  log_flag.c_str(), nullptr};
+            Driver driver(5, const_cast<char **>(argv));
+            driver.set_check_crash(mode == 1);
+            ReferenceParser::Limits limits;
+            limits.max_depth = 40;
+            driver.AddProvider(std::make_unique<ReferenceParser>(limits));
+            driver.Run();
+        }
+        std::vector<Probe> probes;
+        std::vector<Result> results;
+        std::string error;
+        ASSERT_TRUE(ReadResults(path, &probes, &results, &error)) << error;
+        probe_records.emplace_back();
+        for (const auto &probe : probes) {
+            probe_records.back().push_back(probe.feature + " " + std::to_string(probe.dims[0]) + " " +
+                                           std::to_string(probe.sql_bytes) + " " + probe.status.ToString());
+        }
+        if (mode == 2) {
+            replayed_results = results.size();
+            break;
+        }
+        records.push_back(probe_records.back());
+        for (const auto &result : results) {
+            records.back().push_back(result.feature + " " + std::to_string(result.limit) + " " +
+                                     result.status.ToString());
+        }
+    }
+    ASSERT_FALSE(records[0].empty());
+    EXPECT_EQ(records[0], records[1]);
+    EXPECT_THAT(records[0], testing::Contains(testing::StartsWith("parenthesis 38 ")));
+    EXPECT_EQ(probe_records[0], probe_records[2]);
+    EXPECT_EQ(probe_records[0].size(), replayed_results);
+}
+
+}  // namespace
+}  // namespace tensile
@@ -0,0 +1,115 @@
+// Cost of the driver's search strategies, measured against synthetic providers (see
+// synthetic_provider.h) whose limits are known.
+//
+// Every strategy runs once per provider and checking mode (in process, or forked to catch crashes;
+// providers which crash are only run forked). Reported per run:
+//     probes   - statements checked
+//     limit    - largest size found to succeed
+//     expected - limit of the provider's model
+//     accuracy - limit over expected: below 1 the search stopped short, above 1 it reported sizes
+//                which fail as successful
+// Wall time of the whole search is the benchmark time.
+//
+// Strategies:
+//     search   - doubling then bisection (Driver::Run without exploring beyond the first failure)
+//     explore  - the same, then doubling beyond the first failure
+//     frontier - staircase search of a two-dimensional feature (Driver::RunFrontier), whose
+//                statements are rows x width bytes. Accuracy is the mean over the frontier of
+//                rows x width over expected.
+#include <benchmark/benchmark.h>
+#include "synthetic_provider.h"
+
+namespace tensile {
+namespace {
+
+constexpr std::chrono::milliseconds kTimeout(20);
+
+// SQL of @n bytes
+class LengthFeature : public ISQLFeature {
+public:
+    std::string name() override { return "length"; }
+    std::string_view GenerateSQL(size_t n) override {
+        sql_.assign(n, 'x');
+        return sql_;
+    }
+
+private:
+    std::string sql_;
+};
+
+// SQL of @dims[0] rows of @dims[1] bytes
+class AreaFeature : public IMultiSQLFeature {
+public:
+    std::string name() override { return "area"; }
+    std::vector<std::string> dimension_names() override { return {"rows", "width"}; }
+    std::string_view GenerateSQL(const std::vector<size_t> &dims) override {
+        sql_.assign(dims[0] * dims[1], 'x');
+        return sql_;
+    }
+};
+
+class ProbeCounter : public IProbeListener {
+public:
+    explicit ProbeCounter(size_t *probes) : probes_(probes) {}
+    void OnProbe(const Probe &probe) override { ++*probes_; }
+
+private:
+    size_t *probes_;
+};
+
+enum class Strategy { SEARCH, EXPLORE, FRONTIER };
+
+void BM_Search(benchmark::State &state, SyntheticProvider *provider, Strategy strategy, bool check_crash) {
+    size_t probes = 0;
+    double limit = 0;
+    Driver driver;
+    driver.set_timeout(kTimeout);
+    driver.set_check_crash(check_crash);
+    driver.set_explore_beyond_first_failure(strategy == Strategy::EXPLORE);
+    driver.AddProbeListener(std::make_unique<ProbeCounter>(&probes));
+    for (auto _ : state) {
+        if (strategy == Strategy::FRONTIER) {
+            AreaFeature feature;
+            auto result = driver.RunFrontier(provider, &feature);
+            limit = 0;
+            for (const auto &point : result.frontier) limit += static_cast<double>(point[0] * point[1]);
+            if (!result.frontier.empty()) limit /= result.frontier.size();
+        } else {
+            LengthFeature feature;
+            limit = static_cast<double>(driver.Run(provider, &feature)[0].limit);
+        }
+    }
+    const double expected = static_cast<double>(provider->model().Limit(kTimeout));
+    state.counters["probes"] = benchmark::Counter(probes, benchmark::Counter::kAvgIterations);
+    state.counters["limit"] = limit;
+    state.counters["expected"] = expected;
+    state.counters["accuracy"] = expected > 0 ? limit / expected : 0;
+}
+
+}  // namespace
+}  // namespace tensile
+
+int main(int argc, char **argv) {
+    using namespace tensile;
+    auto providers = GetSyntheticProviders();
+    const std::pair<Strategy, const char *> strategies[] = {
+            {Strategy::SEARCH, "search"}, {Strategy::EXPLORE, "explore"}, {Strategy::FRONTIER, "frontier"}};
+    for (auto &provider : providers) {
+        for (const auto &[strategy, strategy_name] : strategies) {
+            for (bool check_crash : {false, true}) {
+                if (!check_crash && provider->model().crash_at > 0) continue;
+                const std::string name =
+                        provider->name() + "/" + strategy_name + "/" + (check_crash ? "fork" : "in_process");
+                benchmark::RegisterBenchmark(name.c_str(), BM_Search, provider.get(), strategy, check_crash)
+                        ->Iterations(1)
+                        ->UseRealTime()
+                        ->Unit(benchmark::kMillisecond);
+            }
+        }
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
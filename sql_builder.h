@@ -0,0 +1,142 @@
+#pragma once
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace tensile {
+
+// Appends SQL text to a string owned by the caller, usually ISQLFeature::sql_. Numbers are
+// formatted in place and repeated fragments are copied in bulk, so once the string has grown
+// to the size of the largest statement, building SQL does not allocate:
+//
+//     SqlBuilder sql(&sql_);
+//     sql.Clear().Reserve(size).Append("select ").AppendNumber(n).Repeat(",1", n);
+class SqlBuilder {
+public:
+    // Longest decimal representation of size_t
+    static constexpr size_t kMaxDigits = std::numeric_limits<size_t>::digits10 + 1;
+
+    explicit SqlBuilder(std::string *sql) : sql_(sql) {}
+
+    // Empties the SQL, keeping its buffer for the next statement.
+    SqlBuilder &Clear() {
+        sql_->clear();
+        return *this;
+    }
+
+    // Makes room for @size more bytes, so appending them does not reallocate.
+    SqlBuilder &Reserve(size_t size) {
+        sql_->reserve(sql_->size() + size);
+        return *this;
+    }
+
+    SqlBuilder &Append(std::string_view text) {
+        sql_->append(text);
+        return *this;
+    }
+
+    // Appends @value in decimal, padded with zeros to at least @min_digits digits.
+    SqlBuilder &AppendNumber(size_t value, size_t min_digits = 1) {
+        const size_t digits = Digits(value);
+        if (digits < min_digits) sql_->append(min_digits - digits, '0');
+        PutNumber(Extend(digits), value);
+        return *this;
+    }
+
+    // Appends @count copies of @fragment.
+    SqlBuilder &Repeat(std::string_view fragment, size_t count) {
+        if (count == 0 || fragment.empty()) return *this;
+        char *p = Extend(fragment.size() * count);
+        Put(p, fragment);
+        FillRepeated(p, fragment.size(), fragment.size() * count);
+        return *this;
+    }
+
+    // Grows the SQL by @size bytes and returns where they start, for callers that write the
+    // bytes themselves with Put/PutNumber.
+    char *Extend(size_t size) {
+        const size_t at = sql_->size();
+        sql_->resize(at + size);
+        return &(*sql_)[at];
+    }
+
+    size_t size() const { return sql_->size(); }
+
+    // Copies @text to @p and returns the end of the copy.
+    static char *Put(char *p, std::string_view text) {
+        if (!text.empty()) memcpy(p, text.data(), text.size());
+        return p + text.size();
+    }
+
+    // Writes @value in decimal to @p and returns the end of it.
+    static char *PutNumber(char *p, size_t value) { return std::to_chars(p, p + kMaxDigits, value).ptr; }
+
+    // Copies the first @unit bytes at @p over the following @total - @unit bytes, doubling the
+    // copied run each time.
+    static void FillRepeated(char *p, size_t unit, size_t total) {
+        for (size_t done = unit; done < total;) {
+            const size_t n = done < total - done ? done : total - done;
+            memcpy(p + done, p, n);
+            done += n;
+        }
+    }
+
+    // Calls @fill(chunk_begin, chunk_end) for @threads disjoint chunks covering [@begin, @end),
+    // each on its own thread except the first, which runs on the calling thread. Chunks must
+    // write to disjoint bytes, so that the result does not depend on the order they run in.
+    // Threads are started per call rather than kept in a pool: the driver forks while checking
+    // SQL, and a pool's threads would be missing in the child.
+    template <typename Fill>
+    static void ParallelFill(size_t begin, size_t end, size_t threads, const Fill &fill) {
+        if (threads <= 1 || end - begin < threads) {
+            fill(begin, end);
+            return;
+        }
+        const size_t chunk = (end - begin) / threads;
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (size_t t = 1; t < threads; t++) {
+            const size_t chunk_begin = begin + t * chunk;
+            const size_t chunk_end = t + 1 == threads ? end : chunk_begin + chunk;
+            workers.emplace_back([&fill, chunk_begin, chunk_end] { fill(chunk_begin, chunk_end); });
+        }
+        fill(begin, begin + chunk);
+        for (auto &worker : workers) worker.join();
+    }
+
+    // Number of decimal digits of @value.
+    static constexpr size_t Digits(size_t value) {
+        size_t digits = 1;
+        for (; value >= 10; value /= 10) digits++;
+        return digits;
+    }
+
+    // Total number of decimal digits of all integers in [@begin, @end).
+    static constexpr size_t DigitsInRange(size_t begin, size_t end) {
+        size_t total = 0;
+        size_t high = 10;
+        for (size_t digits = 1; begin < end; digits++) {
+            if (begin < high) {
+                const size_t stop = end < high ? end : high;
+                total += (stop - begin) * digits;
+                begin = stop;
+            }
+            if (high > std::numeric_limits<size_t>::max() / 10) {
+                total += (end - begin) * (digits + 1);
+                break;
+            }
+            high *= 10;
+        }
+        return total;
+    }
+
+private:
+    std::string *sql_;
+};
+
+}  // namespace tensile
@@ -0,0 +1,436 @@
+#include "sql_lexer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define TENSILE_LEXER_X86 1
+#endif
+
+namespace tensile {
+namespace lexer_internal {
+
+namespace {
+
+constexpr size_t kChunk = 64;
+constexpr size_t kKinds = 3;
+constexpr char kOpen[kKinds] = {'(', '[', '{'};
+constexpr char kClose[kKinds] = {')', ']', '}'};
+constexpr size_t kKindBits = 2;
+constexpr uint8_t kKindMask = (1 << kKindBits) - 1;
+constexpr uint8_t kClosing = 1 << kKindBits;
+
+// Kind of every bracket byte, with kClosing for closing ones
+struct BracketCodes {
+    uint8_t codes[256] = {};
+    constexpr BracketCodes() {
+        for (size_t k = 0; k < kKinds; k++) {
+            codes[static_cast<unsigned char>(kOpen[k])] = k;
+            codes[static_cast<unsigned char>(kClose[k])] = k | kClosing;
+        }
+    }
+};
+constexpr BracketCodes kBrackets;
+
+// Bit i of each mask describes byte i of a 64-byte chunk.
+struct Masks {
+    // Single quotes, resolved into string literals within the chunk
+    uint64_t quote = 0;
+    // Other bytes which may start a literal or a comment: ", $, -- and /*
+    uint64_t special = 0;
+    uint64_t open[kKinds] = {};
+    uint64_t close[kKinds] = {};
+};
+
+// Classifiers read kChunk + 1 bytes at @p, the last one to recognize -- and /* at the end.
+Masks ClassifyScalar(const char *p) {
+    Masks m;
+    for (size_t i = 0; i < kChunk; i++) {
+        const uint64_t bit = uint64_t(1) << i;
+        switch (p[i]) {
+            case '\'': m.quote |= bit; break;
+            case '"': case '$': m.special |= bit; break;
+            case '-': if (p[i + 1] == '-') m.special |= bit; break;
+            case '/': if (p[i + 1] == '*') m.special |= bit; break;
+            case '(': m.open[0] |= bit; break;
+            case '[': m.open[1] |= bit; break;
+            case '{': m.open[2] |= bit; break;
+            case ')': m.close[0] |= bit; break;
+            case ']': m.close[1] |= bit; break;
+            case '}': m.close[2] |= bit; break;
+            default: break;
+        }
+    }
+    return m;
+}
+
+// Bytes of @first followed by a byte of @second, where @next says whether the byte after the
+// chunk is one.
+uint64_t Pairs(uint64_t first, uint64_t second, bool next) {
+    return first & (second >> 1 | uint64_t(next) << (kChunk - 1));
+}
+
+#ifdef TENSILE_LEXER_X86
+
+// Mask of bytes equal to @c in 64 bytes loaded into @v.
+uint64_t EqSse2(const __m128i *v, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    uint64_t mask = 0;
+    for (size_t i = 0; i < 4; i++) {
+        mask |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v[i], needle)))) << (16 * i);
+    }
+    return mask;
+}
+
+Masks ClassifySse2(const char *p) {
+    __m128i v[4];
+    for (size_t i = 0; i < 4; i++) v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+    Masks m;
+    m.quote = EqSse2(v, '\'');
+    m.special = EqSse2(v, '"') | EqSse2(v, '$') | Pairs(EqSse2(v, '-'), EqSse2(v, '-'), p[kChunk] == '-') |
+                Pairs(EqSse2(v, '/'), EqSse2(v, '*'), p[kChunk] == '*');
+    m.open[0] = EqSse2(v, kOpen[0]);
+    m.open[1] = EqSse2(v, kOpen[1]);
+    m.open[2] = EqSse2(v, kOpen[2]);
+    m.close[0] = EqSse2(v, kClose[0]);
+    m.close[1] = EqSse2(v, kClose[1]);
+    m.close[2] = EqSse2(v, kClose[2]);
+    return m;
+}
+
+// AVX2 classifies all bytes at once into bits of a class byte, looked up by the low and the
+// high nibble of the byte and and-ed, like in simdjson. Only ' " $ - / * ( ) get bits of their
+// own; [ ] { } share one and are told apart by bits of the byte itself.
+enum ClassBit : uint8_t {
+    kQuoteBit = 1 << 0,
+    kSpecialBit = 1 << 1,  // " and $
+    kDashBit = 1 << 2,
+    kSlashBit = 1 << 3,
+    kStarBit = 1 << 4,
+    kOpenParenBit = 1 << 5,
+    kCloseParenBit = 1 << 6,
+    kOtherBracketBit = 1 << 7,  // [ ] { }, the closing ones with bit 2 set and curly with bit 5
+};
+
+// Bit 7 of every byte of @v shifted left by @shift, for 32 bytes of @low and 32 of @high.
+template <int shift>
+__attribute__((target("avx2"))) uint64_t BitAvx2(__m256i low, __m256i high) {
+    if constexpr (shift == 0) {
+        return uint32_t(_mm256_movemask_epi8(low)) | uint64_t(uint32_t(_mm256_movemask_epi8(high))) << 32;
+    } else {
+        return uint32_t(_mm256_movemask_epi8(_mm256_slli_epi16(low, shift))) |
+               uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_slli_epi16(high, shift)))) << 32;
+    }
+}
+
+__attribute__((target("avx2"))) __m256i ClassesAvx2(__m256i v) {
+    const __m256i by_low = _mm256_setr_epi8(
+            0, 0, kSpecialBit, 0, kSpecialBit, 0, 0, kQuoteBit,
+            kOpenParenBit, kCloseParenBit, kStarBit, kOtherBracketBit, 0, kDashBit | kOtherBracketBit, 0, kSlashBit,
+            0, 0, kSpecialBit, 0, kSpecialBit, 0, 0, kQuoteBit,
+            kOpenParenBit, kCloseParenBit, kStarBit, kOtherBracketBit, 0, kDashBit | kOtherBracketBit, 0, kSlashBit);
+    const char k2 = 0x7f, k5 = char(kOtherBracketBit), k7 = char(kOtherBracketBit);
+    const __m256i by_high = _mm256_setr_epi8(
+            0, 0, k2, 0, 0, k5, 0, k7, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, k2, 0, 0, k5, 0, k7, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i low = _mm256_shuffle_epi8(by_low, _mm256_and_si256(v, nibble));
+    const __m256i high = _mm256_shuffle_epi8(by_high, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    return _mm256_and_si256(low, high);
+}
+
+__attribute__((target("avx2"))) Masks ClassifyAvx2(const char *p) {
+    const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+    const __m256i low_classes = ClassesAvx2(low);
+    const __m256i high_classes = ClassesAvx2(high);
+    Masks m;
+    const __m256i any = _mm256_or_si256(low_classes, high_classes);
+    if (_mm256_testz_si256(any, any)) return m;
+    m.quote = BitAvx2<7>(low_classes, high_classes);
+    m.special = BitAvx2<6>(low_classes, high_classes) |
+                Pairs(BitAvx2<5>(low_classes, high_classes), BitAvx2<5>(low_classes, high_classes), p[kChunk] == '-') |
+                Pairs(BitAvx2<4>(low_classes, high_classes), BitAvx2<3>(low_classes, high_classes), p[kChunk] == '*');
+    m.open[0] = BitAvx2<2>(low_classes, high_classes);
+    m.close[0] = BitAvx2<1>(low_classes, high_classes);
+    const uint64_t other = BitAvx2<0>(low_classes, high_classes);
+    if (other != 0) {
+        const uint64_t closing = BitAvx2<5>(low, high);
+        const uint64_t curly = BitAvx2<2>(low, high);
+        m.open[1] = other & ~closing & ~curly;
+        m.close[1] = other & closing & ~curly;
+        m.open[2] = other & ~closing & curly;
+        m.close[2] = other & closing & curly;
+    }
+    return m;
+}
+
+#endif  // TENSILE_LEXER_X86
+
+size_t Fail(std::string *reason, std::string message, size_t offset) {
+    if (reason) *reason = std::move(message);
+    return offset;
+}
+
+bool IsIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' ||
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+// Bit i is the parity of bits 0..i of @x.
+uint64_t PrefixXor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Skips the literal or comment starting at @at, which is marked special, and returns where the
+// code continues, or std::string_view::npos with @error set if it is not terminated.
+size_t Skip(std::string_view sql, size_t at, std::string *reason, size_t *error) {
+    const char *data = sql.data();
+    const size_t size = sql.size();
+    switch (sql[at]) {
+        case '"': {
+            // Quotes inside are doubled, which looks like two adjacent identifiers
+            const void *end = memchr(data + at + 1, '"', size - at - 1);
+            if (end == nullptr) {
+                *error = Fail(reason, "unterminated quoted identifier", at);
+                return std::string_view::npos;
+            }
+            return static_cast<const char *>(end) - data + 1;
+        }
+        case '-': {
+            if (at + 2 > size) return size;
+            const void *end = memchr(data + at + 2, '\n', size - at - 2);
+            return end == nullptr ? size : static_cast<const char *>(end) - data + 1;
+        }
+        case '/': {
+            // Block comments nest. Every opening and closing delimiter contains a '*', and no
+            // byte is taken for two delimiters.
+            if (at + 2 > size) {
+                *error = Fail(reason, "unterminated comment", at);
+                return std::string_view::npos;
+            }
+            size_t depth = 1;
+            for (size_t from = at + 2; from < size;) {
+                const void *star = memchr(data + from, '*', size - from);
+                if (star == nullptr) break;
+                const size_t i = static_cast<const char *>(star) - data;
+                if (i > from && data[i - 1] == '/') {
+                    depth++;
+                    from = i + 1;
+                } else if (i + 1 < size && data[i + 1] == '/') {
+                    if (--depth == 0) return i + 2;
+                    from = i + 2;
+                } else {
+                    from = i + 1;
+                }
+            }
+            *error = Fail(reason, "unterminated comment", at);
+            return std::string_view::npos;
+        }
+        default: {
+            // $tag$ ... $tag$ with a possibly empty tag, unless the $ is a part of an identifier
+            // or a positional parameter like $1
+            if (at > 0 && (IsIdentifierChar(sql[at - 1]) || sql[at - 1] == '$')) return at + 1;
+            size_t i = at + 1;
+            if (i < size && sql[i] >= '0' && sql[i] <= '9') return at + 1;
+            while (i < size && IsIdentifierChar(sql[i])) i++;
+            if (i >= size || sql[i] != '$') return at + 1;
+            const std::string_view delimiter = sql.substr(at, i - at + 1);
+            const size_t end = sql.find(delimiter, i + 1);
+            if (end == std::string_view::npos) {
+                *error = Fail(reason, "unterminated dollar-quoted string", at);
+                return std::string_view::npos;
+            }
+            return end + delimiter.size();
+        }
+    }
+}
+
+// Stack of open brackets, kept as runs of the same kind so that a chunk with brackets of a
+// single kind is applied with a couple of popcounts.
+class BracketStack {
+public:
+    // Applies brackets of @m selected by @select in the chunk at @base. Returns false with
+    // @error set if they do not balance.
+    bool Apply(const Masks &m, uint64_t select, std::string_view sql, size_t base, std::string *reason,
+               size_t *error) {
+        uint64_t all = 0;
+        for (size_t k = 0; k < kKinds; k++) all |= (m.open[k] | m.close[k]) & select;
+        if (all == 0) return true;
+        for (size_t k = 0; k < kKinds; k++) {
+            const uint64_t open = m.open[k] & select;
+            const uint64_t close = m.close[k] & select;
+            if ((open | close) != all) continue;
+            const size_t closes = __builtin_popcountll(close);
+            // The top run cannot empty midway, so neither can the stack
+            if (!runs_.empty() && Kind(runs_.back()) == k && Count(runs_.back()) > closes) {
+                runs_.back() -= closes << kKindBits;
+                Push(k, __builtin_popcountll(open), base);
+                return true;
+            }
+            if (closes == 0) {
+                Push(k, __builtin_popcountll(open), base + __builtin_ctzll(open));
+                return true;
+            }
+            break;
+        }
+        // Brackets of several kinds, one at a time
+        for (; all != 0; all &= all - 1) {
+            const size_t offset = base + __builtin_ctzll(all);
+            const uint8_t code = kBrackets.codes[static_cast<unsigned char>(sql[offset])];
+            const size_t k = code & kKindMask;
+            if ((code & kClosing) == 0) {
+                if (!runs_.empty() && Kind(runs_.back()) == k && Count(runs_.back()) < kMaxCount) {
+                    runs_.back() += 1 << kKindBits;
+                } else {
+                    Push(k, 1, offset);
+                }
+                continue;
+            }
+            if (runs_.empty()) {
+                *error = Fail(reason, std::string("unmatched '") + kClose[k] + "'", offset);
+                return false;
+            }
+            if (Kind(runs_.back()) != k) {
+                *error = Fail(reason, std::string("'") + kOpen[Kind(runs_.back())] + "' closed by '" + kClose[k] + "'",
+                              offset);
+                return false;
+            }
+            runs_.back() -= 1 << kKindBits;
+            if (Count(runs_.back()) == 0) runs_.pop_back();
+        }
+        return true;
+    }
+
+    // Offset of the earliest bracket left open, or npos.
+    size_t Finish(std::string *reason) const {
+        if (runs_.empty()) return std::string_view::npos;
+        return Fail(reason, std::string("unmatched '") + kOpen[Kind(runs_.front())] + "'", bottom_);
+    }
+
+private:
+    // Runs are packed into 32 bits, so that deep nesting of alternating kinds stays small
+    static constexpr size_t kMaxCount = (size_t(1) << (32 - kKindBits)) - 1;
+
+    static size_t Kind(uint32_t run) { return run & kKindMask; }
+    static size_t Count(uint32_t run) { return run >> kKindBits; }
+
+    // Pushes @count brackets of @kind, the first of which is at @offset.
+    void Push(size_t kind, size_t count, size_t offset) {
+        if (count == 0) return;
+        if (runs_.empty()) bottom_ = offset;
+        if (!runs_.empty() && Kind(runs_.back()) == kind) {
+            const size_t add = std::min(count, kMaxCount - Count(runs_.back()));
+            runs_.back() += add << kKindBits;
+            count -= add;
+        }
+        for (; count > 0; count -= std::min(count, kMaxCount)) {
+            runs_.push_back(std::min(count, kMaxCount) << kKindBits | kind);
+        }
+    }
+
+    std::vector<uint32_t> runs_;
+    // Offset of the bottom bracket, which is the earliest one open
+    size_t bottom_ = 0;
+};
+
+template <Masks (*kClassify)(const char *)>
+size_t Scan(std::string_view sql, std::string *reason) {
+    BracketStack stack;
+    size_t error = std::string_view::npos;
+    // Whether a string literal started at @quote_start is open at the end of the last chunk
+    bool in_quote = false;
+    size_t quote_start = 0;
+    char tail[kChunk + 1];
+    for (size_t pos = 0; pos < sql.size();) {
+        const size_t length = sql.size() - pos > kChunk ? kChunk : sql.size() - pos;
+        Masks m;
+        // Classifiers read a byte past the chunk, so the last one is always padded
+        if (sql.size() - pos > kChunk) {
+            m = kClassify(sql.data() + pos);
+        } else {
+            // Zeros are neither brackets nor special, so the padding adds nothing
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, sql.data() + pos, length);
+            m = kClassify(tail);
+        }
+        // Bytes of the chunk not skipped as a part of a literal or comment yet
+        uint64_t from = ~uint64_t(0);
+        for (;;) {
+            // String literals are the bytes after an odd number of quotes, which also holds for
+            // quotes doubled inside them. The rest of the chunk is right up to the first other
+            // special byte outside of them.
+            const uint64_t quote = m.quote & from;
+            const uint64_t inside = PrefixXor(quote) ^ (in_quote ? ~uint64_t(0) : 0);
+            const uint64_t special = m.special & from & ~inside;
+            const uint64_t before = special ? (special & -special) - 1 : ~uint64_t(0);
+            if (!stack.Apply(m, from & before & ~inside, sql, pos, reason, &error)) return error;
+            if (special == 0) {
+                in_quote = (inside >> (length - 1)) & 1;
+                if (in_quote && (quote & inside) != 0) quote_start = pos + 63 - __builtin_clzll(quote & inside);
+                pos += length;
+                if (in_quote) {
+                    // Long literals are skipped in bulk, continuing at the quote which ends them
+                    const void *end = memchr(sql.data() + pos, '\'', sql.size() - pos);
+                    pos = end == nullptr ? sql.size() : static_cast<const char *>(end) - sql.data();
+                }
+                break;
+            }
+            const size_t end = Skip(sql, pos + __builtin_ctzll(special), reason, &error);
+            if (end == std::string_view::npos) return error;
+            in_quote = false;
+            if (end - pos >= length) {
+                pos = end;
+                break;
+            }
+            from = ~uint64_t(0) << (end - pos);
+        }
+    }
+    if (in_quote) return Fail(reason, "unterminated string literal", quote_start);
+    return stack.Finish(reason);
+}
+
+}  // namespace
+
+Isa BestIsa() {
+#ifdef TENSILE_LEXER_X86
+    static const Isa isa = __builtin_cpu_supports("avx2") ? Isa::AVX2 : Isa::SSE2;
+    return isa;
+#else
+    return Isa::SCALAR;
+#endif
+}
+
+#ifdef TENSILE_LEXER_X86
+// Compiled for AVX2 as a whole, so that the classifier is inlined into the scan
+__attribute__((target("avx2"), flatten)) size_t ScanAvx2(std::string_view sql, std::string *reason) {
+    return Scan<ClassifyAvx2>(sql, reason);
+}
+#endif
+
+size_t FindUnbalanced(std::string_view sql, std::string *reason, Isa isa) {
+    switch (isa) {
+#ifdef TENSILE_LEXER_X86
+        case Isa::AVX2: return ScanAvx2(sql, reason);
+        case Isa::SSE2: return Scan<ClassifySse2>(sql, reason);
+#endif
+        default: return Scan<ClassifyScalar>(sql, reason);
+    }
+}
+
+}  // namespace lexer_internal
+
+size_t FindUnbalanced(std::string_view sql, std::string *reason) {
+    return lexer_internal::FindUnbalanced(sql, reason, lexer_internal::BestIsa());
+}
+
+}  // namespace tensile
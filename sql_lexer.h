@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace tensile {
+
+// Checks that (), [] and {} in @sql are balanced and properly nested, ignoring those inside
+// string literals, quoted identifiers, comments (including nested /* */) and dollar-quoted
+// strings. Returns the offset of the first byte which breaks the balance: a closing bracket
+// without a matching opening one, the earliest opening bracket left unclosed, or the start of
+// an unterminated literal or comment. Returns std::string_view::npos if @sql is balanced, and
+// otherwise says why in @reason unless it is null.
+//
+// Input is classified 64 bytes at a time into bitmasks with SSE2 or AVX2 where available, and
+// brackets of a single kind are counted with popcount, so deeply nested multi-megabyte
+// statements are checked at close to memory bandwidth.
+size_t FindUnbalanced(std::string_view sql, std::string *reason = nullptr);
+
+namespace lexer_internal {
+
+enum class Isa { SCALAR, SSE2, AVX2 };
+
+// Best instruction set FindUnbalanced can use on this CPU.
+Isa BestIsa();
+
+// FindUnbalanced using @isa, which must be supported by the CPU.
+size_t FindUnbalanced(std::string_view sql, std::string *reason, Isa isa);
+
+}  // namespace lexer_internal
+
+}  // namespace tensile
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+#include <random>
+#include "sql_lexer.h"
+
+namespace tensile {
+namespace {
+
+using lexer_internal::Isa;
+
+constexpr size_t kBalanced = std::string_view::npos;
+
+std::vector<Isa> SupportedIsas() {
+    std::vector<Isa> isas = {Isa::SCALAR};
+    if (lexer_internal::BestIsa() != Isa::SCALAR) isas.push_back(Isa::SSE2);
+    if (lexer_internal::BestIsa() == Isa::AVX2) isas.push_back(Isa::AVX2);
+    return isas;
+}
+
+// Bracket balance of a string without literals, the obvious way.
+size_t ReferenceUnbalanced(const std::string &sql) {
+    const std::string open = "([{", close = ")]}";
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < sql.size(); i++) {
+        if (open.find(sql[i]) != std::string::npos) {
+            stack.push_back(i);
+        } else if (size_t k = close.find(sql[i]); k != std::string::npos) {
+            if (stack.empty() || sql[stack.back()] != open[k]) return i;
+            stack.pop_back();
+        }
+    }
+    return stack.empty() ? kBalanced : stack.front();
+}
+
+TEST(SqlLexer, Brackets) {
+    std::string reason;
+    EXPECT_EQ(kBalanced, FindUnbalanced("select array [(1)], {'x':(2)}", &reason));
+    EXPECT_EQ(10, FindUnbalanced("select (1))", &reason));
+    EXPECT_EQ("unmatched ')'", reason);
+    EXPECT_EQ(9, FindUnbalanced("select [1)]", &reason));
+    EXPECT_EQ("'[' closed by ')'", reason);
+    // The earliest bracket left open is reported
+    EXPECT_EQ(7, FindUnbalanced("select ((1) + (2)", &reason));
+    EXPECT_EQ("unmatched '('", reason);
+}
+
+TEST(SqlLexer, LiteralsAndComments) {
+    std::string reason;
+    EXPECT_EQ(kBalanced, FindUnbalanced("select '(', 'it''s )', \"a)\" -- (\n, 1", &reason)) << reason;
+    EXPECT_EQ(kBalanced, FindUnbalanced("select /* ( /* ) */ ] */ 1 -- (", &reason)) << reason;
+    EXPECT_EQ(kBalanced, FindUnbalanced("select $$)$$, $tag$ $$ ( $tag$, a$b (1), $1", &reason)) << reason;
+    EXPECT_EQ(kBalanced, FindUnbalanced("select cast('{\"a\":{\"a\":1}' as json)", &reason)) << reason;
+    EXPECT_EQ(7, FindUnbalanced("select 'abc", &reason));
+    EXPECT_EQ("unterminated string literal", reason);
+    EXPECT_EQ(7, FindUnbalanced("select /* /* */ 1", &reason));
+    EXPECT_EQ("unterminated comment", reason);
+    EXPECT_EQ(7, FindUnbalanced("select $q$ 1 $$", &reason));
+    EXPECT_EQ("unterminated dollar-quoted string", reason);
+}
+
+TEST(SqlLexer, DeepNesting) {
+    const size_t depth = 100000;
+    std::string sql = "select " + std::string(depth, '(') + "1" + std::string(depth, ')');
+    for (Isa isa : SupportedIsas()) {
+        std::string reason;
+        EXPECT_EQ(kBalanced, lexer_internal::FindUnbalanced(sql, &reason, isa));
+        EXPECT_EQ(sql.size(), lexer_internal::FindUnbalanced(sql + ")", &reason, isa));
+        EXPECT_EQ(7, lexer_internal::FindUnbalanced("select (" + sql.substr(7), &reason, isa));
+    }
+}
+
+TEST(SqlLexer, ExactChunksNotNullTerminated) {
+    // Buffers of whole chunks are not padded, so nothing past the end may be read. A heap
+    // buffer of exactly the size followed by a '-' catches it without a sanitizer, too.
+    for (size_t chunks = 1; chunks <= 3; chunks++) {
+        const size_t size = 64 * chunks;
+        std::unique_ptr<char[]> buffer(new char[size + 1]);
+        memset(buffer.get(), 'a', size);
+        buffer[size - 1] = '-';
+        buffer[size] = '-';
+        const std::string_view sql(buffer.get(), size);
+        for (Isa isa : SupportedIsas()) {
+            std::string reason;
+            EXPECT_EQ(kBalanced, lexer_internal::FindUnbalanced(sql, &reason, isa)) << reason;
+            buffer[size - 2] = '/';
+            buffer[size - 1] = '*';
+            EXPECT_EQ(size - 2, lexer_internal::FindUnbalanced(sql, &reason, isa));
+            EXPECT_EQ("unterminated comment", reason);
+            buffer[size - 2] = 'a';
+            buffer[size - 1] = '-';
+        }
+        std::unique_ptr<char[]> exact(new char[size]);
+        memcpy(exact.get(), buffer.get(), size);
+        for (Isa isa : SupportedIsas()) {
+            EXPECT_EQ(kBalanced, lexer_internal::FindUnbalanced(std::string_view(exact.get(), size), nullptr, isa));
+        }
+    }
+}
+
+TEST(SqlLexer, MatchesReference) {
+    std::mt19937 random(42);
+    for (int iteration = 0; iteration < 2000; iteration++) {
+        // Mostly balanced strings of a few kinds of brackets, long enough to span chunks, with
+        // an occasional stray closing bracket
+        std::string sql;
+        std::vector<char> open;
+        const std::string alphabet = iteration % 2 ? "(([[{x]" : "((((x)";
+        const size_t length = random() % 300;
+        while (sql.size() < length) {
+            const char c = alphabet[random() % alphabet.size()];
+            if (c == 'x' && !open.empty() && random() % 8 != 0) {
+                sql += open.back() == '(' ? ')' : open.back() == '[' ? ']' : '}';
+                open.pop_back();
+            } else {
+                sql += c;
+                if (c == '(' || c == '[' || c == '{') open.push_back(c);
+            }
+        }
+        if (random() % 2) {
+            for (; !open.empty(); open.pop_back()) sql += open.back() == '(' ? ')' : open.back() == '[' ? ']' : '}';
+        }
+        SCOPED_TRACE(sql);
+        for (Isa isa : SupportedIsas()) {
+            EXPECT_EQ(ReferenceUnbalanced(sql), lexer_internal::FindUnbalanced(sql, nullptr, isa));
+        }
+    }
+}
+
+TEST(SqlLexer, IsasAgree) {
+    std::mt19937 random(7);
+    const std::string alphabet = "()[]{}'\"-/*$a \n";
+    for (int iteration = 0; iteration < 5000; iteration++) {
+        std::string sql(random() % 200, ' ');
+        for (char &c : sql) c = alphabet[random() % alphabet.size()];
+        SCOPED_TRACE(sql);
+        std::string expected_reason;
+        const size_t expected = lexer_internal::FindUnbalanced(sql, &expected_reason, Isa::SCALAR);
+        for (Isa isa : SupportedIsas()) {
+            std::string reason;
+            EXPECT_EQ(expected, lexer_internal::FindUnbalanced(sql, &reason, isa));
+            EXPECT_EQ(expected_reason, reason);
+        }
+    }
+}
+
+}  // namespace
+}  // namespace tensile
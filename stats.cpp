@@ -0,0 +1,113 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace tensile {
+
+namespace {
+
+// Continued fraction of the regularized incomplete beta function, evaluated by the modified
+// Lentz method
+double BetaContinuedFraction(double a, double b, double x) {
+    constexpr int kMaxIterations = 300;
+    constexpr double kEpsilon = 1e-15;
+    constexpr double kTiny = 1e-300;
+    double c = 1;
+    double d = 1 - (a + b) * x / (a + 1);
+    if (std::abs(d) < kTiny) d = kTiny;
+    d = 1 / d;
+    double fraction = d;
+    for (int m = 1; m <= kMaxIterations; m++) {
+        // Even and odd steps of the fraction
+        for (int odd = 0; odd < 2; odd++) {
+            const double numerator = odd ? -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1))
+                                         : m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+            d = 1 + numerator * d;
+            if (std::abs(d) < kTiny) d = kTiny;
+            c = 1 + numerator / c;
+            if (std::abs(c) < kTiny) c = kTiny;
+            d = 1 / d;
+            fraction *= d * c;
+            if (odd && std::abs(d * c - 1) < kEpsilon) return fraction;
+        }
+    }
+    return fraction;
+}
+
+// Regularized incomplete beta function I_x(a, b)
+double RegularizedBeta(double a, double b, double x) {
+    if (x <= 0) return 0;
+    if (x >= 1) return 1;
+    const double front =
+            std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log1p(-x));
+    // The fraction converges quickly on this side of the mean
+    if (x < (a + 1) / (a + b + 2)) return front * BetaContinuedFraction(a, b, x) / a;
+    return 1 - front * BetaContinuedFraction(b, a, 1 - x) / b;
+}
+
+}  // namespace
+
+double StudentTCdf(double t, double dof) {
+    if (std::isinf(t)) return t > 0 ? 1 : 0;
+    const double tail = 0.5 * RegularizedBeta(dof / 2, 0.5, dof / (dof + t * t));
+    return t > 0 ? 1 - tail : tail;
+}
+
+double StudentTQuantile(double p, double dof) {
+    // Bisection, since the CDF is monotonic and only called a few times per comparison
+    double low = -1e6;
+    double high = 1e6;
+    for (int k = 0; k < 200 && high - low > 1e-12; k++) {
+        const double middle = (low + high) / 2;
+        if (StudentTCdf(middle, dof) < p) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return (low + high) / 2;
+}
+
+double Median(std::vector<double> values) {
+    if (values.empty()) return 0;
+    const size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    if (values.size() % 2 == 1) return values[middle];
+    return (values[middle] + *std::max_element(values.begin(), values.begin() + middle)) / 2;
+}
+
+PairedComparison ComparePaired(const std::vector<double> &first, const std::vector<double> &second,
+                               double confidence) {
+    std::vector<double> log_ratios;
+    for (size_t i = 0; i < std::min(first.size(), second.size()); i++) {
+        if (first[i] > 0 && second[i] > 0) log_ratios.push_back(std::log(second[i] / first[i]));
+    }
+    PairedComparison comparison;
+    comparison.pairs = log_ratios.size();
+    if (log_ratios.empty()) return comparison;
+    double mean = 0;
+    for (double r : log_ratios) mean += r;
+    mean /= log_ratios.size();
+    comparison.change = comparison.change_low = comparison.change_high = std::expm1(mean);
+    if (log_ratios.size() < 2) return comparison;
+
+    double variance = 0;
+    for (double r : log_ratios) variance += (r - mean) * (r - mean);
+    variance /= log_ratios.size() - 1;
+    const double standard_error = std::sqrt(variance / log_ratios.size());
+    const double dof = log_ratios.size() - 1;
+    if (standard_error == 0) {
+        comparison.p_value = mean == 0 ? 1 : 0;
+        return comparison;
+    }
+    const double t = mean / standard_error;
+    comparison.p_value = 2 * StudentTCdf(-std::abs(t), dof);
+    const double margin = StudentTQuantile(0.5 + confidence / 2, dof) * standard_error;
+    comparison.change_low = std::expm1(mean - margin);
+    comparison.change_high = std::expm1(mean + margin);
+    return comparison;
+}
+
+}  // namespace tensile
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace tensile {
+
+// Comparison of two samples measured in pairs, e.g. the latencies of two providers running the
+// same statement one after the other
+struct PairedComparison {
+    // Pairs compared
+    size_t pairs = 0;
+    // Relative change of the second sample over the first, the geometric mean of their ratios
+    // minus 1, e.g. 0.05 for 5% more
+    double change = 0;
+    // Confidence interval of @change
+    double change_low = 0;
+    double change_high = 0;
+    // Two-sided p-value of a paired t-test of no change
+    double p_value = 1;
+
+    // Whether the change is significant at level @alpha
+    bool significant(double alpha = 0.05) const { return pairs > 1 && p_value < alpha; }
+};
+
+// Compares @second to @first, paired by index, on the logarithms of their ratios, which makes
+// changes relative and tames the long tail of latencies. Pairs with a value which is not positive
+// are left out. The confidence interval is at level @confidence.
+PairedComparison ComparePaired(const std::vector<double> &first, const std::vector<double> &second,
+                               double confidence = 0.95);
+
+// Cumulative distribution function of Student's t distribution with @dof degrees of freedom
+double StudentTCdf(double t, double dof);
+
+// Inverse of StudentTCdf, for @p in (0, 1)
+double StudentTQuantile(double p, double dof);
+
+// Median of @values, 0 if there are none
+double Median(std::vector<double> values);
+
+}  // namespace tensile
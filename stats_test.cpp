@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "stats.h"
+
+#include <cmath>
+
+namespace tensile {
+namespace {
+
+TEST(Stats, StudentT) {
+    EXPECT_NEAR(0.5, StudentTCdf(0, 5), 1e-12);
+    // Cauchy distribution
+    EXPECT_NEAR(0.75, StudentTCdf(1, 1), 1e-9);
+    EXPECT_NEAR(0.975, StudentTCdf(2.228139, 10), 1e-6);
+    EXPECT_NEAR(0.025, StudentTCdf(-2.228139, 10), 1e-6);
+    EXPECT_NEAR(0.995, StudentTCdf(2.575829, 1e6), 1e-5);
+    EXPECT_NEAR(2.228139, StudentTQuantile(0.975, 10), 1e-5);
+    EXPECT_NEAR(-12.7062, StudentTQuantile(0.025, 1), 1e-3);
+}
+
+TEST(Stats, Median) {
+    EXPECT_EQ(0, Median({}));
+    EXPECT_EQ(2, Median({3, 1, 2}));
+    EXPECT_EQ(2.5, Median({4, 1, 3, 2}));
+}
+
+TEST(Stats, ComparePaired) {
+    // Second is 5% slower, with noise shared by both sides of each pair cancelling out
+    std::vector<double> first, second;
+    for (int k = 0; k < 20; k++) {
+        const double drift = 1000 * (1 + 0.3 * std::sin(k));
+        first.push_back(drift);
+        second.push_back(drift * (k % 2 ? 1.06 : 1.04));
+    }
+    PairedComparison comparison = ComparePaired(first, second);
+    EXPECT_EQ(20, comparison.pairs);
+    EXPECT_NEAR(0.05, comparison.change, 0.001);
+    EXPECT_LT(comparison.change_low, 0.05);
+    EXPECT_GT(comparison.change_high, 0.05);
+    EXPECT_GT(comparison.change_low, 0.04);
+    EXPECT_TRUE(comparison.significant());
+    EXPECT_LT(comparison.p_value, 1e-10);
+
+    // Changes both ways average out
+    comparison = ComparePaired({100, 100, 100, 100}, {110, 100 / 1.1, 105, 100 / 1.05});
+    EXPECT_NEAR(0, comparison.change, 1e-12);
+    EXPECT_NEAR(1, comparison.p_value, 1e-9);
+    EXPECT_FALSE(comparison.significant());
+    EXPECT_LT(comparison.change_low, 0);
+    EXPECT_GT(comparison.change_high, 0);
+
+    // Pairs which are not positive are left out, and one pair has no spread to test
+    comparison = ComparePaired({0, 100, 100}, {100, -1, 120});
+    EXPECT_EQ(1, comparison.pairs);
+    EXPECT_NEAR(0.2, comparison.change, 1e-12);
+    EXPECT_FALSE(comparison.significant());
+}
+
+}  // namespace
+}  // namespace tensile
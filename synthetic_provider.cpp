@@ -0,0 +1,145 @@
+#include "synthetic_provider.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace tensile {
+
+namespace {
+// Latencies are capped, so that exponential growth never overflows
+constexpr double kMaxLatencyUs = 3600e6;
+// Bound of Model::Limit for models which never fail
+constexpr size_t kMaxBytes = size_t(1) << 40;
+}  // namespace
+
+std::chrono::microseconds SyntheticProvider::Model::Latency(size_t bytes) const {
+    const double size = static_cast<double>(bytes);
+    double us = unit_us;
+    switch (growth) {
+        case Growth::CONSTANT:
+            break;
+        case Growth::LINEAR:
+            us *= size;
+            break;
+        case Growth::QUADRATIC:
+            us *= size * size;
+            break;
+        case Growth::EXPONENTIAL:
+            us *= std::exp2(std::min(size / doubling_bytes, 64.0));
+            break;
+    }
+    return std::chrono::microseconds(static_cast<int64_t>(std::min(us, kMaxLatencyUs)));
+}
+
+size_t SyntheticProvider::Model::Limit(std::chrono::milliseconds timeout) const {
+    // Smallest size which fails regardless of time
+    size_t first_failure = kMaxBytes;
+    auto fail_from = [&](size_t bytes) {
+        if (bytes > 0) first_failure = std::min(first_failure, bytes);
+    };
+    fail_from(fail_at);
+    fail_from(crash_at);
+    for (const auto &[begin, end] : fail_windows) {
+        if (begin < end) fail_from(begin);
+    }
+    if (memory_per_byte > 0 && memory_limit > 0) fail_from(memory_limit / memory_per_byte + 1);
+    if (statement_timeout.count() > 0) timeout = std::min(timeout, statement_timeout);
+
+    // Latency grows with the size, so the largest size within @timeout is bisected
+    size_t lo = 0, hi = first_failure;
+    while (hi - lo > 1) {
+        const size_t bytes = lo + (hi - lo) / 2;
+        (Latency(bytes) <= timeout ? lo : hi) = bytes;
+    }
+    return lo;
+}
+
+bool SyntheticProvider::Run(std::string_view sql, std::string *error_msg) {
+    const size_t bytes = sql.size();
+    if (model_.crash_at > 0 && bytes >= model_.crash_at) {
+        std::abort();
+    }
+    bool fail = model_.fail_at > 0 && bytes >= model_.fail_at;
+    for (const auto &[begin, end] : model_.fail_windows) {
+        fail = fail || (begin <= bytes && bytes < end);
+    }
+    if (fail) {
+        *error_msg = "synthetic failure at " + std::to_string(bytes) + " bytes";
+        return false;
+    }
+    if (model_.memory_per_byte > 0 && bytes > 0) {
+        const size_t memory = bytes * model_.memory_per_byte;
+        if (model_.memory_limit > 0 && memory > model_.memory_limit) {
+            *error_msg = "out of memory allocating " + std::to_string(memory) + " bytes";
+            return false;
+        }
+        auto buffer = std::make_unique<char[]>(memory);
+        std::memset(buffer.get(), 1, memory);
+        volatile char sink = buffer[memory - 1];
+        (void)sink;
+    }
+    auto latency = model_.Latency(bytes);
+    if (model_.noise > 0) {
+        // Seeded from the clock, since forked checkers would all share the state of one generator
+        std::mt19937_64 random(std::chrono::steady_clock::now().time_since_epoch().count());
+        const double factor = 1 + model_.noise * std::normal_distribution<double>()(random);
+        latency = std::chrono::microseconds(static_cast<int64_t>(std::max(0.0, factor) * latency.count()));
+    }
+    if (model_.statement_timeout.count() > 0 && latency > model_.statement_timeout) {
+        std::this_thread::sleep_for(model_.statement_timeout);
+        *error_msg = "cancelled after " + std::to_string(model_.statement_timeout.count()) + "ms";
+        return false;
+    }
+    std::this_thread::sleep_for(latency);
+    return true;
+}
+
+std::vector<std::unique_ptr<SyntheticProvider>> GetSyntheticProviders() {
+    using Growth = SyntheticProvider::Model::Growth;
+    std::vector<std::unique_ptr<SyntheticProvider>> providers;
+    auto add = [&](std::string name, SyntheticProvider::Model model) {
+        providers.push_back(std::make_unique<SyntheticProvider>(std::move(name), std::move(model)));
+    };
+    SyntheticProvider::Model defaults;
+    defaults.statement_timeout = std::chrono::milliseconds(200);
+
+    SyntheticProvider::Model model = defaults;
+    model.growth = Growth::LINEAR;
+    model.unit_us = 1;
+    add("linear", model);
+
+    model.growth = Growth::QUADRATIC;
+    model.unit_us = 1e-4;
+    add("quadratic", model);
+
+    model.growth = Growth::EXPONENTIAL;
+    model.unit_us = 1;
+    model.doubling_bytes = 1024;
+    add("exponential", model);
+
+    model = defaults;
+    model.noise = 0.2;
+    add("noisy", model);
+
+    model = defaults;
+    model.growth = Growth::CONSTANT;
+    model.fail_windows = {{3000, 3100}};
+    model.fail_at = 50000;
+    add("window", model);
+
+    model = defaults;
+    model.growth = Growth::CONSTANT;
+    model.memory_per_byte = 4;
+    model.memory_limit = 16 << 20;
+    add("memory", model);
+
+    model = defaults;
+    model.crash_at = 5000;
+    add("crash", model);
+    return providers;
+}
+
+}  // namespace tensile
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "tensile.h"
+
+namespace tensile {
+
+// Provider which runs no SQL at all, but follows a cost model of the statement size in bytes: its
+// latency grows with the size, and it fails, crashes or runs out of memory past given sizes. The
+// limit the driver should find is known from the model (see Model::Limit), so synthetic providers
+// measure how many probes and how much time search strategies take, and how accurate they are.
+class SyntheticProvider : public ISQLProvider {
+public:
+    struct Model {
+        enum class Growth {
+            CONSTANT,
+            LINEAR,
+            QUADRATIC,
+            // Doubles every @doubling_bytes
+            EXPONENTIAL,
+        };
+
+        Growth growth = Growth::LINEAR;
+        // Latency of a statement of one byte, in microseconds
+        double unit_us = 1;
+        double doubling_bytes = 1024;
+        // Standard deviation of the latency relative to its mean. Noise is random for every
+        // statement, even in forked checkers.
+        double noise = 0;
+        // Statements of at least this many bytes fail with an ERROR, unless 0
+        size_t fail_at = 0;
+        // Sizes in [first, second) which fail although larger statements can succeed
+        std::vector<std::pair<size_t, size_t>> fail_windows;
+        // Bytes allocated and touched for every byte of the statement
+        size_t memory_per_byte = 0;
+        // Allocation beyond which statements fail as out of memory, unless 0
+        size_t memory_limit = 0;
+        // Statements of at least this many bytes abort the process, unless 0
+        size_t crash_at = 0;
+        // Statements which would take longer fail with an ERROR after this long, like an engine
+        // cancelling them, unless 0. Bounds the statements checked in process, which are not killed.
+        std::chrono::milliseconds statement_timeout{0};
+
+        // Mean latency of a statement of @bytes
+        std::chrono::microseconds Latency(size_t bytes) const;
+
+        // Largest statement which succeeds within @timeout, like all smaller ones, without noise
+        size_t Limit(std::chrono::milliseconds timeout) const;
+    };
+
+    SyntheticProvider(std::string name, Model model) : name_(std::move(name)), model_(std::move(model)) {}
+
+    std::string name() const override { return name_; }
+
+    // Sleeps for the modelled latency of @sql, after failing or crashing as modelled.
+    bool Run(std::string_view sql, std::string *error_msg) override;
+
+    const Model &model() const { return model_; }
+
+private:
+    std::string name_;
+    Model model_;
+};
+
+// Providers with one model each of latency growth and failure, whose limits are in the thousands to
+// millions of bytes with timeouts of 10 to 100ms. Statements are cancelled after 200ms:
+//     linear, quadratic, exponential - timeouts only
+//     noisy                          - linear with 20% noise
+//     window                         - fails below its limit on a narrow window of sizes
+//     memory                         - runs out of memory
+//     crash                          - aborts, so it needs fork-based checking
+std::vector<std::unique_ptr<SyntheticProvider>> GetSyntheticProviders();
+
+}  // namespace tensile
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "synthetic_provider.h"
+
+#include <map>
+
+namespace tensile {
+namespace {
+
+// SQL of @n bytes, so that the limit found is the limit of the model
+class LengthFeature : public ISQLFeature {
+public:
+    std::string name() override { return "length"; }
+    std::string_view GenerateSQL(size_t n) override {
+        sql_.assign(n, 'x');
+        return sql_;
+    }
+
+private:
+    std::string sql_;
+};
+
+std::map<std::string, std::unique_ptr<SyntheticProvider>> Providers() {
+    std::map<std::string, std::unique_ptr<SyntheticProvider>> providers;
+    for (auto &provider : GetSyntheticProviders()) providers[provider->name()] = std::move(provider);
+    return providers;
+}
+
+TEST(SyntheticProvider, Limits) {
+    auto providers = Providers();
+    const std::chrono::milliseconds timeout(20);
+    EXPECT_EQ(20000, providers["linear"]->model().Limit(timeout));
+    EXPECT_EQ(14142, providers["quadratic"]->model().Limit(timeout));
+    EXPECT_EQ(14630, providers["exponential"]->model().Limit(timeout));
+    EXPECT_EQ(2999, providers["window"]->model().Limit(timeout));
+    EXPECT_EQ(4 << 20, providers["memory"]->model().Limit(timeout));
+    EXPECT_EQ(4999, providers["crash"]->model().Limit(timeout));
+    EXPECT_EQ(0, providers["linear"]->model().Limit(std::chrono::milliseconds(0)));
+}
+
+TEST(SyntheticProvider, Run) {
+    auto providers = Providers();
+    std::string error;
+    EXPECT_TRUE(providers["window"]->Run(std::string(2999, 'x'), &error));
+    EXPECT_FALSE(providers["window"]->Run(std::string(3000, 'x'), &error));
+    EXPECT_EQ("synthetic failure at 3000 bytes", error);
+    EXPECT_TRUE(providers["window"]->Run(std::string(3100, 'x'), &error));
+    EXPECT_FALSE(providers["memory"]->Run(std::string((4 << 20) + 1, 'x'), &error));
+    EXPECT_EQ("out of memory allocating 16777220 bytes", error);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(providers["linear"]->Run(std::string(5000, 'x'), &error));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+}
+
+TEST(SyntheticProvider, Driver) {
+    auto providers = Providers();
+    LengthFeature feature;
+    Driver driver;
+    driver.set_timeout(std::chrono::milliseconds(20));
+    driver.set_explore_beyond_first_failure(false);
+    // Overhead of checking statements only brings the limit found down
+    auto results = driver.Run(providers["linear"].get(), &feature);
+    ASSERT_EQ(1, results.size());
+    EXPECT_LE(results[0].limit, 20000);
+    EXPECT_GE(results[0].limit, 15000);
+    EXPECT_EQ(Status::TIMEOUT, results[0].status.code());
+
+    // Doubling steps over the failure window, and bisection finds the failure beyond
+    results = driver.Run(providers["window"].get(), &feature);
+    EXPECT_EQ(49999, results[0].limit);
+
+    results = driver.Run(providers["crash"].get(), &feature);
+    EXPECT_EQ(4999, results[0].limit);
+    EXPECT_EQ(Status::CRASH, results[0].status.code());
+}
+
+}  // namespace
+}  // namespace tensile
@@ -1,11 +1,32 @@
 #include "tensile.h"
+#include "composition.h"
+#include "corpus.h"
+#include "probe_log.h"
+#include "reference_parser.h"
+#include "results_writer.h"
+#include "timeline.h"
+#include "trace_ring.h"
 
 #include "argh/argh.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
 #include <sys/wait.h>
 #include <thread>
 #include <unistd.h>
 #include <signal.h>
+#include <time.h>
 
 namespace tensile {
 
@@ -16,30 +37,354 @@ namespace {
 // where doubling @n past a small first-failure can reach 1e9+.
 constexpr size_t kMaxN = 10'000'000;
 constexpr size_t kMaxSqlBytes = 16ull * 1024 * 1024;  // 16 MiB
+
+// Consecutive probes a replay thread takes at a time, to check them in as few batches as it can
+constexpr size_t kReplayBatch = 16;
+
+// Statements a feature generated for a batch are copied out of its buffer before it generates
+// the next one only up to this size. A larger one ends the batch instead and runs from the buffer:
+// it costs more to copy than batching saves.
+constexpr size_t kMaxCopiedSqlBytes = 64 * 1024;
+
+// A forked batch is killed after at most this many timeouts, rather than one per statement, so
+// that a hung statement delays checking the batch one by one only that long. Batches which are
+// merely slow in total get checked one by one as well.
+constexpr size_t kBatchWatchdogTimeouts = 2;
+
+// SQL of a batch being collected, as views into the buffers of the features which generated it.
+// A view is replaced by a copy only when its feature is about to generate again.
+class BatchSql {
+public:
+    // Adds @sql, which @feature keeps until it generates again.
+    void Add(const void *feature, std::string_view sql) {
+        live_[feature] = views_.size();
+        views_.push_back(sql);
+    }
+
+    // Size of the statement of the batch still in the buffer of @feature, 0 if none.
+    size_t live_bytes(const void *feature) const {
+        auto it = live_.find(feature);
+        return it == live_.end() ? 0 : views_[it->second].size();
+    }
+
+    // Copies the statement still in the buffer of @feature, which is about to generate again.
+    void Detach(const void *feature) {
+        auto it = live_.find(feature);
+        if (it == live_.end()) return;
+        // Elements of a deque stay in place as it grows, so views of earlier copies remain valid
+        views_[it->second] = copies_.emplace_back(views_[it->second]);
+        live_.erase(it);
+    }
+
+    const std::vector<std::string_view> &views() const { return views_; }
+
+    void Clear() {
+        views_.clear();
+        copies_.clear();
+        live_.clear();
+    }
+
+private:
+    std::vector<std::string_view> views_;
+    std::deque<std::string> copies_;
+    // Index of the view each feature still holds
+    std::map<const void *, size_t> live_;
+};
+
+// Sizes of a multi-dimensional feature as in "3x4"
+std::string JoinDims(const std::vector<size_t> &dims) {
+    std::string text;
+    for (size_t k = 0; k < dims.size(); k++) {
+        text += (k ? "x" : "") + std::to_string(dims[k]);
+    }
+    return text;
+}
+
+// Bound on failure messages sent by checker processes
+constexpr size_t kMaxErrorMsgBytes = 4096;
+// Latency as sent by checker processes, a count of microseconds
+using LatencyCount = std::chrono::microseconds::rep;
+
+void WriteAll(int fd, const std::string &data) {
+    if (fd < 0) return;
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t w = write(fd, data.data() + off, data.size() - off);
+        if (w <= 0) break;
+        off += static_cast<size_t>(w);
+    }
+}
+
+// Fork-based isolation: fork into checker + timeout-watcher children.
+// The checker runs @check, which may write to the file descriptor it gets;
+// the timeout-watcher kills the checker if it exceeds @timeout. Returns the
+// code @check returns, CRASH if the checker ends abnormally and TIMEOUT if it
+// is killed. Sets @output to everything the checker wrote.
+Status::Code RunIsolated(const std::function<Status::Code(int)> &check, std::chrono::milliseconds timeout,
+                         std::string *output) {
+    int msg_pipe[2];
+    // Close-on-exec, so that processes the provider spawns cannot keep it open
+    if (pipe2(msg_pipe, O_CLOEXEC) != 0) {
+        msg_pipe[0] = msg_pipe[1] = -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (msg_pipe[0] >= 0) close(msg_pipe[0]);  // no one below this point reads
+        pid_t checker_pid = fork();
+        if (checker_pid == 0) {
+            // Silence stderr, since some code writes there in case of errors.
+            // TODO(moshap): Ideally we should detect whether provider code wrote to stderr and report it as a problem,
+            // especially when provider is a library
+            FILE *f = freopen("/dev/null", "w", stderr);
+            clearerr(f);
+
+            const Status::Code code = check(msg_pipe[1]);
+            if (msg_pipe[1] >= 0) close(msg_pipe[1]);
+            // Use _exit so we don't run static/global destructors inherited
+            // from the parent — those could e.g. send SIGTERM to the shared
+            // firebolt-core process when FireboltCoreWrapper goes out of scope.
+            _exit(code);
+        }
+
+        pid_t timeout_pid = fork();
+        if (timeout_pid == 0) {
+            if (msg_pipe[1] >= 0) close(msg_pipe[1]);  // timeout-watcher never writes
+            std::this_thread::sleep_for(timeout);
+            _exit(0);
+        }
+        // Only the checker holds the write-end, so the parent's read sees EOF
+        // once the checker exits.
+        if (msg_pipe[1] >= 0) close(msg_pipe[1]);
+
+        Status status;
+        int exit_code;
+        pid_t exited_pid = wait(&exit_code);
+        if (exited_pid == checker_pid) {
+            // If checked process finished first, kill timeout process
+            kill(timeout_pid, SIGKILL);
+            // If checker process finished normally, propagate its exit code
+            if (WIFEXITED(exit_code)) {
+                status = Status(WEXITSTATUS(exit_code));
+            } else {
+                // If checker processed finished abnormally, it indicates crash
+                status = Status(Status::CRASH);
+            }
+        } else {
+            // If timeout process finished first, kill checker process
+            kill(checker_pid, SIGKILL);
+            status = Status(Status::TIMEOUT);
+        }
+        // Wait for the other (killed) process to finish
+        wait(nullptr);
+        _exit(status.code());
+    }
+    if (msg_pipe[1] >= 0) close(msg_pipe[1]);  // parent never writes
+    output->clear();
+    if (msg_pipe[0] >= 0) {
+        // Drain the pipe before waiting, so that a checker writing more than the pipe buffer
+        // never blocks. All write-ends are closed once the checker is gone, so this hits EOF.
+        char buf[4096];
+        ssize_t r;
+        while ((r = read(msg_pipe[0], buf, sizeof(buf))) > 0) {
+            output->append(buf, static_cast<size_t>(r));
+        }
+        close(msg_pipe[0]);
+    }
+    // Wait for the intermediary process to finish and propagate its exit code
+    int exit_code;
+    waitpid(pid, &exit_code, 0);
+    return WIFEXITED(exit_code) ? Status::Code(WEXITSTATUS(exit_code)) : Status::CRASH;
+}
+
+// CPU time of the calling thread
+std::chrono::microseconds ThreadCpuTime() {
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::seconds(time.tv_sec) +
+                                                                 std::chrono::nanoseconds(time.tv_nsec));
+}
+
+// Events of a trace ring, which the driver drains after every statement, so that it only fills
+// up with the statements of a large batch or with many replay threads
+constexpr size_t kTraceRingCapacity = 4096;
+
+// Sizes in timeline counters
+double Mebibytes(size_t bytes) { return static_cast<double>(bytes) / (1 << 20); }
+
+// Prints a perftrace line of @time in milliseconds with nanosecond digits
+void PrintTraceLine(const ISQLProvider &provider, const std::string &trace, std::chrono::nanoseconds time, bool ok,
+                    Phase phase) {
+    char milliseconds[32];
+    std::snprintf(milliseconds, sizeof(milliseconds), "%.6f", time.count() / 1e6);
+    std::cout << provider.name() << "," << trace << "," << milliseconds << "," << (ok ? "OK" : "ERROR") << ","
+              << PhaseName(phase) << std::endl;
+}
+
+// Time a statement took out of @elapsed, which includes @session_time
+std::chrono::microseconds StatementTime(std::chrono::nanoseconds elapsed, std::chrono::microseconds session_time) {
+    const auto statement = std::chrono::duration_cast<std::chrono::microseconds>(elapsed) - session_time;
+    return std::max(statement, std::chrono::microseconds(0));
+}
+
+// Providers registered with RegisterSQLProvider, until a driver takes them
+std::vector<std::unique_ptr<ISQLProvider>> &RegisteredProviders() {
+    static std::vector<std::unique_ptr<ISQLProvider>> providers;
+    return providers;
+}
 }  // namespace
 
+void RegisterSQLProvider(std::unique_ptr<ISQLProvider> provider) {
+    RegisteredProviders().emplace_back(std::move(provider));
+}
+
+void ISQLProvider::RunBatch(const std::vector<std::string_view> &sqls, std::vector<Status> *statuses,
+                            std::vector<std::chrono::microseconds> *latencies) {
+    statuses->assign(sqls.size(), Status());
+    latencies->assign(sqls.size(), std::chrono::microseconds(0));
+    for (size_t i = 0; i < sqls.size(); i++) {
+        std::string error_msg;
+        auto start = std::chrono::high_resolution_clock::now();
+        const bool ok = Run(sqls[i], &error_msg);
+        const auto finish = std::chrono::high_resolution_clock::now();
+        (*latencies)[i] = std::chrono::duration_cast<std::chrono::microseconds>(finish - start);
+        if (!ok) (*statuses)[i] = Status(Status::ERROR, std::move(error_msg));
+    }
+}
+
+bool ISQLProvider::RunPhased(std::string_view sql, Phase stop_after, PhaseTimes *times, std::string *error_msg) {
+    times->Start(Phase::EXECUTE);
+    const bool ok = Run(sql, error_msg);
+    times->Stop();
+    return ok;
+}
+
+void IAsyncSQLProvider::RunAll(const std::vector<std::string_view> &sqls, std::chrono::milliseconds timeout,
+                               std::vector<Status> *statuses, std::vector<std::chrono::microseconds> *latencies) {
+    // Poll returns once statements complete, so this only bounds a wait with nothing due
+    constexpr std::chrono::milliseconds kPollInterval(10);
+    // Time a provider gets past a deadline to report the cancelled statement before RunAll gives
+    // up on it
+    constexpr std::chrono::milliseconds kDeadlineGrace(100);
+    // Outcomes are shared with the callbacks, which the provider may still call after RunAll
+    // returns, and only the first call for a statement counts
+    struct Outcomes {
+        std::vector<Status> statuses;
+        std::vector<std::chrono::microseconds> latencies;
+        std::vector<bool> done;
+        size_t completed = 0;
+    };
+    auto outcomes = std::make_shared<Outcomes>();
+    outcomes->statuses.assign(sqls.size(), Status());
+    outcomes->latencies.assign(sqls.size(), std::chrono::microseconds(0));
+    outcomes->done.assign(sqls.size(), false);
+    std::vector<Clock::time_point> starts(sqls.size()), deadlines(sqls.size());
+    const size_t max_in_flight = std::max<size_t>(1, this->max_in_flight());
+    size_t submitted = 0;
+    // Statements before it are all done
+    size_t oldest = 0;
+    while (outcomes->completed < sqls.size()) {
+        while (submitted < sqls.size() && submitted - outcomes->completed < max_in_flight) {
+            const size_t i = submitted++;
+            const auto now = Clock::now();
+            const bool unbounded =
+                    timeout == std::chrono::milliseconds::max() || timeout > Clock::time_point::max() - now;
+            starts[i] = now;
+            deadlines[i] = unbounded ? Clock::time_point::max() : now + timeout;
+            Submit(sqls[i], deadlines[i], [outcomes, i, timeout](Status status, std::chrono::microseconds latency) {
+                if (outcomes->done[i]) return;
+                if (status.code() == Status::SUCCESS && latency > timeout) status = Status(Status::TIMEOUT);
+                outcomes->statuses[i] = std::move(status);
+                outcomes->latencies[i] = latency;
+                outcomes->done[i] = true;
+                outcomes->completed++;
+            });
+        }
+        if (outcomes->completed == sqls.size()) break;
+        Poll(kPollInterval);
+        // Statements the provider did not report by their deadlines time out anyway
+        const auto now = Clock::now();
+        while (oldest < submitted && outcomes->done[oldest]) oldest++;
+        for (size_t i = oldest; i < submitted; i++) {
+            if (outcomes->done[i] || deadlines[i] == Clock::time_point::max() || now < deadlines[i] + kDeadlineGrace) {
+                continue;
+            }
+            outcomes->statuses[i] = Status(Status::TIMEOUT, "not reported by the deadline");
+            outcomes->latencies[i] = std::chrono::duration_cast<std::chrono::microseconds>(now - starts[i]);
+            outcomes->done[i] = true;
+            outcomes->completed++;
+        }
+    }
+    *statuses = std::move(outcomes->statuses);
+    *latencies = std::move(outcomes->latencies);
+}
+
+bool IAsyncSQLProvider::Run(std::string_view sql, std::string *error_msg) {
+    std::vector<Status> statuses;
+    std::vector<std::chrono::microseconds> latencies;
+    RunAll({sql}, std::chrono::milliseconds::max(), &statuses, &latencies);
+    if (statuses[0].code() == Status::SUCCESS) return true;
+    *error_msg = statuses[0].message();
+    return false;
+}
+
 const Status::Code Status::SUCCESS;
 const Status::Code Status::ERROR;
 const Status::Code Status::TIMEOUT;
 const Status::Code Status::CRASH;
 
+static const std::vector<std::string> phase_to_text{"parse", "bind", "optimize", "execute"};
+
+std::string PhaseName(Phase phase) { return phase_to_text[static_cast<size_t>(phase)]; }
+
+bool ParsePhase(std::string_view name, Phase *phase) {
+    for (size_t k = 0; k < phase_to_text.size(); k++) {
+        if (name == phase_to_text[k]) {
+            *phase = static_cast<Phase>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+void PhaseTimes::Start(Phase phase) {
+    Stop();
+    current_ = phase;
+    running_ = true;
+    start_ = std::chrono::steady_clock::now();
+}
+
+void PhaseTimes::Stop() {
+    if (!running_) return;
+    times_[static_cast<size_t>(current_)] +=
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_);
+    running_ = false;
+}
+
 static const std::vector<std::string> code_to_text{"Success", "Error", "Timeout", "Crash"};
 static const std::vector<char> code_to_char{'.', 'E', 'T', '#'};
 
 std::string Status::ToString() const {
-    if (code() < 0 || static_cast<size_t>(code()) > code_to_text.size()) {
+    if (code() < 0 || static_cast<size_t>(code()) >= code_to_text.size()) {
         return "Unknown: " + std::to_string(code());
     }
     return code_to_text[code()] + (message_.empty() ? "" : ": " + message_);
 }
 
 char Status::ToChar() const {
-    if (code() < 0 || static_cast<size_t>(code()) > code_to_char.size()) {
+    if (code() < 0 || static_cast<size_t>(code()) >= code_to_char.size()) {
         return '?';
     }
     return code_to_char[code()];
 }
 
+Driver::Driver() {}
+
+Driver::~Driver() {}
+
+void Driver::set_corpus_writer(std::unique_ptr<CorpusWriter> value) { corpus_ = std::move(value); }
+
+void Driver::set_timeline(std::unique_ptr<TimelineWriter> value) { timeline_ = std::move(value); }
+
 Driver::Driver(int argc, char **argv) {
     argh::parser cmdl(argv);
 
@@ -58,24 +403,164 @@ Driver::Driver(int argc, char **argv) {
     std::string feature_names;
     cmdl("features") >> feature_names;
     set_feature_names(feature_names);
+
+    size_t generation_threads;
+    cmdl("gen_threads", 1) >> generation_threads;
+    set_generation_threads(generation_threads);
+
+    std::string corpus_path;
+    cmdl("export_corpus") >> corpus_path;
+    if (!corpus_path.empty()) {
+        auto writer = std::make_unique<CorpusWriter>();
+        std::string error;
+        if (writer->Open(corpus_path, &error)) {
+            set_corpus_writer(std::move(writer));
+        } else {
+            std::cerr << "corpus: " << error << std::endl;
+        }
+    }
+
+    std::string record_path;
+    cmdl("record") >> record_path;
+    if (!record_path.empty()) {
+        auto recorder = std::make_unique<ProbeRecorder>();
+        std::string error;
+        if (recorder->Open(record_path, &error)) {
+            AddProbeListener(std::move(recorder));
+        } else {
+            std::cerr << "record: " << error << std::endl;
+        }
+    }
+
+    std::string stop_after;
+    cmdl("stop_after", "execute") >> stop_after;
+    if (!ParsePhase(stop_after, &stop_after_)) {
+        std::cerr << "stop_after: no phase " << stop_after << std::endl;
+    }
+
+    std::string results_path, results_format;
+    cmdl("results") >> results_path;
+    cmdl("results_format", "jsonl") >> results_format;
+    if (!results_path.empty()) {
+        auto writer = std::make_unique<ResultsWriter>();
+        ResultsWriter::Format format;
+        std::string error;
+        if (!ResultsWriter::ParseFormat(results_format, &format)) {
+            std::cerr << "results: no format " << results_format << std::endl;
+        } else if (writer->Open(results_path, format, &error)) {
+            AddProbeListener(std::move(writer));
+        } else {
+            std::cerr << "results: " << error << std::endl;
+        }
+    }
+
+    std::string timeline_path;
+    cmdl("timeline") >> timeline_path;
+    if (!timeline_path.empty()) {
+        auto timeline = std::make_unique<TimelineWriter>();
+        std::string error;
+        if (timeline->Open(timeline_path, &error)) {
+            set_timeline(std::move(timeline));
+        } else {
+            std::cerr << "timeline: " << error << std::endl;
+        }
+    }
+
+    std::string replay_path;
+    cmdl("replay") >> replay_path;
+    size_t replay_threads;
+    cmdl("replay_threads", 1) >> replay_threads;
+    set_replay_log(replay_path, replay_threads);
+
+    set_lockstep(cmdl["lockstep"]);
+
+    std::string slo_ms;
+    cmdl("slo_ms") >> slo_ms;
+    if (!slo_ms.empty()) {
+        std::vector<std::chrono::milliseconds> thresholds;
+        std::istringstream list(slo_ms);
+        for (std::string item; std::getline(list, item, ',');) {
+            char *end = nullptr;
+            const long long ms = std::strtoll(item.c_str(), &end, 10);
+            if (item.empty() || *end != '\0' || ms <= 0) {
+                std::cerr << "slo_ms: not a number of milliseconds: " << item << std::endl;
+                thresholds.clear();
+                break;
+            }
+            thresholds.emplace_back(ms);
+        }
+        set_latency_thresholds(std::move(thresholds));
+    }
+
+    std::string ab_providers;
+    cmdl("ab") >> ab_providers;
+    size_t ab_repetitions;
+    cmdl("ab_repetitions", 20) >> ab_repetitions;
+    if (!ab_providers.empty()) {
+        const size_t comma = ab_providers.find(',');
+        if (comma == std::string::npos) {
+            std::cerr << "ab: expected two providers separated by a comma" << std::endl;
+        } else {
+            set_ab_providers(ab_providers.substr(0, comma), ab_providers.substr(comma + 1), ab_repetitions);
+        }
+    }
+
+    if (cmdl["reference_parser"]) {
+        ReferenceParser::Limits limits;
+        cmdl("reference_max_depth", limits.max_depth) >> limits.max_depth;
+        cmdl("reference_max_length", limits.max_length) >> limits.max_length;
+        RegisterSQLProvider(std::make_unique<ReferenceParser>(limits));
+    }
+
+    // Providers registered so far are checked by this driver
+    for (auto &provider : RegisteredProviders()) {
+        AddProvider(std::move(provider));
+    }
+    RegisteredProviders().clear();
+}
+
+bool Driver::ShouldCheck(const ISQLProvider &provider) const {
+    if (!provider_names_to_check_.empty()) {
+        if (provider_names_to_check_.find(provider.name()) == std::string::npos) {
+            return false;
+        }
+    }
+    if (stop_after_ != Phase::EXECUTE && !provider.has_phases()) {
+        std::cout << provider.name() << ": skipped, cannot stop after " << PhaseName(stop_after_) << std::endl;
+        return false;
+    }
+    return true;
 }
 
 std::vector<Result> Driver::Run() {
+    if (!replay_log_.empty()) {
+        return RunReplay();
+    }
+    if (!ab_provider_a_.empty()) {
+        return RunABs();
+    }
+    if (lockstep_) {
+        return RunLocksteps();
+    }
+    if (!latency_thresholds_.empty()) {
+        return RunSLOs();
+    }
     std::vector<Result> results;
     for (auto &provider: providers_) {
-        if (!provider_names_to_check_.empty()) {
-            if (provider_names_to_check_.find(provider->name()) == std::string::npos) {
-                continue;
-            }
+        if (!ShouldCheck(*provider)) {
+            continue;
         }
         provider->Init();
-        std::cout << provider->name() << std::endl;
+        std::cout << provider->name();
+        if (stop_after_ != Phase::EXECUTE) std::cout << " (stop after " << PhaseName(stop_after_) << ")";
+        std::cout << std::endl;
         for (auto &feature: GetBuiltinFeatures()) {
             if (!feature_names_to_check_.empty()) {
                 if (feature->name().find(feature_names_to_check_) == std::string::npos) {
                     continue;
                 }
             }
+            feature->set_generation_threads(generation_threads_);
             for (auto &r : Run(provider.get(), feature.get())) {
                 results.emplace_back(std::move(r));
             }
@@ -91,7 +576,6 @@ std::vector<Result> Driver::Run(ISQLProvider *provider, ISQLFeature *feature) {
     }
 
     Status status;
-    std::string sql;
     // First, run the feature doubling @n until it fails
     // TODO(moshap): Use Incrementer class to support different strategies.
     size_t n1 = 1;
@@ -169,6 +653,7 @@ std::vector<Result> Driver::Run(ISQLProvider *provider, ISQLFeature *feature) {
         result.feature = feature->name();
         result.limit = n1;
         result.status = status;
+        result.phase = stop_after_;
         findings.emplace_back(std::move(result));
     }
 
@@ -206,31 +691,44 @@ std::vector<Result> Driver::Run(ISQLProvider *provider, ISQLFeature *feature) {
         std::string last_kind = error_kind(status);
         int consecutive_same = 0;
         size_t doublings = 0;
-        for (size_t n_next = n_first_fail; doublings < kMaxDoublings; ++doublings) {
-            if (n_next > std::numeric_limits<size_t>::max() / 2) break;
-            n_next *= 2;
-            Status s = CheckFeature(n_next, feature, provider);
-            if (!perftrace_) {
-                std::cout << s.ToChar();
-                std::flush(std::cout);
+        bool done = false;
+        for (size_t n_next = n_first_fail; !done;) {
+            // Doublings are independent of each other, so they are checked in waves of one batch,
+            // each as long as the number of identical results that would end the exploration.
+            std::vector<size_t> wave;
+            while (wave.size() < static_cast<size_t>(kMaxConsecutiveSame - consecutive_same) &&
+                   doublings < kMaxDoublings && n_next <= std::numeric_limits<size_t>::max() / 2) {
+                n_next *= 2;
+                wave.push_back(n_next);
+                doublings++;
             }
-            std::string kind = error_kind(s);
-            if (kind != last_kind) {
+            if (wave.empty()) break;
+            auto statuses = CheckFeatureBatch(wave, feature, provider);
+            for (size_t k = 0; k < wave.size(); k++) {
+                const Status &s = statuses[k];
                 if (!perftrace_) {
-                    std::cout << " new at n=" << n_next
-                              << " status = " << code_to_text[s.code()] << ": " << short_message(s);
+                    std::cout << s.ToChar();
                     std::flush(std::cout);
                 }
-                Result extra;
-                extra.provider = provider->name();
-                extra.feature = feature->name();
-                extra.limit = n_next;
-                extra.status = Status(s.code(), short_message(s));
-                findings.emplace_back(std::move(extra));
-                last_kind = kind;
-                consecutive_same = 0;
-            } else if (++consecutive_same >= kMaxConsecutiveSame) {
-                break;
+                std::string kind = error_kind(s);
+                if (kind != last_kind) {
+                    if (!perftrace_) {
+                        std::cout << " new at n=" << wave[k]
+                                  << " status = " << code_to_text[s.code()] << ": " << short_message(s);
+                        std::flush(std::cout);
+                    }
+                    Result extra;
+                    extra.provider = provider->name();
+                    extra.feature = feature->name();
+                    extra.limit = wave[k];
+                    extra.status = Status(s.code(), short_message(s));
+                    extra.phase = stop_after_;
+                    findings.emplace_back(std::move(extra));
+                    last_kind = kind;
+                    consecutive_same = 0;
+                } else if (++consecutive_same >= kMaxConsecutiveSame) {
+                    done = true;
+                }
             }
         }
         if (!perftrace_) {
@@ -239,9 +737,738 @@ std::vector<Result> Driver::Run(ISQLProvider *provider, ISQLFeature *feature) {
         }
     }
 
+    for (auto &listener : listeners_) {
+        for (const auto &finding : findings) listener->OnResult(finding);
+    }
     return findings;
 }
 
+std::vector<FrontierResult> Driver::RunFrontiers() {
+    std::vector<FrontierResult> results;
+    for (auto &provider: providers_) {
+        if (!ShouldCheck(*provider)) {
+            continue;
+        }
+        provider->Init();
+        std::cout << provider->name();
+        if (stop_after_ != Phase::EXECUTE) std::cout << " (stop after " << PhaseName(stop_after_) << ")";
+        std::cout << std::endl;
+        for (auto &feature: GetBuiltinMultiFeatures()) {
+            if (!feature_names_to_check_.empty()) {
+                if (feature->name().find(feature_names_to_check_) == std::string::npos) {
+                    continue;
+                }
+            }
+            results.emplace_back(RunFrontier(provider.get(), feature.get()));
+        }
+    }
+    return results;
+}
+
+FrontierResult Driver::RunFrontier(ISQLProvider *provider, IMultiSQLFeature *feature) {
+    FrontierResult result;
+    result.provider = provider->name();
+    result.feature = feature->name();
+    result.dimension_names = feature->dimension_names();
+    if (!perftrace_) {
+        std::cout << feature->name() << ":";
+        std::flush(std::cout);
+    }
+
+    auto succeeds = [&](size_t n1, size_t n2) {
+        Status status = CheckFeature({n1, n2}, feature, provider);
+        result.probes++;
+        if (!perftrace_) {
+            std::cout << status.ToChar();
+            std::flush(std::cout);
+        }
+        result.status.Update(status);
+        return status.code() == Status::SUCCESS;
+    };
+    // Largest n in [@lo, @hi) for which @check succeeds, given that it succeeds for @lo and fails
+    // for @hi. Unknown @hi is found by doubling @n, like in one-dimensional search.
+    constexpr size_t kUnknown = std::numeric_limits<size_t>::max();
+    auto limit = [](size_t lo, size_t hi, const auto &check) {
+        while (hi == kUnknown && lo < kUnknown) {
+            const size_t n = lo < kUnknown / 2 ? lo * 2 : kUnknown;
+            if (check(n)) {
+                lo = n;
+            } else {
+                hi = n;
+            }
+        }
+        while (hi - lo > 1) {
+            const size_t n = lo + (hi - lo) / 2;
+            if (check(n)) {
+                lo = n;
+            } else {
+                hi = n;
+            }
+        }
+        return lo;
+    };
+
+    if (result.dimension_names.size() != 2) {
+        result.status = Status(Status::ERROR, "only two-dimensional features are supported");
+    } else if (succeeds(1, 1)) {
+        const size_t max_n1 = limit(1, kUnknown, [&](size_t n1) { return succeeds(n1, 1); });
+        size_t n2 = limit(1, kUnknown, [&](size_t n) { return succeeds(1, n); });
+        result.frontier.push_back({1, n2});
+        for (size_t n1 = 1; n1 < max_n1;) {
+            n1 = n1 <= max_n1 / 2 ? n1 * 2 : max_n1;
+            // The limit of the second dimension can only go down as the first one grows, so
+            // the step down starts from the previous limit.
+            if (!succeeds(n1, n2)) {
+                if (n2 == 1) break;
+                n2 = limit(1, n2, [&](size_t n) { return succeeds(n1, n); });
+            }
+            // Point with the same second dimension and smaller first one is dominated by this one
+            if (result.frontier.back()[1] == n2) {
+                result.frontier.pop_back();
+            }
+            result.frontier.push_back({n1, n2});
+        }
+    }
+
+    if (!perftrace_) {
+        std::cout << " frontier =";
+        for (const auto &point : result.frontier) {
+            std::cout << " (" << point[0] << "," << point[1] << ")";
+        }
+        std::cout << " probes = " << result.probes << " status = " << result.status.ToString() << std::endl;
+    }
+    return result;
+}
+
+std::vector<InteractionResult> Driver::RunInteractions(
+        ISQLProvider *provider, size_t max_pairs, unsigned seed,
+        std::vector<std::unique_ptr<ISQLFeature>> (*make_features)()) {
+    auto features = make_features();
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (size_t outer = 0; outer < features.size(); outer++) {
+        const FragmentKind kind = features[outer]->hole().kind;
+        if (kind == FragmentKind::NONE) continue;
+        for (size_t inner = 0; inner < features.size(); inner++) {
+            if (features[inner]->fragment_kind() == kind) pairs.emplace_back(outer, inner);
+        }
+    }
+    std::shuffle(pairs.begin(), pairs.end(), std::mt19937(seed));
+    if (pairs.size() > max_pairs) pairs.resize(max_pairs);
+
+    // Limits of features on their own, searched once per feature
+    std::vector<size_t> limits(features.size(), 0);
+    auto single_limit = [&](size_t i) {
+        if (limits[i] == 0) limits[i] = Run(provider, features[i].get())[0].limit;
+        return limits[i];
+    };
+
+    std::vector<InteractionResult> results;
+    for (const auto &[outer, inner] : pairs) {
+        InteractionResult result;
+        result.outer_limit = single_limit(outer);
+        result.inner_limit = single_limit(inner);
+        // Features keep the SQL they generated, so every pair gets instances of its own, and a
+        // feature nested into itself gets two of them
+        auto outer_features = make_features();
+        auto inner_features = make_features();
+        outer_features[outer]->set_generation_threads(generation_threads_);
+        inner_features[inner]->set_generation_threads(generation_threads_);
+        auto nested = Nest(std::move(outer_features[outer]), std::move(inner_features[inner]));
+        result.nested = RunFrontier(provider, nested.get());
+        const auto &frontier = result.nested.frontier;
+        result.blowup = frontier.empty() ||
+                        frontier.front()[1] * kBlowupFactor < result.inner_limit ||
+                        frontier.back()[0] * kBlowupFactor < result.outer_limit;
+        if (result.blowup && !perftrace_) {
+            std::cout << "blowup: " << result.nested.feature << " limits " << result.outer_limit << " and "
+                      << result.inner_limit << " alone, ";
+            if (frontier.empty()) {
+                std::cout << "none nested" << std::endl;
+            } else {
+                std::cout << frontier.back()[0] << " and " << frontier.front()[1] << " nested" << std::endl;
+            }
+        }
+        results.emplace_back(std::move(result));
+    }
+    return results;
+}
+
+std::vector<Result> Driver::RunReplay() {
+    std::vector<Probe> probes;
+    std::string error;
+    if (!ReadProbeLog(replay_log_, &probes, &error)) {
+        std::cerr << "replay: " << error << std::endl;
+        return {};
+    }
+    std::vector<Result> results;
+    for (auto &replay : Replay(probes, replay_threads_)) {
+        Result result;
+        result.provider = std::move(replay.replayed.provider);
+        result.feature = std::move(replay.replayed.feature);
+        result.limit = replay.replayed.dims[0];
+        result.status = std::move(replay.replayed.status);
+        result.phase = stop_after_;
+        for (auto &listener : listeners_) listener->OnResult(result);
+        results.emplace_back(std::move(result));
+    }
+    return results;
+}
+
+std::vector<ReplayResult> Driver::Replay(const std::vector<Probe> &probes, size_t threads) {
+    std::map<std::string, ISQLProvider *> providers;
+    for (auto &provider : providers_) providers.emplace(provider->name(), provider.get());
+    // Providers are initialized once, before any thread uses them
+    std::set<std::string> used;
+    // Asynchronous providers get runs as long as they can have in flight
+    size_t run_size = kReplayBatch;
+    for (const auto &probe : probes) {
+        auto it = providers.find(probe.provider);
+        if (it == providers.end() || !used.insert(probe.provider).second) continue;
+        it->second->Init();
+        if (auto *async = dynamic_cast<IAsyncSQLProvider *>(it->second)) {
+            run_size = std::max(run_size, async->max_in_flight());
+        }
+    }
+
+    std::vector<ReplayResult> results(probes.size());
+    std::atomic<size_t> next(0);
+    // Listeners see the probes of one batch at a time
+    std::mutex listeners_mutex;
+    auto replay = [&] {
+        // Features keep the SQL they generated, so every thread has instances of its own
+        auto features = GetBuiltinFeatures();
+        auto multi_features = GetBuiltinMultiFeatures();
+        // Batch being collected, of statements for the same provider and timeout. Batches are
+        // split to keep the SQL they hold within the SQL cap.
+        ISQLProvider *batch_provider = nullptr;
+        std::chrono::milliseconds batch_timeout(0);
+        std::vector<size_t> batch;
+        BatchSql sqls;
+        std::vector<std::string> traces;
+        size_t bytes = 0;
+        auto flush = [&] {
+            if (batch.empty()) return;
+            const std::vector<std::string_view> &views = sqls.views();
+            std::vector<Status> statuses;
+            std::vector<Measurement> measurements(batch.size());
+            if (batch_provider->has_phases()) {
+                for (size_t k = 0; k < batch.size(); k++) {
+                    statuses.push_back(CheckSQL(views[k], batch_provider, traces[k], batch_timeout, &measurements[k]));
+                }
+            } else {
+                statuses = CheckBatch(views, batch_provider, traces, batch_timeout, &measurements);
+            }
+            for (size_t k = 0; k < batch.size(); k++) {
+                Probe &replayed = results[batch[k]].replayed;
+                replayed.sql_bytes = views[k].size();
+                replayed.status = std::move(statuses[k]);
+                replayed.latency = measurements[k].latency;
+                replayed.session_time = measurements[k].session_time;
+                replayed.cpu_time = measurements[k].cpu_time;
+                replayed.phases = measurements[k].phases;
+            }
+            if (!listeners_.empty()) {
+                std::lock_guard<std::mutex> lock(listeners_mutex);
+                for (size_t index : batch) {
+                    for (auto &listener : listeners_) listener->OnProbe(results[index].replayed);
+                }
+            }
+            batch.clear();
+            sqls.Clear();
+            traces.clear();
+            bytes = 0;
+        };
+        // Keeps the statement @feature holds for the batch before it generates again
+        auto detach = [&](const void *feature) {
+            if (sqls.live_bytes(feature) > kMaxCopiedSqlBytes) flush();
+            sqls.Detach(feature);
+        };
+        for (size_t begin = next.fetch_add(run_size); begin < probes.size(); begin = next.fetch_add(run_size)) {
+            for (size_t i = begin; i < std::min(begin + run_size, probes.size()); i++) {
+                const Probe &probe = probes[i];
+                results[i].recorded = probe;
+                Probe &replayed = results[i].replayed;
+                replayed.provider = probe.provider;
+                replayed.feature = probe.feature;
+                replayed.dims = probe.dims;
+                replayed.timeout = probe.timeout;
+
+                std::string_view sql;
+                const void *source = nullptr;
+                if (probe.dims.size() == 1) {
+                    for (auto &feature : features) {
+                        if (feature->name() != probe.feature) continue;
+                        detach(feature.get());
+                        feature->set_generation_threads(generation_threads_);
+                        TimelineWriter::Scope generate(timeline_.get(), "generate");
+                        sql = feature->GenerateSQL(probe.dims[0]);
+                        source = feature.get();
+                        break;
+                    }
+                } else {
+                    for (auto &feature : multi_features) {
+                        if (feature->name() != probe.feature) continue;
+                        detach(feature.get());
+                        TimelineWriter::Scope generate(timeline_.get(), "generate");
+                        sql = feature->GenerateSQL(probe.dims);
+                        source = feature.get();
+                        break;
+                    }
+                }
+                auto provider = providers.find(probe.provider);
+                if (provider == providers.end()) {
+                    replayed.status = Status(Status::ERROR, "unknown provider");
+                    continue;
+                }
+                if (source == nullptr) {
+                    replayed.status = Status(Status::ERROR, "unknown feature");
+                    continue;
+                }
+                if (provider->second != batch_provider || probe.timeout != batch_timeout ||
+                    bytes + sql.size() > kMaxSqlBytes) {
+                    flush();
+                }
+                batch_provider = provider->second;
+                batch_timeout = probe.timeout;
+                batch.push_back(i);
+                sqls.Add(source, sql);
+                traces.push_back(tracing() ? probe.feature + "," + JoinDims(probe.dims) : std::string());
+                bytes += sql.size();
+            }
+            flush();
+        }
+    };
+    if (threads <= 1) {
+        replay();
+    } else {
+        std::vector<std::thread> workers;
+        for (size_t k = 0; k < threads; k++) workers.emplace_back(replay);
+        for (auto &worker : workers) worker.join();
+    }
+
+    if (!perftrace_) {
+        for (const auto &[recorded, replayed] : results) {
+            std::cout << recorded.provider << " " << recorded.feature << " " << JoinDims(recorded.dims) << ": "
+                      << recorded.status.ToChar() << " " << recorded.latency.count() << "us -> "
+                      << replayed.status.ToChar() << " " << replayed.latency.count() << "us";
+            if (recorded.latency.count() > 0) {
+                const double delta = 100.0 * (replayed.latency.count() - recorded.latency.count()) /
+                                     recorded.latency.count();
+                std::cout << " (" << (delta >= 0 ? "+" : "") << static_cast<long long>(delta) << "%)";
+            }
+            if (replayed.status.code() != recorded.status.code()) {
+                std::cout << " changed: " << replayed.status.ToString();
+            }
+            std::cout << std::endl;
+        }
+    }
+    return results;
+}
+
+std::vector<Result> Driver::RunSLOs() {
+    std::vector<Result> results;
+    for (auto &provider : providers_) {
+        if (!ShouldCheck(*provider)) continue;
+        provider->Init();
+        std::cout << provider->name() << std::endl;
+        for (auto &feature : GetBuiltinFeatures()) {
+            if (!feature_names_to_check_.empty() &&
+                feature->name().find(feature_names_to_check_) == std::string::npos) {
+                continue;
+            }
+            feature->set_generation_threads(generation_threads_);
+            const SLOResult slo = RunSLO(provider.get(), feature.get());
+            // A result per threshold, as feature "name@<=10ms", then the hard limit
+            for (size_t k = 0; k <= slo.limits.size(); k++) {
+                Result result;
+                result.provider = slo.provider;
+                result.feature = slo.feature;
+                result.limit = slo.hard_limit;
+                result.status = slo.status;
+                result.phase = stop_after_;
+                if (k < slo.limits.size()) {
+                    const std::string threshold = "<=" + std::to_string(slo.thresholds[k].count()) + "ms";
+                    result.feature += "@" + threshold;
+                    result.limit = slo.limits[k];
+                    if (result.limit < slo.hard_limit) {
+                        result.status = Status(Status::TIMEOUT, "latency over " + threshold);
+                    }
+                }
+                for (auto &listener : listeners_) listener->OnResult(result);
+                results.emplace_back(std::move(result));
+            }
+        }
+    }
+    return results;
+}
+
+SLOResult Driver::RunSLO(ISQLProvider *provider, ISQLFeature *feature) {
+    SLOResult result;
+    result.provider = provider->name();
+    result.feature = feature->name();
+    result.thresholds = latency_thresholds_;
+    // Interval of each threshold, then of the hard limit: the largest size known to meet it, 0
+    // for none, and the smallest known not to
+    constexpr size_t kUnknown = std::numeric_limits<size_t>::max();
+    const size_t hard = latency_thresholds_.size();
+    std::vector<std::pair<size_t, size_t>> intervals(hard + 1, {0, kUnknown});
+
+    auto check = [&](size_t n) {
+        Measurement measurement;
+        Status status;
+        // Same safety caps as in CheckFeature
+        if (n > kMaxN) {
+            status = Status(Status::TIMEOUT, "n exceeds safety cap");
+        } else {
+            std::string_view sql;
+            {
+                TimelineWriter::Scope generate(timeline_.get(), "generate");
+                sql = feature->GenerateSQL(n);
+            }
+            if (sql.size() > kMaxSqlBytes) {
+                status = Status(Status::TIMEOUT, "sql size exceeds safety cap");
+            } else {
+                if (corpus_) corpus_->Add(result.feature, {n}, sql);
+                const std::string trace = tracing() ? result.feature + "," + std::to_string(n) : std::string();
+                status = CheckSQL(sql, provider, trace, timeout_, &measurement);
+                NotifyProbe(provider, result.feature, {n}, sql.size(), status, measurement);
+                result.probes++;
+            }
+        }
+        if (!perftrace_) {
+            std::cout << status.ToChar();
+            std::flush(std::cout);
+        }
+        result.status.Update(status);
+        for (size_t k = 0; k <= hard; k++) {
+            auto &[lo, hi] = intervals[k];
+            if (n <= lo || n >= hi) continue;
+            const bool met = status.code() == Status::SUCCESS &&
+                             (k == hard || measurement.latency <= latency_thresholds_[k]);
+            (met ? lo : hi) = n;
+        }
+    };
+
+    if (!perftrace_) {
+        std::cout << result.feature << ":";
+        std::flush(std::cout);
+    }
+    // Sizes grow until a statement fails, like in Run
+    for (size_t n = 1; intervals[hard].second == kUnknown;) {
+        check(n);
+        if (feature->is_exponential()) {
+            if (n == kUnknown) break;
+            n++;
+        } else if (n < kUnknown / 2) {
+            n *= 2;
+        } else if (n < kUnknown) {
+            n = kUnknown;
+        } else {
+            break;
+        }
+    }
+    if (!feature->is_exponential() && !perftrace_) {
+        for (size_t k = 0; k <= hard; k++) {
+            // Intervals narrow as other thresholds are bisected, so each is read again after a check
+            while (intervals[k].second != kUnknown && intervals[k].second - intervals[k].first > 1) {
+                check(intervals[k].first + (intervals[k].second - intervals[k].first) / 2);
+            }
+        }
+    }
+    for (size_t k = 0; k < hard; k++) result.limits.push_back(intervals[k].first);
+    result.hard_limit = intervals[hard].first;
+
+    if (!perftrace_) {
+        std::cout << " ";
+        for (size_t k = 0; k < hard; k++) {
+            std::cout << "<=" << latency_thresholds_[k].count() << "ms " << result.limits[k] << ", ";
+        }
+        std::cout << "limit = " << result.hard_limit << " status = " << result.status.ToString() << " ("
+                  << result.probes << " probes)" << std::endl;
+    }
+    return result;
+}
+
+std::vector<Result> Driver::RunLocksteps() {
+    std::vector<ISQLProvider *> providers;
+    for (auto &provider : providers_) {
+        if (!ShouldCheck(*provider)) continue;
+        provider->Init();
+        providers.push_back(provider.get());
+    }
+    std::vector<Result> results;
+    if (providers.empty()) return results;
+    for (auto &feature : GetBuiltinFeatures()) {
+        if (!feature_names_to_check_.empty() && feature->name().find(feature_names_to_check_) == std::string::npos) {
+            continue;
+        }
+        feature->set_generation_threads(generation_threads_);
+        for (auto &limit : RunLockstep(providers, feature.get()).limits) results.emplace_back(std::move(limit));
+    }
+    return results;
+}
+
+LockstepResult Driver::RunLockstep(const std::vector<ISQLProvider *> &providers, ISQLFeature *feature) {
+    LockstepResult result;
+    result.feature = feature->name();
+    // Search state of each provider, as in Run: @lo succeeded, unless it is the first size, and
+    // @hi failed
+    constexpr size_t kUnknown = std::numeric_limits<size_t>::max();
+    struct Search {
+        size_t lo = 1;
+        size_t hi = kUnknown;
+        Status status;
+    };
+    std::vector<Search> searches(providers.size());
+    for (auto *provider : providers) result.providers.push_back(provider->name());
+    std::map<size_t, LockstepResult::Row> rows;
+
+    // Checks size @n for the providers at @indexes, with SQL generated once
+    auto check = [&](size_t n, const std::vector<size_t> &indexes) {
+        LockstepResult::Row &row = rows[n];
+        row.n = n;
+        row.checked.resize(providers.size());
+        row.statuses.resize(providers.size());
+        row.latencies.resize(providers.size());
+        std::string_view sql;
+        Status cap;
+        // Same safety caps as in CheckFeature
+        if (n > kMaxN) {
+            cap = Status(Status::TIMEOUT, "n exceeds safety cap");
+        } else {
+            TimelineWriter::Scope generate(timeline_.get(), "generate");
+            sql = feature->GenerateSQL(n);
+            result.generated++;
+            if (sql.size() > kMaxSqlBytes) cap = Status(Status::TIMEOUT, "sql size exceeds safety cap");
+        }
+        if (cap.code() == Status::SUCCESS && corpus_) corpus_->Add(result.feature, {n}, sql);
+        const std::string trace = tracing() ? result.feature + "," + std::to_string(n) : std::string();
+        for (size_t k : indexes) {
+            Status status = cap;
+            if (cap.code() == Status::SUCCESS) {
+                Measurement measurement;
+                status = CheckSQL(sql, providers[k], trace, timeout_, &measurement);
+                NotifyProbe(providers[k], result.feature, {n}, sql.size(), status, measurement);
+                row.latencies[k] = measurement.latency;
+                result.checked++;
+            }
+            Search &search = searches[k];
+            search.status.Update(status);
+            if (status.code() == Status::SUCCESS) {
+                search.lo = n;
+            } else {
+                search.hi = n;
+            }
+            row.checked[k] = true;
+            row.statuses[k] = std::move(status);
+        }
+    };
+
+    // Sizes grow until every provider failed, like in Run
+    std::vector<size_t> growing(providers.size());
+    for (size_t k = 0; k < providers.size(); k++) growing[k] = k;
+    for (size_t n = 1; !growing.empty();) {
+        check(n, growing);
+        growing.erase(std::remove_if(growing.begin(), growing.end(), [&](size_t k) { return searches[k].hi == n; }),
+                      growing.end());
+        if (feature->is_exponential()) {
+            if (n == kUnknown) break;
+            n++;
+        } else if (n < kUnknown / 2) {
+            n *= 2;
+        } else if (n < kUnknown) {
+            n = kUnknown;
+        } else {
+            break;
+        }
+    }
+    // Then bisect in rounds, sharing the statements of common midpoints
+    if (!feature->is_exponential() && !perftrace_) {
+        for (;;) {
+            std::map<size_t, std::vector<size_t>> midpoints;
+            for (size_t k = 0; k < providers.size(); k++) {
+                const Search &search = searches[k];
+                if (search.hi == kUnknown) continue;
+                const size_t n = search.lo + (search.hi - search.lo) / 2;
+                if (n != search.lo && n != search.hi) midpoints[n].push_back(k);
+            }
+            if (midpoints.empty()) break;
+            for (const auto &[n, indexes] : midpoints) check(n, indexes);
+        }
+    }
+
+    for (auto &[n, row] : rows) result.rows.push_back(std::move(row));
+    for (size_t k = 0; k < providers.size(); k++) {
+        Result limit;
+        limit.provider = providers[k]->name();
+        limit.feature = result.feature;
+        // Run reports the first size which failed for exponential features
+        limit.limit = feature->is_exponential() && searches[k].hi != kUnknown ? searches[k].hi : searches[k].lo;
+        limit.status = searches[k].status;
+        limit.phase = stop_after_;
+        result.limits.push_back(std::move(limit));
+    }
+    for (auto &listener : listeners_) {
+        for (const auto &limit : result.limits) listener->OnResult(limit);
+    }
+
+    // Table of a column per provider, each cell the status and latency
+    if (!perftrace_) {
+        std::vector<size_t> widths;
+        for (const auto &name : result.providers) widths.push_back(std::max<size_t>(name.size(), 12));
+        auto print_row = [&](const std::string &first, const std::vector<std::string> &cells) {
+            std::string line = std::string(std::max<int>(10 - static_cast<int>(first.size()), 0), ' ') + first;
+            for (size_t k = 0; k < cells.size(); k++) {
+                line += "  " + cells[k] + std::string(widths[k] - std::min(widths[k], cells[k].size()), ' ');
+            }
+            std::cout << line.substr(0, line.find_last_not_of(' ') + 1) << std::endl;
+        };
+        std::cout << result.feature << ": " << result.generated << " statements generated, " << result.checked
+                  << " checked" << std::endl;
+        print_row("n", result.providers);
+        for (const auto &row : result.rows) {
+            std::vector<std::string> cells;
+            for (size_t k = 0; k < providers.size(); k++) {
+                if (!row.checked[k]) {
+                    cells.emplace_back();
+                } else {
+                    cells.push_back(std::string(1, row.statuses[k].ToChar()) + " " +
+                                    std::to_string(row.latencies[k].count()) + "us");
+                }
+            }
+            print_row(std::to_string(row.n), cells);
+        }
+        std::vector<std::string> cells;
+        for (const auto &limit : result.limits) cells.push_back(std::to_string(limit.limit));
+        print_row("limit", cells);
+    }
+    return result;
+}
+
+std::vector<Result> Driver::RunABs() {
+    ISQLProvider *a = nullptr;
+    ISQLProvider *b = nullptr;
+    for (auto &provider : providers_) {
+        if (provider->name() == ab_provider_a_) a = provider.get();
+        if (provider->name() == ab_provider_b_) b = provider.get();
+    }
+    if (a == nullptr || b == nullptr || a == b) {
+        std::cerr << "ab: need two registered providers, got " << ab_provider_a_ << " and " << ab_provider_b_
+                  << std::endl;
+        return {};
+    }
+    a->Init();
+    b->Init();
+    if (!perftrace_) std::cout << a->name() << " vs " << b->name() << std::endl;
+    std::vector<Result> results;
+    for (auto &feature : GetBuiltinFeatures()) {
+        if (!feature_names_to_check_.empty() && feature->name().find(feature_names_to_check_) == std::string::npos) {
+            continue;
+        }
+        feature->set_generation_threads(generation_threads_);
+        const auto sizes = RunAB(a, b, feature.get());
+        std::vector<Result> limits(2);
+        for (size_t k = 0; k < 2; k++) {
+            limits[k].provider = (k == 0 ? a : b)->name();
+            limits[k].feature = feature->name();
+            limits[k].phase = stop_after_;
+        }
+        for (const auto &size : sizes) {
+            for (size_t k = 0; k < 2; k++) {
+                const Status &status = k == 0 ? size.status_a : size.status_b;
+                if (status.code() == Status::SUCCESS) {
+                    limits[k].limit = size.n;
+                } else {
+                    // Run reports the first size which failed for exponential features
+                    if (feature->is_exponential() && limits[k].status.code() == Status::SUCCESS) {
+                        limits[k].limit = size.n;
+                    }
+                    limits[k].status.Update(status);
+                }
+            }
+        }
+        for (auto &listener : listeners_) {
+            for (const auto &limit : limits) listener->OnResult(limit);
+        }
+        for (auto &limit : limits) results.emplace_back(std::move(limit));
+    }
+    return results;
+}
+
+std::vector<ABResult> Driver::RunAB(ISQLProvider *a, ISQLProvider *b, ISQLFeature *feature) {
+    std::vector<ABResult> results;
+    const std::string name = feature->name();
+    if (!perftrace_) std::cout << name << ":" << std::endl;
+    // Sizes double, or grow by one for exponential features, like in Run
+    for (size_t n = 1; n <= kMaxN; n = feature->is_exponential() ? n + 1 : n * 2) {
+        std::string_view sql;
+        {
+            TimelineWriter::Scope generate(timeline_.get(), "generate");
+            sql = feature->GenerateSQL(n);
+        }
+        if (sql.size() > kMaxSqlBytes) break;
+        if (corpus_) corpus_->Add(name, {n}, sql);
+        const std::string trace = tracing() ? name + "," + std::to_string(n) : std::string();
+
+        ABResult result;
+        result.provider_a = a->name();
+        result.provider_b = b->name();
+        result.feature = name;
+        result.n = n;
+        std::vector<double> latencies_a, latencies_b;
+        for (size_t k = 0; k < ab_repetitions_; k++) {
+            double latencies[2] = {0, 0};
+            bool succeeded = true;
+            for (size_t turn = 0; turn < 2; turn++) {
+                // A goes first in even repetitions
+                const bool is_a = (turn == 0) == (k % 2 == 0);
+                ISQLProvider *provider = is_a ? a : b;
+                Measurement measurement;
+                const Status status = CheckSQL(sql, provider, trace, timeout_, &measurement);
+                NotifyProbe(provider, name, {n}, sql.size(), status, measurement);
+                (is_a ? result.status_a : result.status_b).Update(status);
+                succeeded = succeeded && status.code() == Status::SUCCESS;
+                // Timed to the nanosecond unless the checker was lost before reporting
+                const std::chrono::nanoseconds elapsed =
+                        measurement.end_ns > measurement.start_ns
+                                ? std::chrono::nanoseconds(measurement.end_ns - measurement.start_ns) -
+                                          measurement.session_time
+                                : std::chrono::nanoseconds(measurement.latency);
+                latencies[is_a ? 0 : 1] = std::max<int64_t>(elapsed.count(), 0);
+            }
+            if (succeeded) {
+                latencies_a.push_back(latencies[0]);
+                latencies_b.push_back(latencies[1]);
+            }
+        }
+        result.median_a = std::chrono::nanoseconds(static_cast<int64_t>(Median(latencies_a)));
+        result.median_b = std::chrono::nanoseconds(static_cast<int64_t>(Median(latencies_b)));
+        result.comparison = ComparePaired(latencies_a, latencies_b);
+
+        const PairedComparison &comparison = result.comparison;
+        const bool failed = result.status_a.code() != Status::SUCCESS || result.status_b.code() != Status::SUCCESS;
+        if (!perftrace_) {
+            std::cout << "  n=" << n << ":";
+            if (comparison.pairs > 0) {
+                char line[160];
+                std::snprintf(line, sizeof(line), " %.1fus vs %.1fus %+.1f%% [%+.1f%%, %+.1f%%] p=%.3g%s",
+                              result.median_a.count() / 1e3, result.median_b.count() / 1e3, 100 * comparison.change,
+                              100 * comparison.change_low, 100 * comparison.change_high, comparison.p_value,
+                              comparison.significant() ? " *" : "");
+                std::cout << line;
+            }
+            if (failed) {
+                std::cout << " " << a->name() << ": " << result.status_a.ToString() << ", " << b->name() << ": "
+                          << result.status_b.ToString();
+            }
+            std::cout << std::endl;
+        }
+        results.emplace_back(std::move(result));
+        if (failed) break;
+    }
+    return results;
+}
+
 Status Driver::CheckFeature(size_t n, ISQLFeature *feature, ISQLProvider *provider) {
     // Skip queries that would be absurdly large. Both SQL generation and
     // execution become prohibitively slow under sanitizers for n in the
@@ -249,10 +1476,216 @@ Status Driver::CheckFeature(size_t n, ISQLFeature *feature, ISQLProvider *provid
     if (n > kMaxN) {
         return Status(Status::TIMEOUT, "n exceeds safety cap");
     }
-    std::string sql = feature->GenerateSQL(n);
+    std::string_view sql;
+    {
+        TimelineWriter::Scope generate(timeline_.get(), "generate");
+        sql = feature->GenerateSQL(n);
+    }
+    if (sql.size() > kMaxSqlBytes) {
+        return Status(Status::TIMEOUT, "sql size exceeds safety cap");
+    }
+    return CheckProbe(sql, provider, feature->name(), {n});
+}
+
+Status Driver::CheckFeature(const std::vector<size_t> &dims, IMultiSQLFeature *feature, ISQLProvider *provider) {
+    // Units multiply across dimensions, so the cap applies to their product.
+    size_t units = 1;
+    for (size_t n : dims) {
+        if (n > kMaxN / units) {
+            return Status(Status::TIMEOUT, "n exceeds safety cap");
+        }
+        units *= n;
+    }
+    std::string_view sql;
+    {
+        TimelineWriter::Scope generate(timeline_.get(), "generate");
+        sql = feature->GenerateSQL(dims);
+    }
     if (sql.size() > kMaxSqlBytes) {
         return Status(Status::TIMEOUT, "sql size exceeds safety cap");
     }
+    return CheckProbe(sql, provider, feature->name(), dims);
+}
+
+std::vector<Status> Driver::CheckFeatureBatch(const std::vector<size_t> &ns, ISQLFeature *feature,
+                                              ISQLProvider *provider) {
+    std::vector<Status> statuses(ns.size());
+    if (provider->has_phases()) {
+        for (size_t i = 0; i < ns.size(); i++) statuses[i] = CheckFeature(ns[i], feature, provider);
+        return statuses;
+    }
+    const std::string name = feature->name();
+    // Batches are split to keep the SQL they hold within the SQL cap
+    std::vector<size_t> batch;
+    BatchSql sqls;
+    std::vector<std::string> traces;
+    size_t bytes = 0;
+    auto flush = [&] {
+        if (batch.empty()) return;
+        const std::vector<std::string_view> &views = sqls.views();
+        std::vector<Measurement> measurements;
+        auto results = CheckBatch(views, provider, traces, timeout_, &measurements);
+        for (size_t k = 0; k < batch.size(); k++) {
+            NotifyProbe(provider, name, {ns[batch[k]]}, views[k].size(), results[k], measurements[k]);
+            statuses[batch[k]] = std::move(results[k]);
+        }
+        batch.clear();
+        sqls.Clear();
+        traces.clear();
+        bytes = 0;
+    };
+    for (size_t i = 0; i < ns.size(); i++) {
+        // Same safety caps as in CheckFeature
+        if (ns[i] > kMaxN) {
+            statuses[i] = Status(Status::TIMEOUT, "n exceeds safety cap");
+            continue;
+        }
+        if (sqls.live_bytes(feature) > kMaxCopiedSqlBytes) flush();
+        sqls.Detach(feature);
+        std::string_view sql;
+        {
+            TimelineWriter::Scope generate(timeline_.get(), "generate");
+            sql = feature->GenerateSQL(ns[i]);
+        }
+        if (sql.size() > kMaxSqlBytes) {
+            statuses[i] = Status(Status::TIMEOUT, "sql size exceeds safety cap");
+            continue;
+        }
+        if (bytes + sql.size() > kMaxSqlBytes) flush();
+        if (corpus_) corpus_->Add(name, {ns[i]}, sql);
+        batch.push_back(i);
+        sqls.Add(feature, sql);
+        traces.push_back(tracing() ? name + "," + std::to_string(ns[i]) : std::string());
+        bytes += sql.size();
+    }
+    flush();
+    return statuses;
+}
+
+Status Driver::CheckProbe(std::string_view sql, ISQLProvider *provider, const std::string &feature,
+                          const std::vector<size_t> &dims) {
+    if (corpus_) corpus_->Add(feature, dims, sql);
+    const std::string trace = tracing() ? feature + "," + JoinDims(dims) : std::string();
+    Measurement measurement;
+    Status status = CheckSQL(sql, provider, trace, timeout_, &measurement);
+    NotifyProbe(provider, feature, dims, sql.size(), status, measurement);
+    return status;
+}
+
+void Driver::NotifyProbe(ISQLProvider *provider, const std::string &feature, const std::vector<size_t> &dims,
+                         size_t sql_bytes, const Status &status, const Measurement &measurement) {
+    if (listeners_.empty()) return;
+    Probe probe;
+    probe.provider = provider->name();
+    probe.feature = feature;
+    probe.dims = dims;
+    probe.sql_bytes = sql_bytes;
+    probe.timeout = timeout_;
+    probe.status = status;
+    probe.latency = measurement.latency;
+    probe.session_time = measurement.session_time;
+    probe.cpu_time = measurement.cpu_time;
+    probe.phases = measurement.phases;
+    for (auto &listener : listeners_) listener->OnProbe(probe);
+}
+
+void Driver::set_perftrace(bool value) {
+    perftrace_ = value;
+    std::string error;
+    if (perftrace_ && !trace_ring_) trace_ring_ = std::make_unique<TraceRing>();
+    if (perftrace_ && !trace_ring_->is_open() && !trace_ring_->Open(kTraceRingCapacity, &error)) {
+        std::cerr << "perftrace: " << error << std::endl;
+    }
+}
+
+void Driver::CountInFlight(int64_t delta) {
+    const int64_t count = probes_in_flight_ += delta;
+    timeline_->Counter("probes_in_flight", MonotonicNanos(), count);
+}
+
+void Driver::TraceCheck(ISQLProvider *provider, const std::string &trace, const Status &status, int64_t start_ns,
+                        int64_t fork_start_ns, const Measurement &measurement) {
+    const int64_t end_ns = MonotonicNanos();
+    timeline_->Slice("probe", start_ns, end_ns,
+                     {{"provider", provider->name()}, {"sql", trace}, {"status", status.ToString()}});
+    timeline_->Counter("rss_mib", end_ns, Mebibytes(ResidentSetBytes()));
+    // Checkers killed or crashed before reporting leave only the probe
+    if (measurement.start_ns == 0) return;
+    if (fork_start_ns != 0) {
+        timeline_->Slice("fork", fork_start_ns, measurement.start_ns);
+        timeline_->Slice("ipc", measurement.end_ns, end_ns);
+        timeline_->Counter("checker_peak_rss_mib", end_ns, Mebibytes(measurement.peak_rss));
+    }
+    // Phases run one after the other, after opening a session if any
+    int64_t at = measurement.start_ns;
+    auto slice = [&](std::string_view name, std::chrono::microseconds time) {
+        if (time.count() == 0) return;
+        const int64_t time_ns = std::chrono::nanoseconds(time).count();
+        timeline_->Slice(name, at, std::min(at + time_ns, measurement.end_ns));
+        at += time_ns;
+    };
+    slice("session", measurement.session_time);
+    for (size_t k = 0; k < kPhaseCount; k++) {
+        slice(PhaseName(static_cast<Phase>(k)), measurement.phases.time(static_cast<Phase>(k)));
+    }
+}
+
+void Driver::PrintTrace(uint64_t check, ISQLProvider *provider, const std::string &trace) {
+    if (!trace_ring_ || !trace_ring_->is_open()) return;
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    // Slots reserved while no checker runs can only belong to checkers killed before publishing
+    const uint64_t reserved = trace_ring_->reserved();
+    trace_ring_->Drain(&undelivered_traces_, checkers_running_ == 0 ? reserved : 0);
+    for (auto event = undelivered_traces_.begin(); event != undelivered_traces_.end();) {
+        if (event->check != check) {
+            ++event;
+            continue;
+        }
+        PrintTraceLine(*provider, trace, std::chrono::nanoseconds(event->end_ns - event->start_ns),
+                       event->status == Status::SUCCESS, static_cast<Phase>(event->phase));
+        event = undelivered_traces_.erase(event);
+    }
+    const uint64_t drops = trace_ring_->dropped();
+    if (drops > reported_trace_drops_) {
+        std::cerr << "perftrace: " << drops - reported_trace_drops_ << " events dropped" << std::endl;
+        reported_trace_drops_ = drops;
+    }
+}
+
+bool Driver::RunStatement(std::string_view sql, ISQLProvider *provider, uint64_t check, Measurement *measurement,
+                          std::string *error_msg) {
+    const auto cpu_start = ThreadCpuTime();
+    const int64_t start_ns = MonotonicNanos();
+    const bool ok = provider->RunPhased(sql, stop_after_, &measurement->phases, error_msg);
+    const int64_t finish_ns = MonotonicNanos();
+    measurement->cpu_time = ThreadCpuTime() - cpu_start;
+    measurement->session_time = provider->TakeSessionTime();
+    measurement->latency = StatementTime(std::chrono::nanoseconds(finish_ns - start_ns), measurement->session_time);
+    measurement->start_ns = start_ns;
+    measurement->end_ns = finish_ns;
+    if (perftrace_ && trace_ring_ && trace_ring_->is_open()) {
+        TraceEvent event;
+        event.check = check;
+        // The session is opened before the statement runs
+        event.start_ns = std::min(finish_ns, start_ns + std::chrono::nanoseconds(measurement->session_time).count());
+        event.end_ns = finish_ns;
+        event.pid = getpid();
+        event.phase = static_cast<uint8_t>(measurement->phases.last());
+        event.status = ok ? Status::SUCCESS : Status::ERROR;
+        trace_ring_->Push(event);
+    }
+    return ok;
+}
+
+Status Driver::CheckSQL(std::string_view sql, ISQLProvider *provider, const std::string &trace,
+                        std::chrono::milliseconds timeout, Measurement *measurement) {
+    // Asynchronous providers run in process and cancel statements at their deadlines themselves
+    if (dynamic_cast<IAsyncSQLProvider *>(provider) != nullptr) {
+        std::vector<Measurement> measurements;
+        std::vector<Status> statuses = CheckBatch({sql}, provider, {trace}, timeout, &measurements);
+        *measurement = measurements[0];
+        return statuses[0];
+    }
 
     // In-process path: run the provider inline and measure elapsed time.
     // We do NOT enforce the timeout by killing or detaching a worker —
@@ -262,131 +1695,219 @@ Status Driver::CheckFeature(size_t n, ISQLFeature *feature, ISQLProvider *provid
     // out at n=1. Runaway queries are bounded instead by the safety caps
     // (kMaxN / kMaxSqlBytes) applied above before the provider is
     // invoked, so this code can safely block on provider->Run.
+    const uint64_t check = next_check_++;
+    const int64_t start_ns = timeline_ ? MonotonicNanos() : 0;
+    if (timeline_) CountInFlight(1);
+    int64_t fork_start_ns = 0;
+    auto finish = [&](Status status) {
+        if (timeline_) {
+            CountInFlight(-1);
+            TraceCheck(provider, trace, status, start_ns, fork_start_ns, *measurement);
+        }
+        return status;
+    };
     if (!check_crash_) {
         std::string error_msg;
-        auto start = std::chrono::high_resolution_clock::now();
         bool ok;
         try {
-            ok = provider->Run(sql, &error_msg);
+            ok = RunStatement(sql, provider, check, measurement, &error_msg);
         } catch (...) {
             ok = false;
             error_msg = "unknown exception";
         }
-        auto finish = std::chrono::high_resolution_clock::now();
-        if (perftrace_) {
-            std::cout << provider->name() << "," << feature->name() << "," << n << ","
-                      << std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count() << ","
-                      << (ok ? "OK" : "ERROR")
-                      << std::endl;
-        }
+        if (perftrace_) PrintTrace(check, provider, trace);
         if (!ok) {
-            return Status(Status::ERROR, error_msg);
+            return finish(Status(Status::ERROR, error_msg));
         }
-        if (finish - start > timeout_) {
-            return Status(Status::TIMEOUT);
+        if (measurement->latency > timeout) {
+            return finish(Status(Status::TIMEOUT));
         }
-        return Status(Status::SUCCESS);
+        return finish(Status(Status::SUCCESS));
     }
 
-    // Fork-based isolation: fork into checker + timeout-watcher children.
-    // The checker actually runs the SQL; the timeout-watcher kills the
-    // checker if it exceeds timeout_.
+    // Fork-based isolation, see RunIsolated. Get the measurement and the failure
+    // message from the checker instead of re-running the SQL here: a re-run in
+    // this long-lived parent isn't crash-isolated and can take down the whole
+    // process. The measurement comes first, as the bytes of the struct.
+    const auto fork_start = std::chrono::high_resolution_clock::now();
+    if (timeline_) fork_start_ns = MonotonicNanos();
+    std::string output;
+    checkers_running_++;
+    const Status::Code code = RunIsolated(
+            [&](int fd) {
+                std::string error_msg;
+                const bool ok = RunStatement(sql, provider, check, measurement, &error_msg);
+                if (timeline_) measurement->peak_rss = PeakResidentSetBytes();
+                std::string message(reinterpret_cast<const char *>(measurement), sizeof(*measurement));
+                if (!ok) message.append(error_msg, 0, kMaxErrorMsgBytes);
+                WriteAll(fd, message);
+                return ok ? Status::SUCCESS : Status::ERROR;
+            },
+            timeout, &output);
+    checkers_running_--;
+    if (perftrace_) PrintTrace(check, provider, trace);
     std::string error_msg;
-    // Get the failure message from the checker via this pipe instead of
-    // re-running the SQL here: a re-run in this long-lived parent isn't
-    // crash-isolated and can take down the whole process.
-    constexpr size_t kMaxErrorMsgBytes = 4096;
-    int msg_pipe[2];
-    if (pipe(msg_pipe) != 0) {
-        msg_pipe[0] = msg_pipe[1] = -1;
+    if (output.size() >= sizeof(*measurement)) {
+        std::memcpy(static_cast<void *>(measurement), output.data(), sizeof(*measurement));
+        if (code == Status::ERROR) error_msg = output.substr(sizeof(*measurement));
+    } else {
+        // The checker was killed or crashed before it could report
+        *measurement = Measurement();
+        measurement->latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - fork_start);
     }
-    pid_t pid = fork();
-    if (pid == 0) {
-        if (msg_pipe[0] >= 0) close(msg_pipe[0]);  // no one below this point reads
-        pid_t checker_pid = fork();
-        if (checker_pid == 0) {
-            // Silence stderr, since some code writes there in case of errors.
-            // TODO(moshap): Ideally we should detect whether provider code wrote to stderr and report it as a problem,
-            // especially when provider is a library
-            FILE *f = freopen("/dev/null", "w", stderr);
-            clearerr(f);
+    // The watcher can lose the race against a checker finishing just past the timeout
+    if (code == Status::SUCCESS && measurement->latency > timeout) {
+        return finish(Status(Status::TIMEOUT));
+    }
+    return finish(Status(code, error_msg));
+}
 
-            // Run SQL through provider
-            auto start = std::chrono::high_resolution_clock::now();
-            bool ok = provider->Run(sql, &error_msg);
-            auto finish = std::chrono::high_resolution_clock::now();
-            if (perftrace_) {
-                std::cout << provider->name() << "," << feature->name() << "," << n << ","
-                          << std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count() << ","
-                          << (ok ? "OK" : "ERROR")
-                          << std::endl;
-            }
-            // Send the failure message to the parent (bounded so the write can
-            // never exceed the pipe buffer and block).
-            if (!ok && msg_pipe[1] >= 0) {
-                const size_t len =
-                    error_msg.size() < kMaxErrorMsgBytes ? error_msg.size() : kMaxErrorMsgBytes;
-                size_t off = 0;
-                while (off < len) {
-                    ssize_t w = write(msg_pipe[1], error_msg.data() + off, len - off);
-                    if (w <= 0) break;
-                    off += static_cast<size_t>(w);
-                }
-            }
-            if (msg_pipe[1] >= 0) close(msg_pipe[1]);
-            // Use _exit so we don't run static/global destructors inherited
-            // from the parent — those could e.g. send SIGTERM to the shared
-            // firebolt-core process when FireboltCoreWrapper goes out of scope.
-            _exit(ok ? Status::SUCCESS : Status::ERROR);
+std::vector<Status> Driver::CheckBatch(const std::vector<std::string_view> &sqls, ISQLProvider *provider,
+                                       const std::vector<std::string> &traces, std::chrono::milliseconds timeout,
+                                       std::vector<Measurement> *measurements) {
+    std::vector<Status> statuses;
+    std::vector<std::chrono::microseconds> latencies;
+    bool complete = false;
+    // Session and CPU time of the whole batch
+    Measurement batch;
+    const int64_t start_ns = timeline_ ? MonotonicNanos() : 0;
+    if (timeline_) CountInFlight(static_cast<int64_t>(sqls.size()));
+    int64_t fork_start_ns = 0;
+    auto *async = dynamic_cast<IAsyncSQLProvider *>(provider);
+    if (async != nullptr) {
+        const auto cpu_start = ThreadCpuTime();
+        batch.start_ns = MonotonicNanos();
+        try {
+            async->RunAll(sqls, timeout, &statuses, &latencies);
+        } catch (...) {
+            statuses.assign(sqls.size(), Status(Status::ERROR, "unknown exception"));
+            latencies.assign(sqls.size(), std::chrono::microseconds(0));
         }
-
-        pid_t timeout_pid = fork();
-        if (timeout_pid == 0) {
-            if (msg_pipe[1] >= 0) close(msg_pipe[1]);  // timeout-watcher never writes
-            std::this_thread::sleep_for(timeout_);
-            _exit(0);
+        batch.end_ns = MonotonicNanos();
+        batch.cpu_time = ThreadCpuTime() - cpu_start;
+        batch.session_time = provider->TakeSessionTime();
+        complete = true;
+    } else if (!check_crash_) {
+        const auto cpu_start = ThreadCpuTime();
+        batch.start_ns = MonotonicNanos();
+        try {
+            provider->RunBatch(sqls, &statuses, &latencies);
+            complete = true;
+        } catch (...) {
         }
-        // Only the checker holds the write-end, so the parent's read sees EOF
-        // once the checker exits.
-        if (msg_pipe[1] >= 0) close(msg_pipe[1]);
-
-        Status status;
-        int exit_code;
-        pid_t exited_pid = wait(&exit_code);
-        if (exited_pid == checker_pid) {
-            // If checked process finished first, kill timeout process
-            kill(timeout_pid, SIGKILL);
-            // If checker process finished normally, propagate its exit code
-            if (WIFEXITED(exit_code)) {
-                status = Status(WEXITSTATUS(exit_code));
-            } else {
-                // If checker processed finished abnormally, it indicates crash
-                status = Status(Status::CRASH);
+        batch.end_ns = MonotonicNanos();
+        batch.cpu_time = ThreadCpuTime() - cpu_start;
+        batch.session_time = provider->TakeSessionTime();
+    } else {
+        // The checker sends the measurement of the batch, then code, latency and message length
+        // of each statement, followed by the message of a failure
+        std::string output;
+        const std::chrono::milliseconds watchdog =
+                timeout == std::chrono::milliseconds::max()
+                        ? timeout
+                        : timeout * static_cast<std::chrono::milliseconds::rep>(
+                                            std::min(sqls.size(), kBatchWatchdogTimeouts));
+        if (timeline_) fork_start_ns = MonotonicNanos();
+        const Status::Code code = RunIsolated(
+                [&](int fd) {
+                    const auto cpu_start = ThreadCpuTime();
+                    batch.start_ns = MonotonicNanos();
+                    provider->RunBatch(sqls, &statuses, &latencies);
+                    batch.end_ns = MonotonicNanos();
+                    if (statuses.size() != sqls.size() || latencies.size() != sqls.size()) return Status::ERROR;
+                    batch.cpu_time = ThreadCpuTime() - cpu_start;
+                    batch.session_time = provider->TakeSessionTime();
+                    if (timeline_) batch.peak_rss = PeakResidentSetBytes();
+                    std::string message(reinterpret_cast<const char *>(&batch), sizeof(batch));
+                    for (size_t i = 0; i < sqls.size(); i++) {
+                        const std::string &error_msg = statuses[i].message();
+                        const int32_t statement_code = statuses[i].code();
+                        const LatencyCount count = latencies[i].count();
+                        const uint32_t length = static_cast<uint32_t>(std::min(error_msg.size(), kMaxErrorMsgBytes));
+                        message.append(reinterpret_cast<const char *>(&statement_code), sizeof(statement_code));
+                        message.append(reinterpret_cast<const char *>(&count), sizeof(count));
+                        message.append(reinterpret_cast<const char *>(&length), sizeof(length));
+                        message.append(error_msg, 0, length);
+                    }
+                    WriteAll(fd, message);
+                    return Status::SUCCESS;
+                },
+                watchdog, &output);
+        statuses.clear();
+        latencies.clear();
+        complete = code == Status::SUCCESS && output.size() >= sizeof(batch);
+        if (complete) std::memcpy(static_cast<void *>(&batch), output.data(), sizeof(batch));
+        size_t pos = sizeof(batch);
+        while (complete && statuses.size() < sqls.size()) {
+            int32_t statement_code;
+            LatencyCount count;
+            uint32_t length;
+            constexpr size_t kFixed = sizeof(statement_code) + sizeof(count) + sizeof(length);
+            if (output.size() - pos < kFixed) break;
+            std::memcpy(&statement_code, output.data() + pos, sizeof(statement_code));
+            std::memcpy(&count, output.data() + pos + sizeof(statement_code), sizeof(count));
+            std::memcpy(&length, output.data() + pos + sizeof(statement_code) + sizeof(count), sizeof(length));
+            pos += kFixed;
+            if (output.size() - pos < length) break;
+            statuses.emplace_back(statement_code, output.substr(pos, length));
+            latencies.emplace_back(count);
+            pos += length;
+        }
+    }
+    complete = complete && statuses.size() == sqls.size() && latencies.size() == sqls.size();
+    measurements->assign(sqls.size(), Measurement());
+    if (timeline_) {
+        CountInFlight(-static_cast<int64_t>(sqls.size()));
+        const int64_t end_ns = MonotonicNanos();
+        timeline_->Slice("batch", start_ns, end_ns,
+                         {{"provider", provider->name()},
+                          {"statements", std::to_string(sqls.size())},
+                          {"status", complete ? "complete" : "incomplete"}});
+        if (complete && fork_start_ns != 0) {
+            timeline_->Slice("fork", fork_start_ns, batch.start_ns);
+            timeline_->Slice("ipc", batch.end_ns, end_ns);
+            timeline_->Counter("checker_peak_rss_mib", end_ns, Mebibytes(batch.peak_rss));
+        }
+        // Statements of RunBatch run one after the other, while asynchronous ones overlap and are
+        // only shown as the batch
+        if (complete && async == nullptr) {
+            int64_t at = batch.start_ns;
+            if (batch.session_time.count() > 0) {
+                const int64_t session_ns = std::chrono::nanoseconds(batch.session_time).count();
+                timeline_->Slice("session", at, at + session_ns);
+                at += session_ns;
+            }
+            for (size_t i = 0; i < sqls.size(); i++) {
+                const int64_t statement_ns = std::chrono::nanoseconds(latencies[i]).count();
+                timeline_->Slice(PhaseName(Phase::EXECUTE), at, std::min(at + statement_ns, batch.end_ns),
+                                 {{"sql", traces[i]}, {"status", statuses[i].ToString()}});
+                at += statement_ns;
             }
-        } else {
-            // If timeout process finished first, kill checker process
-            kill(checker_pid, SIGKILL);
-            status = Status(Status::TIMEOUT);
         }
-        // Wait for the other (killed) process to finish
-        wait(nullptr);
-        _exit(status.code());
     }
-    if (msg_pipe[1] >= 0) close(msg_pipe[1]);  // parent never writes
-    // Wait for the intermediary process to finish and propagate its exit code
-    int exit_code;
-    waitpid(pid, &exit_code, 0);
-    Status::Code code = WIFEXITED(exit_code) ? Status::Code(WEXITSTATUS(exit_code)) : Status::CRASH;
-    if (code == Status::ERROR && msg_pipe[0] >= 0) {
-        // All write-ends are closed by now, so this drains the message and hits EOF.
-        char buf[1024];
-        ssize_t r;
-        while ((r = read(msg_pipe[0], buf, sizeof(buf))) > 0) {
-            error_msg.append(buf, static_cast<size_t>(r));
+    if (!complete) {
+        // A crash, timeout or exception of the batch as a whole is pinned on a statement by
+        // checking them one by one
+        statuses.clear();
+        for (size_t i = 0; i < sqls.size(); i++) {
+            statuses.push_back(CheckSQL(sqls[i], provider, traces[i], timeout, &(*measurements)[i]));
+        }
+        return statuses;
+    }
+    // Sessions are opened for the first statement of a batch, which is also charged the CPU time
+    (*measurements)[0].session_time = batch.session_time;
+    (*measurements)[0].cpu_time = batch.cpu_time;
+    for (size_t i = 0; i < sqls.size(); i++) {
+        (*measurements)[i].latency = latencies[i];
+        if (perftrace_) {
+            PrintTraceLine(*provider, traces[i], latencies[i], statuses[i].code() == Status::SUCCESS, Phase::EXECUTE);
+        }
+        if (statuses[i].code() == Status::SUCCESS && latencies[i] > timeout) {
+            statuses[i] = Status(Status::TIMEOUT);
         }
     }
-    if (msg_pipe[0] >= 0) close(msg_pipe[0]);
-    return Status(code, error_msg);
+    return statuses;
 }
 
 }  // namespace tensile
@@ -1,18 +1,50 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "stats.h"
+
 namespace tensile {
 
+class CorpusWriter;
+class TimelineWriter;
+class TraceRing;
+struct TraceEvent;
+
 // Test helper abstract class to facilitate comparing expected and actual results.
 // Possible implementation to use EXPECT_EQ macro.
 class ITestComparer {
 public:
     virtual ~ITestComparer() {}
-    virtual void ExpectEq(const std::string &expected, const std::string &actual) = 0;
+    virtual void ExpectEq(std::string_view expected, std::string_view actual) = 0;
+};
+
+// Kind of SQL a feature produces when used as a part of another feature (see composition.h)
+enum class FragmentKind {
+    // Feature can only be used as a whole statement
+    NONE,
+    // Numeric expression: the feature generates "select <expression>"
+    EXPRESSION,
+    // Boolean expression: the feature generates "select <predicate>"
+    PREDICATE,
+    // Query usable as a relation, e.g. in FROM or a CTE: the feature generates the query itself
+    QUERY,
+};
+
+// Place in the SQL of a feature where a fragment of another feature can go: every occurrence of
+// @token, which is itself a fragment of @kind, e.g. the innermost "1" of nested parentheses.
+struct Hole {
+    FragmentKind kind = FragmentKind::NONE;
+    std::string_view token;
 };
 
 // Abstract class representing feature in SQL that we want to find limits of.
@@ -24,8 +56,10 @@ public:
     // Human readable name of the feature
     virtual std::string name() = 0;
 
-    // Generates valid SQL query which has feature with given cardinality @n
-    virtual std::string GenerateSQL(size_t n) = 0;
+    // Generates valid SQL query which has feature with given cardinality @n.
+    // The returned view points into a buffer owned by the feature (usually sql_), and stays valid
+    // until the next call to GenerateSQL or until the feature is destroyed.
+    virtual std::string_view GenerateSQL(size_t n) = 0;
 
     // Test only method for derived class instance to be able test that it generates desired SQL.
     // This will usually call GenerateSQL for low values of @n = 1,2,... and allow reader to inspect
@@ -35,44 +69,178 @@ public:
     }
 
     // Optional validation: checks whether the SQL generated for @n makes syntactic sense.
-    // Returns true if valid. The default implementation does a light check (balanced parens,
-    // known-starts-with). Features with complex output SHOULD override this with a proper
-    // parse if they have a parser available; the base-class check alone is not a substitute.
-    virtual bool ValidateSQL(size_t n, std::string *reason) {
-        auto sql = GenerateSQL(n);
-        unsigned balance = 0;
-        for (char c : sql) {
-            if (c == '(') ++balance;
-            else if (c == ')') {
-                if (balance == 0) { *reason = "unmatched ')'"; return false; }
-                --balance;
-            }
-        }
-        if (balance != 0) { *reason = "unmatched '('"; return false; }
-        // Extract the first keyword (up to first whitespace or end-of-string)
-        auto first_space = sql.find_first_of(" \t\n\r");
-        auto first_word = (first_space == std::string::npos) ? sql : sql.substr(0, first_space);
-        if (first_word != "select" && first_word != "SELECT" &&
-            first_word != "with"  && first_word != "WITH"  &&
-            first_word != "create" && first_word != "CREATE") {
-            *reason = "stmt must start with SELECT, WITH, or CREATE";
-            return false;
-        }
-        return true;
-    }
+    // Returns true if valid. The default implementation does a light check (brackets balanced
+    // outside of literals and comments, known-starts-with). Features with complex output SHOULD
+    // override this with a proper parse if they have a parser available; the base-class check
+    // alone is not a substitute.
+    virtual bool ValidateSQL(size_t n, std::string *reason);
 
     virtual bool is_exponential() const { return false; }
 
+    // Fragment form of the feature, used to compose it with other features.
+    virtual FragmentKind fragment_kind() const { return FragmentKind::NONE; }
+    virtual Hole hole() const { return {}; }
+
+    // Allows GenerateSQL to fill large statements on up to @threads threads. Output is the same
+    // as with one thread; features which cannot split their SQL ignore it.
+    void set_generation_threads(size_t threads) { generation_threads_ = threads; }
+
 protected:
     // Since we expect to call GenerateSQL in the loop multiple times, it is useful to keep
-    // strubg buffer between calls to avoid extra allocations.
+    // strubg buffer between calls to avoid extra allocations. GenerateSQL returns a view of it.
     // Derived classes don't have to use it.
     std::string sql_;
+
+    size_t generation_threads_ = 1;
+};
+
+class SqlBuilder;
+
+// Base class for features whose SQL for @n is made of @n repeated units:
+//
+//     head + Open(0) + ... + Open(n-1) + middle + Close(n-1) + ... + Close(0) + tail
+//
+// Append-style features (lists, operator chains, set operations) only have opening units,
+// closing-bracket features (nesting) also have the matching closing units. The SQL is kept
+// in sql_ between calls, split at the middle into a prefix (head and opening units) and a
+// suffix (closing units and tail). A call for a nearby @n grows or shrinks both parts in
+// place by the difference in units, so the doubling and bisection steps of the driver cost
+// time proportional to the change rather than to the whole statement.
+class IncrementalSQLFeature : public ISQLFeature {
+public:
+    std::string_view GenerateSQL(size_t n) override;
+
+protected:
+    // Fixed text before the first opening unit.
+    virtual void AppendHead(SqlBuilder *sql) = 0;
+
+    // Appends opening unit @i, including the separator from the previous unit if any.
+    virtual void AppendOpen(size_t i, SqlBuilder *sql) = 0;
+
+    // Fixed text between the last opening unit and the first closing unit.
+    virtual void AppendMiddle(SqlBuilder *sql) {}
+
+    // Appends closing unit @i, which matches opening unit @i. Append-style features have none.
+    virtual void AppendClose(size_t i, SqlBuilder *sql) {}
+
+    // Fixed text after the last closing unit.
+    virtual void AppendTail(SqlBuilder *sql) {}
+
+    // Bulk versions, appending units [@begin, @end); closing units go in descending order.
+    // Override when a run of units can be produced faster than one at a time.
+    virtual void AppendOpens(size_t begin, size_t end, SqlBuilder *sql) {
+        for (size_t i = begin; i < end; i++) AppendOpen(i, sql);
+    }
+    virtual void AppendCloses(size_t begin, size_t end, SqlBuilder *sql) {
+        for (size_t i = end; i-- > begin;) AppendClose(i, sql);
+    }
+
+    // Exact sizes of opening and closing units [@begin, @end), for features that can compute
+    // them without generating the units. Returns false if unknown.
+    virtual bool UnitSizes(size_t begin, size_t end, size_t *opens, size_t *closes) { return false; }
+
+private:
+    // Unit counts at which the part boundaries are remembered, so shrinking never has to
+    // regenerate more than this many units.
+    static constexpr size_t kMarkStride = 64;
+
+    void Reset();
+    void Grow(size_t n);
+    void Shrink(size_t n);
+
+    bool built_ = false;
+    // Number of units currently in sql_
+    size_t n_ = 0;
+    // End of the opening units, which is also where the middle starts
+    size_t open_end_ = 0;
+    size_t middle_size_ = 0;
+    // open_marks_[j] is open_end_ for n = j * kMarkStride, close_marks_[j] is the size of
+    // the suffix after the middle for the same n.
+    std::vector<size_t> open_marks_;
+    std::vector<size_t> close_marks_;
+    // Reused between calls to stage the units being inserted
+    std::string opens_;
+    std::string closes_;
 };
 
 // Get list of all SQL features built into Tensile. The list can be extended.
 std::vector<std::unique_ptr<ISQLFeature>> GetBuiltinFeatures();
 
+// Feature with several independent dimensions, e.g. depth of a join chain and width of the
+// select list on each side of the joins. Dimensions interact, so the limits of such a feature
+// form a surface rather than a single number: SQL can fail long before either dimension reaches
+// its own one-dimensional limit.
+class IMultiSQLFeature {
+public:
+    virtual ~IMultiSQLFeature() {}
+
+    // Human readable name of the feature
+    virtual std::string name() = 0;
+
+    // Names of the dimensions, in the order GenerateSQL takes their sizes
+    virtual std::vector<std::string> dimension_names() = 0;
+
+    // Generates valid SQL query with cardinality @dims[k] in dimension k. The returned view has
+    // the same lifetime as the one returned by ISQLFeature::GenerateSQL.
+    virtual std::string_view GenerateSQL(const std::vector<size_t> &dims) = 0;
+
+    // Test only method, see ISQLFeature::SelfTest
+    virtual void SelfTest(ITestComparer *cmp) {}
+
+    // Fragment form, see ISQLFeature
+    virtual FragmentKind fragment_kind() const { return FragmentKind::NONE; }
+    virtual Hole hole() const { return {}; }
+
+protected:
+    std::string sql_;
+};
+
+// Get list of all multi-dimensional SQL features built into Tensile.
+std::vector<std::unique_ptr<IMultiSQLFeature>> GetBuiltinMultiFeatures();
+
+class Status;
+
+// Phases an engine runs a statement through, in order
+enum class Phase {
+    PARSE,
+    // Name resolution and semantic analysis
+    BIND,
+    OPTIMIZE,
+    EXECUTE,
+};
+
+constexpr size_t kPhaseCount = 4;
+
+// Lowercase name of @phase, as in --stop_after
+std::string PhaseName(Phase phase);
+
+// Sets @phase from its name. Returns false if there is no phase of that name.
+bool ParsePhase(std::string_view name, Phase *phase);
+
+// Time a statement spent in each phase, reported by providers which run statements in phases
+class PhaseTimes {
+public:
+    // Ends the current phase, if any, and starts timing @phase
+    void Start(Phase phase);
+
+    // Ends the current phase
+    void Stop();
+
+    std::chrono::microseconds time(Phase phase) const { return times_[static_cast<size_t>(phase)]; }
+
+    // Phase started last, PARSE if none was
+    Phase last() const { return current_; }
+
+    // Sets the time of @phase, e.g. as read back from a results file
+    void set_time(Phase phase, std::chrono::microseconds time) { times_[static_cast<size_t>(phase)] = time; }
+
+private:
+    std::array<std::chrono::microseconds, kPhaseCount> times_{};
+    Phase current_ = Phase::PARSE;
+    bool running_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
 // Abstract class representing SQL backend which knows how to process given SQL query.
 // It can be just a parser, or full-blown executor, or anything in between.
 class ISQLProvider {
@@ -84,11 +252,46 @@ public:
     // Human readable name
     virtual std::string name() const = 0;
 
-    // Take given SQL query, and run it (can be parse, analyze, execute etc)
-    virtual bool Run(const std::string &sql, std::string *error_msg) = 0;
+    // Take given SQL query, and run it (can be parse, analyze, execute etc).
+    // @sql is only valid for the duration of the call. Providers override this overload; the
+    // default copies the SQL for providers written against the older std::string one.
+    virtual bool Run(std::string_view sql, std::string *error_msg) { return Run(std::string(sql), error_msg); }
+
+    // Deprecated: copies the SQL. Kept so providers written against the std::string API still
+    // compile. Providers overriding neither overload fail every statement.
+    virtual bool Run(const std::string &sql, std::string *error_msg) {
+        *error_msg = "Run not implemented";
+        return false;
+    }
+
+    // So that Run("select 1", ...) is not ambiguous between the two overloads
+    bool Run(const char *sql, std::string *error_msg) { return Run(std::string_view(sql), error_msg); }
+
+    // Runs independent statements @sqls in one call, so that providers can pay once for what
+    // they do per call, like opening a connection or resetting a catalog. Sets @statuses to
+    // SUCCESS or ERROR with the message, and @latencies to the time each statement took, one
+    // per statement. The driver applies timeouts to the latencies; a crash, hang or exception
+    // makes it check the statements of the batch one by one. The default runs them with Run.
+    virtual void RunBatch(const std::vector<std::string_view> &sqls, std::vector<Status> *statuses,
+                          std::vector<std::chrono::microseconds> *latencies);
+
+    // Time spent since the last call on setting up and tearing down state statements run in,
+    // like connections (see PooledSQLProvider). The driver calls it after Run and RunBatch in
+    // the process which ran them, leaves it out of statement latencies and reports it apart.
+    virtual std::chrono::microseconds TakeSessionTime() { return std::chrono::microseconds(0); }
+
+    // Whether the provider runs statements in phases, and RunPhased can stop after any of them.
+    // The driver only searches limits of earlier phases than EXECUTE for such providers.
+    virtual bool has_phases() const { return false; }
+
+    // Runs @sql like Run, but only up to and including phase @stop_after, and reports the time of
+    // each phase it goes through to @times. The default runs the whole statement with Run, as a
+    // single EXECUTE phase.
+    virtual bool RunPhased(std::string_view sql, Phase stop_after, PhaseTimes *times, std::string *error_msg);
 };
 
-// Register custom SQL provider to be automatically checked by the driver
+// Register custom SQL provider to be automatically checked by the driver. Registered providers
+// are taken by the next Driver constructed from command line arguments.
 void RegisterSQLProvider(std::unique_ptr<ISQLProvider> provider);
 
 // Status of checking SQL against provider.
@@ -129,6 +332,46 @@ private:
     std::string message_;
 };
 
+// Provider of a server-style engine, which can have many statements in flight at once, e.g. over
+// a pool of connections, while the client mostly waits on the network. The driver runs batches of
+// independent statements with a single event loop (RunAll), submitting statements up to
+// max_in_flight() and polling for their completion. Asynchronous providers are always run in
+// process, even when crashes are checked: a crash of the server shows as errors of the client.
+class IAsyncSQLProvider : public ISQLProvider {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Receives the outcome of a statement: SUCCESS, ERROR with the message, or TIMEOUT if it was
+    // cancelled at its deadline, and the time it took.
+    using Callback = std::function<void(Status status, std::chrono::microseconds latency)>;
+
+    // Starts running @sql, which is only valid for the duration of the call, without waiting for
+    // it. The statement should be cancelled if still running at @deadline.
+    virtual void Submit(std::string_view sql, Clock::time_point deadline, Callback callback) = 0;
+
+    // Waits up to @timeout for statements to complete or pass their deadlines, and calls their
+    // callbacks. Callbacks are only called from Poll, on the thread calling it.
+    virtual void Poll(std::chrono::milliseconds timeout) = 0;
+
+    // Number of statements worth having in flight at once, e.g. the size of the connection pool
+    virtual size_t max_in_flight() const { return 256; }
+
+    // Runs @sqls with up to max_in_flight() of them in flight, each with a deadline @timeout after
+    // it is submitted, until all of them complete. Statements which succeed after their deadline
+    // are reported as TIMEOUT, and so are those not reported shortly after their deadline, should
+    // the provider miss it. Only the first report of a statement counts. @timeout of
+    // milliseconds::max() means no deadline.
+    void RunAll(const std::vector<std::string_view> &sqls, std::chrono::milliseconds timeout,
+                std::vector<Status> *statuses, std::vector<std::chrono::microseconds> *latencies);
+
+    bool Run(std::string_view sql, std::string *error_msg) override;
+
+    void RunBatch(const std::vector<std::string_view> &sqls, std::vector<Status> *statuses,
+                  std::vector<std::chrono::microseconds> *latencies) override {
+        RunAll(sqls, std::chrono::milliseconds::max(), statuses, latencies);
+    }
+};
+
 // Result of checking SQL
 struct Result {
     // Name of SQL provider checked
@@ -139,14 +382,139 @@ struct Result {
     size_t limit;
     // Reason for failure for values above @limit
     Status status;
+    // Last phase statements were run through, see Driver::set_stop_after
+    Phase phase = Phase::EXECUTE;
+};
+
+// Result of searching the limits of a multi-dimensional feature
+struct FrontierResult {
+    // Name of SQL provider checked
+    std::string provider;
+    // Name of SQL feature checked
+    std::string feature;
+    std::vector<std::string> dimension_names;
+    // Largest successful points found, none of which is dominated by another one in every
+    // dimension, ordered by increasing first dimension. Empty if even the smallest SQL fails.
+    std::vector<std::vector<size_t>> frontier;
+    // Most severe failure seen just beyond the frontier
+    Status status;
+    // Number of SQL statements checked
+    size_t probes = 0;
+};
+
+// Result of checking a pair of features nested into each other
+struct InteractionResult {
+    // Limits of the outer and inner feature on their own
+    size_t outer_limit = 0;
+    size_t inner_limit = 0;
+    // Frontier of the inner feature nested into the hole of the outer one
+    FrontierResult nested;
+    // Whether nesting brings either limit down by more than Driver::kBlowupFactor
+    bool blowup = false;
+};
+
+// One SQL statement checked by the driver
+struct Probe {
+    // Name of SQL provider checked
+    std::string provider;
+    // Name of SQL feature checked
+    std::string feature;
+    // Size of the feature in each of its dimensions
+    std::vector<size_t> dims;
+    // Size of the statement
+    size_t sql_bytes = 0;
+    // Timeout the statement was checked with
+    std::chrono::milliseconds timeout{0};
+    Status status;
+    // Time the provider took to run the statement, or until it was killed or crashed
+    std::chrono::microseconds latency{0};
+    // Time the provider spent opening, checking and closing sessions for the statement, which
+    // is not part of @latency (see ISQLProvider::TakeSessionTime)
+    std::chrono::microseconds session_time{0};
+    // CPU time of the thread which ran the statement, sessions included. Statements checked in one
+    // batch are not told apart, and the first one is charged the CPU time of the whole batch.
+    std::chrono::microseconds cpu_time{0};
+    // Time of each phase the provider ran, if it has phases
+    PhaseTimes phases;
+};
+
+// Receives every probe of a driver, in the order they are checked
+class IProbeListener {
+public:
+    virtual ~IProbeListener() {}
+    virtual void OnProbe(const Probe &probe) = 0;
+
+    // Receives the results of Driver::Run for a feature, after its probes
+    virtual void OnResult(const Result &result) {}
+};
+
+// Probe of a recorded run next to the same probe checked again
+struct ReplayResult {
+    Probe recorded;
+    Probe replayed;
+};
+
+// One feature searched for several providers at once, see Driver::RunLockstep
+struct LockstepResult {
+    std::string feature;
+    std::vector<std::string> providers;
+    // Size checked for any of the providers, with what each one gave, in the order of @providers
+    struct Row {
+        size_t n = 0;
+        // Whether the provider was checked at this size at all
+        std::vector<bool> checked;
+        std::vector<Status> statuses;
+        std::vector<std::chrono::microseconds> latencies;
+    };
+    // By increasing size
+    std::vector<Row> rows;
+    // Result of each provider, as Driver::Run would find it without exploring beyond: the largest
+    // size which succeeded, or the first one which failed for exponential features
+    std::vector<Result> limits;
+    // Statements generated and checked, the latter once per provider
+    size_t generated = 0;
+    size_t checked = 0;
+};
+
+// Limits of a feature under several latency thresholds, see Driver::RunSLO
+struct SLOResult {
+    std::string provider;
+    std::string feature;
+    std::vector<std::chrono::milliseconds> thresholds;
+    // Largest size whose statement succeeded within each of @thresholds, 0 if not even size 1
+    std::vector<size_t> limits;
+    // Largest size which succeeded at all within the timeout, 0 if not even size 1
+    size_t hard_limit = 0;
+    // Most severe failure seen
+    Status status;
+    // Number of SQL statements checked
+    size_t probes = 0;
+};
+
+// Two providers checked in alternation at one size of a feature, see Driver::RunAB
+struct ABResult {
+    std::string provider_a;
+    std::string provider_b;
+    std::string feature;
+    size_t n = 0;
+    // Most severe status of each provider over the repetitions
+    Status status_a;
+    Status status_b;
+    // Median latency of each provider over the repetitions where both succeeded
+    std::chrono::nanoseconds median_a{0};
+    std::chrono::nanoseconds median_b{0};
+    // Latency of B relative to A over those repetitions, paired by repetition
+    PairedComparison comparison;
 };
 
 class Driver {
 public:
-    Driver() {}
+    Driver();
 
     Driver(int argc, char **argv);
 
+    ~Driver();
+
     // Register custom SQL provider to be checked by the driver
     void AddProvider(std::unique_ptr<ISQLProvider> provider) {
         providers_.emplace_back(std::move(provider));
@@ -156,6 +524,59 @@ public:
 
     std::vector<Result> Run(ISQLProvider *provider, ISQLFeature *feature);
 
+    // Searches limits of all builtin multi-dimensional features for all registered providers.
+    std::vector<FrontierResult> RunFrontiers();
+
+    // Finds the frontier between successful and failing SQL of a two-dimensional @feature.
+    // Assuming that SQL which succeeds also succeeds with fewer units in any dimension, the
+    // search walks down the boundary like a staircase: it takes log-spaced sizes of the first
+    // dimension and, for each, bisects the second dimension only below the limit found for the
+    // previous size. Checks O(log(n1) * log(n2)) statements instead of a full grid.
+    FrontierResult RunFrontier(ISQLProvider *provider, IMultiSQLFeature *feature);
+
+    // Checks @probes again with the timeouts they were recorded with, against the registered
+    // providers and fresh builtin features of the same names, so that the search path does not
+    // depend on new results. Probes are checked on up to @threads threads, each taking runs of
+    // consecutive probes and checking them in order with RunBatch; with more than one thread,
+    // providers must be thread-safe unless crashes are checked out of process. Prints the
+    // recorded and new status and latency of each probe. Probes of unknown providers or features
+    // fail with an ERROR. Listeners get the probes checked again, from one thread at a time.
+    std::vector<ReplayResult> Replay(const std::vector<Probe> &probes, size_t threads = 1);
+
+    // Checks providers @a and @b against the same SQL of @feature, generated once per size, doubling
+    // n from 1, or growing it by one for exponential features, until either fails. At each size,
+    // both run the statement as many times as set with set_ab_providers, in alternating order: A
+    // first in even repetitions and B first in odd ones, so that drifts of the machine hit both
+    // alike. Prints and returns the paired comparison of each size. Listeners are notified of
+    // every probe.
+    std::vector<ABResult> RunAB(ISQLProvider *a, ISQLProvider *b, ISQLFeature *feature);
+
+    // Searches the limit of @feature for all @providers at once, generating the SQL of each size
+    // only once and checking it against every provider which needs it. Sizes grow as in Run for
+    // all providers together; the bisection then goes in rounds, where providers whose intervals
+    // share a midpoint share its statement. Prints a table of the status and latency of each
+    // provider per size, and the limits. Listeners are notified of every probe and result.
+    LockstepResult RunLockstep(const std::vector<ISQLProvider *> &providers, ISQLFeature *feature);
+
+    // Finds the largest size of @feature which @provider runs within each latency threshold set with
+    // set_latency_thresholds, and the largest which succeeds at all, in one search. Sizes grow as
+    // in Run until a statement fails; then the interval of every threshold is bisected, while
+    // each statement checked narrows the intervals of all thresholds and of the hard limit at
+    // once. Thresholds beyond the timeout are met wherever statements succeed. Listeners are
+    // notified of every probe.
+    SLOResult RunSLO(ISQLProvider *provider, ISQLFeature *feature);
+
+    // Limit of one feature inside another, below which nesting is reported as a blowup
+    static constexpr size_t kBlowupFactor = 10;
+
+    // Samples up to @max_pairs pairs of features, where the fragment of the second one fits into
+    // the hole of the first one, and searches the frontier of each pair nested with Nest().
+    // Reports pairs whose limits when nested are far below their limits on their own. Features
+    // come from @make_features, which is called again for each pair to get fresh instances.
+    std::vector<InteractionResult> RunInteractions(
+            ISQLProvider *provider, size_t max_pairs, unsigned seed = 0,
+            std::vector<std::unique_ptr<ISQLFeature>> (*make_features)() = GetBuiltinFeatures);
+
     // After finding the first-failure boundary, also continue doubling @n to
     // surface deeper, distinct failures (e.g. a parser cap masking a planner
     // bug at higher depth). Enabled by default.
@@ -175,7 +596,62 @@ public:
     // Which features to test
     void set_feature_names(std::string value) { feature_names_to_check_ = std::move(value); }
 
-    void set_perftrace(bool value) { perftrace_ = value; }
+    // Prints a line of provider, feature, size, milliseconds with nanosecond digits, OK or ERROR
+    // and the last phase for every statement instead of progress. Checkers, forked or not, write
+    // their timings to a shared-memory ring, which the driver drains and prints, so statements
+    // print nothing themselves. Must be set before checking anything.
+    void set_perftrace(bool value);
+
+    // Last phase to run statements through, e.g. OPTIMIZE to search the limits of the optimizer
+    // without paying for execution. Before EXECUTE, providers without phases are skipped.
+    void set_stop_after(Phase value) { stop_after_ = value; }
+
+    // How many threads features may use to generate large SQL statements
+    void set_generation_threads(size_t value) { generation_threads_ = value; }
+
+    // Adds a listener notified of every probe checked by Run, RunFrontiers and RunInteractions, and
+    // of the results of Run
+    void AddProbeListener(std::unique_ptr<IProbeListener> listener) {
+        listeners_.emplace_back(std::move(listener));
+    }
+
+    // Probe log (see probe_log.h) which Run replays instead of searching, on @threads threads
+    void set_replay_log(std::string path, size_t threads = 1) {
+        replay_log_ = std::move(path);
+        replay_threads_ = threads;
+    }
+
+    // Providers which Run compares with RunAB over the builtin features instead of searching, with
+    // @repetitions checks of each size per provider
+    void set_ab_providers(std::string a, std::string b, size_t repetitions = 20) {
+        ab_provider_a_ = std::move(a);
+        ab_provider_b_ = std::move(b);
+        ab_repetitions_ = repetitions;
+    }
+
+    // Latency thresholds for which Run reports the limits with RunSLO instead of searching, by
+    // increasing latency
+    void set_latency_thresholds(std::vector<std::chrono::milliseconds> value) {
+        std::sort(value.begin(), value.end());
+        latency_thresholds_ = std::move(value);
+    }
+
+    // Whether Run searches all selected providers in lockstep, see RunLockstep
+    void set_lockstep(bool value) { lockstep_ = value; }
+
+    // Corpus to add every checked statement to, see corpus.h. The driver writes the index when
+    // destroyed, unless the writer is closed before.
+    void set_corpus_writer(std::unique_ptr<CorpusWriter> value);
+
+    CorpusWriter *corpus_writer() const { return corpus_.get(); }
+
+    // Timeline to record checks to, see timeline.h. Every thread checking probes is a worker slot
+    // with a track of slices for generating SQL, each probe or batch and, within them, forking,
+    // session, engine phases and reading the checker's report. Counters track probes in flight,
+    // the driver's RSS and the peak RSS of forked checkers.
+    void set_timeline(std::unique_ptr<TimelineWriter> value);
+
+    TimelineWriter *timeline() const { return timeline_.get(); }
 
     bool perftrace() const { return perftrace_; }
 
@@ -187,10 +663,113 @@ private:
     std::string feature_names_to_check_;
     bool perftrace_ = false;
     bool explore_beyond_ = true;
+    Phase stop_after_ = Phase::EXECUTE;
+    size_t generation_threads_ = 1;
+    std::unique_ptr<CorpusWriter> corpus_;
+    std::vector<std::unique_ptr<IProbeListener>> listeners_;
+    std::string replay_log_;
+    size_t replay_threads_ = 1;
+
+    // Perftrace events, see set_perftrace. Created by it, before any checker is forked.
+    std::unique_ptr<TraceRing> trace_ring_;
+    // Identifies the statements of checks in trace events
+    std::atomic<uint64_t> next_check_{0};
+    // Forked checkers which may still push to the trace ring
+    std::atomic<size_t> checkers_running_{0};
+    std::mutex trace_mutex_;
+    // Events drained from the trace ring for checks of other threads
+    std::vector<TraceEvent> undelivered_traces_;
+    uint64_t reported_trace_drops_ = 0;
+    std::unique_ptr<TimelineWriter> timeline_;
+    std::atomic<int64_t> probes_in_flight_{0};
+
+    // Whether checks need traces identifying their SQL
+    bool tracing() const { return perftrace_ || timeline_ != nullptr; }
+
+    bool lockstep_ = false;
+    std::vector<std::chrono::milliseconds> latency_thresholds_;
+    std::string ab_provider_a_;
+    std::string ab_provider_b_;
+    size_t ab_repetitions_ = 20;
+
+    // Runs the probes of the replay log, see Replay, with a result per probe for the listeners
+    std::vector<Result> RunReplay();
+
+    // Finds the latency limits of every builtin feature for the selected providers, see RunSLO.
+    // Returns and reports to the listeners a result per threshold, of feature "<name>@<=10ms" and
+    // a TIMEOUT status if a larger size succeeded slower, followed by the hard limit.
+    std::vector<Result> RunSLOs();
+
+    // Searches every builtin feature in lockstep for the selected providers, see RunLockstep
+    std::vector<Result> RunLocksteps();
+
+    // Compares the A/B providers on every builtin feature, see RunAB. Returns the limit of each
+    // provider as Run reports it: the largest size at which all its repetitions succeeded, or the
+    // first one at which any failed for exponential features.
+    std::vector<Result> RunABs();
 
     // Checks if given feature succeeds or fails for the given provider.
     // This function can also detect crashes and execution longer than given timeout.
     Status CheckFeature(size_t n, ISQLFeature *feature, ISQLProvider *provider);
+
+    // Same for a point of multi-dimensional feature.
+    Status CheckFeature(const std::vector<size_t> &dims, IMultiSQLFeature *feature, ISQLProvider *provider);
+
+    // Same for several sizes of a feature at once, checked with RunBatch.
+    std::vector<Status> CheckFeatureBatch(const std::vector<size_t> &ns, ISQLFeature *feature,
+                                          ISQLProvider *provider);
+
+    // Checks SQL of @feature with sizes @dims against provider and notifies the listeners.
+    Status CheckProbe(std::string_view sql, ISQLProvider *provider, const std::string &feature,
+                      const std::vector<size_t> &dims);
+
+    // Whether @provider is checked at all, given the provider names and the phase to stop after
+    bool ShouldCheck(const ISQLProvider &provider) const;
+
+    // What checking a statement measured besides its status, see Probe
+    struct Measurement {
+        std::chrono::microseconds latency{0};
+        std::chrono::microseconds session_time{0};
+        std::chrono::microseconds cpu_time{0};
+        PhaseTimes phases;
+        // When the statement or batch ran, as MonotonicNanos, unless 0
+        int64_t start_ns = 0;
+        int64_t end_ns = 0;
+        // Peak RSS of a forked checker, with a timeline only
+        size_t peak_rss = 0;
+    };
+
+    // Runs @sql in this process and measures it into @measurement. With perftrace on, pushes its
+    // event for @check to the trace ring.
+    bool RunStatement(std::string_view sql, ISQLProvider *provider, uint64_t check, Measurement *measurement,
+                      std::string *error_msg);
+
+    // Adds @delta to the probes in flight and records the count to the timeline
+    void CountInFlight(int64_t delta);
+
+    // Records to the timeline a check of @trace which started at @start_ns, forked at @fork_start_ns
+    // unless 0, and ended now with @status and @measurement
+    void TraceCheck(ISQLProvider *provider, const std::string &trace, const Status &status, int64_t start_ns,
+                    int64_t fork_start_ns, const Measurement &measurement);
+
+    // Prints the perftrace lines of @check from the trace ring, with @trace identifying the SQL
+    void PrintTrace(uint64_t check, ISQLProvider *provider, const std::string &trace);
+
+    // Checks given SQL against provider within @timeout and sets @measurement. @trace identifies
+    // the SQL in perftrace output.
+    Status CheckSQL(std::string_view sql, ISQLProvider *provider, const std::string &trace,
+                    std::chrono::milliseconds timeout, Measurement *measurement);
+
+    // Same for independent statements @sqls in one RunBatch call, with one trace and measurement
+    // for each, and @timeout applying to each statement. Session and CPU time of the batch are
+    // charged to its first statement. Batches run to the end, so callers check providers with
+    // phases with CheckSQL instead.
+    std::vector<Status> CheckBatch(const std::vector<std::string_view> &sqls, ISQLProvider *provider,
+                                   const std::vector<std::string> &traces, std::chrono::milliseconds timeout,
+                                   std::vector<Measurement> *measurements);
+
+    void NotifyProbe(ISQLProvider *provider, const std::string &feature, const std::vector<size_t> &dims,
+                     size_t sql_bytes, const Status &status, const Measurement &measurement);
 };
 
 }  // namespace tensile
@@ -0,0 +1,55 @@
+// Compares two sweeps written with --results in JSONL or binary format, e.g. of two builds of an
+// engine, and prints what changed, see CompareResults:
+//     tensile_compare [options] BASELINE CANDIDATE
+// Options:
+//     --limit_tolerance=0.1 - fraction of a limit which may be lost or gained without a change
+//     --latency_ratio=1.5   - median latency ratio of a probe beyond which it is slower or faster
+//     --noise_factor=3      - times the relative spread of repeated probes the ratio must exceed
+//     --min_latency_us=100  - probes faster than this on both sides are not compared
+//     --regressions_only    - leaves out improvements
+// Exits with 0 if nothing regressed, 1 if something did and 2 if a file cannot be read.
+#include "argh/argh.h"
+#include "compare.h"
+#include "results_writer.h"
+
+#include <iostream>
+
+int main(int argc, char **argv) {
+    using namespace tensile;
+    argh::parser cmdl(argv);
+    if (cmdl.pos_args().size() != 3) {
+        std::cerr << "usage: " << argv[0] << " [options] BASELINE CANDIDATE" << std::endl;
+        return 2;
+    }
+
+    CompareOptions options;
+    cmdl("limit_tolerance", options.limit_tolerance) >> options.limit_tolerance;
+    cmdl("latency_ratio", options.latency_ratio) >> options.latency_ratio;
+    cmdl("noise_factor", options.noise_factor) >> options.noise_factor;
+    int64_t min_latency_us;
+    cmdl("min_latency_us", options.min_latency.count()) >> min_latency_us;
+    options.min_latency = std::chrono::microseconds(min_latency_us);
+
+    ResultSet sets[2];
+    for (size_t k = 0; k < 2; k++) {
+        const std::string &path = cmdl.pos_args()[k + 1];
+        std::string error;
+        if (!ReadResults(path, &sets[k].probes, &sets[k].results, &error)) {
+            std::cerr << error << std::endl;
+            return 2;
+        }
+    }
+
+    size_t regressions = 0, improvements = 0;
+    for (const auto &change : CompareResults(sets[0], sets[1], options)) {
+        if (change.regression()) {
+            regressions++;
+        } else {
+            improvements++;
+            if (cmdl["regressions_only"]) continue;
+        }
+        std::cout << change.ToString() << std::endl;
+    }
+    std::cout << regressions << " regressions, " << improvements << " improvements" << std::endl;
+    return regressions > 0 ? 1 : 0;
+}
@@ -1,7 +1,18 @@
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
+#include "composition.h"
+#include "synthetic_provider.h"
 #include "tensile.h"
 
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
 namespace tensile {
 namespace {
 
@@ -28,6 +39,7 @@ TEST(Status, ToString) {
 
     EXPECT_THAT(Status(-1).ToString(), testing::HasSubstr("Unknown"));
     EXPECT_THAT(Status(1000).ToString(), testing::HasSubstr("Unknown"));
+    EXPECT_THAT(Status(Status::CRASH + 1).ToString(), testing::HasSubstr("Unknown"));
 }
 
 TEST(Status, ToChar) {
@@ -36,14 +48,28 @@ TEST(Status, ToChar) {
 
     EXPECT_EQ('?', Status(-2).ToChar());
     EXPECT_EQ('?', Status(20000).ToChar());
+    EXPECT_EQ('?', Status(Status::CRASH + 1).ToChar());
 }
 
 class TestFeature : public ISQLFeature {
 public:
     std::string name() override { return "Test"; }
-    std::string GenerateSQL(size_t n) override {
+    std::string_view GenerateSQL(size_t n) override {
         // Not really a SQL, just a string which is n characters long.
-        return std::string(n, 'x');
+        sql_.assign(n, 'x');
+        return sql_;
+    }
+};
+
+// SQL with @dims[0] rows of @dims[1] characters, so that ErrorProvider accepts exactly the points
+// with dims[0] * dims[1] <= n.
+class TestMultiFeature : public IMultiSQLFeature {
+public:
+    std::string name() override { return "Test"; }
+    std::vector<std::string> dimension_names() override { return {"rows", "columns"}; }
+    std::string_view GenerateSQL(const std::vector<size_t> &dims) override {
+        sql_.assign(dims[0] * dims[1], 'x');
+        return sql_;
     }
 };
 
@@ -60,7 +86,7 @@ protected:
 class ErrorProvider : public TestProvider {
 public:
     ErrorProvider(size_t n) : TestProvider(n) {}
-    bool Run(const std::string& sql, std::string* error_msg) override {
+    bool Run(std::string_view sql, std::string* error_msg) override {
         return sql.size() <= n_;
     }
 };
@@ -68,7 +94,7 @@ public:
 class TimeoutProvider : public TestProvider {
 public:
     TimeoutProvider(size_t n) : TestProvider(n) {}
-    bool Run(const std::string& sql, std::string* error_msg) override {
+    bool Run(std::string_view sql, std::string* error_msg) override {
         if (sql.size() <= n_) {
             return true;
         }
@@ -83,7 +109,7 @@ public:
 class CrashProvider : public TestProvider {
 public:
     CrashProvider(size_t n) : TestProvider(n) {}
-    bool Run(const std::string& sql, std::string* error_msg) override {
+    bool Run(std::string_view sql, std::string* error_msg) override {
         if (sql.size() <= n_) {
             return true;
         }
@@ -92,6 +118,40 @@ public:
     }
 };
 
+// Provider written against the const std::string& signature of Run
+class StringProvider : public ISQLProvider {
+public:
+    std::string name() const override { return "String"; }
+    bool Run(const std::string& sql, std::string* error_msg) override {
+        return sql.size() <= 100;
+    }
+};
+
+// Provider which overrides neither overload of Run
+class NoRunProvider : public ISQLProvider {
+public:
+    std::string name() const override { return "NoRun"; }
+};
+
+TEST(Driver, StringProvider) {
+    StringProvider p;
+    ISQLProvider *provider = &p;
+    std::string error;
+    EXPECT_TRUE(provider->Run("select 1", &error));
+    EXPECT_FALSE(provider->Run(std::string_view(std::string(101, 'x')), &error));
+
+    Driver d;
+    TestFeature f;
+    auto results = d.Run(&p, &f);
+    ASSERT_EQ(1, results.size());
+    EXPECT_EQ(Status::ERROR, results[0].status.code());
+    EXPECT_EQ(100, results[0].limit);
+
+    NoRunProvider none;
+    EXPECT_FALSE(none.Run(std::string_view("select 1"), &error));
+    EXPECT_EQ("Run not implemented", error);
+}
+
 TEST(Driver, Error) {
     Driver d;
     TestFeature f;
@@ -122,6 +182,578 @@ TEST(Driver, Crash) {
     EXPECT_EQ(42, results[0].limit);
 }
 
+// Fails differently for SQL longer than 1000, and remembers the size of each batch it runs
+class BatchProvider : public TestProvider {
+public:
+    BatchProvider(size_t n) : TestProvider(n) {}
+    bool Run(std::string_view sql, std::string* error_msg) override {
+        *error_msg = sql.size() > 1000 ? "much too long" : "too long";
+        return sql.size() <= n_;
+    }
+    void RunBatch(const std::vector<std::string_view> &sqls, std::vector<Status> *statuses,
+                  std::vector<std::chrono::microseconds> *latencies) override {
+        batch_sizes.push_back(sqls.size());
+        ISQLProvider::RunBatch(sqls, statuses, latencies);
+    }
+    std::vector<size_t> batch_sizes;
+};
+
+TEST(Driver, ExploreBeyondInBatches) {
+    Driver d;
+    d.set_check_crash(false);
+    TestFeature f;
+    BatchProvider e(100);
+    auto results = d.Run(&e, &f);
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ(100, results[0].limit);
+    EXPECT_EQ(1616, results[1].limit);
+    EXPECT_EQ("much too long", results[1].status.message());
+    // Doublings of the first failure at 101: 202 to 1616, where the message changes, then four
+    // more which end the exploration
+    EXPECT_EQ(std::vector<size_t>({4, 4}), e.batch_sizes);
+}
+
+TEST(Driver, LargeStatementsEndBatches) {
+    Driver d;
+    d.set_check_crash(false);
+    TestFeature f;
+    BatchProvider e(70000);
+    auto results = d.Run(&e, &f);
+    ASSERT_EQ(1, results.size());
+    EXPECT_EQ(70000, results[0].limit);
+    // Doublings of the first failure are too large to copy out of the feature, so each one runs
+    // in a batch of its own, right from the feature's buffer
+    ASSERT_FALSE(e.batch_sizes.empty());
+    EXPECT_THAT(e.batch_sizes, testing::Each(1));
+}
+
+// Engine whose parser, optimizer and executor each have a limit on the SQL length. Execution
+// takes a millisecond.
+class PhasedProvider : public ISQLProvider {
+public:
+    std::string name() const override { return "phased"; }
+    bool Run(std::string_view sql, std::string *error_msg) override {
+        PhaseTimes times;
+        return RunPhased(sql, Phase::EXECUTE, &times, error_msg);
+    }
+    bool has_phases() const override { return true; }
+    bool RunPhased(std::string_view sql, Phase stop_after, PhaseTimes *times, std::string *error_msg) override {
+        const size_t limits[kPhaseCount] = {200, 200, 50, 20};
+        for (size_t k = 0; k <= static_cast<size_t>(stop_after); k++) {
+            times->Start(static_cast<Phase>(k));
+            if (k == static_cast<size_t>(Phase::EXECUTE)) usleep(1000);
+            if (sql.size() > limits[k]) {
+                times->Stop();
+                *error_msg = PhaseName(static_cast<Phase>(k));
+                return false;
+            }
+        }
+        times->Stop();
+        return true;
+    }
+};
+
+class ProbeCollector : public IProbeListener {
+public:
+    explicit ProbeCollector(std::vector<Probe> *probes) : probes_(probes) {}
+    void OnProbe(const Probe &probe) override { probes_->push_back(probe); }
+
+private:
+    std::vector<Probe> *probes_;
+};
+
+TEST(Driver, StopAfter) {
+    for (auto [phase, limit] : {std::pair(Phase::PARSE, 200), {Phase::OPTIMIZE, 50}, {Phase::EXECUTE, 20}}) {
+        std::vector<Probe> probes;
+        Driver d;
+        d.set_check_crash(phase == Phase::OPTIMIZE);
+        d.set_stop_after(phase);
+        d.AddProbeListener(std::make_unique<ProbeCollector>(&probes));
+        TestFeature f;
+        PhasedProvider p;
+        auto results = d.Run(&p, &f);
+        ASSERT_FALSE(results.empty());
+        EXPECT_EQ(limit, results[0].limit);
+        EXPECT_EQ(phase, results[0].phase);
+        EXPECT_EQ(PhaseName(phase), results[0].status.message());
+        for (const auto &probe : probes) {
+            // Only the phases run are timed
+            if (phase == Phase::EXECUTE && probe.status.code() == Status::SUCCESS) {
+                EXPECT_GE(probe.phases.time(Phase::EXECUTE).count(), 1000);
+            } else if (phase != Phase::EXECUTE) {
+                EXPECT_EQ(0, probe.phases.time(Phase::EXECUTE).count());
+            }
+        }
+    }
+    // Providers without phases are only checked through execution
+    const char *argv[] = {"test", "--stop_after=optimize", nullptr};
+    Driver d(2, const_cast<char **>(argv));
+    d.AddProvider(std::make_unique<ErrorProvider>(10));
+    d.AddProvider(std::make_unique<PhasedProvider>());
+    d.set_feature_names("parenthesis");
+    d.set_explore_beyond_first_failure(false);
+    auto results = d.Run();
+    ASSERT_EQ(1, results.size());
+    EXPECT_EQ("phased", results[0].provider);
+    Phase phase;
+    EXPECT_FALSE(ParsePhase("plan", &phase));
+    EXPECT_TRUE(ParsePhase("bind", &phase));
+    EXPECT_EQ(Phase::BIND, phase);
+}
+
+// Server stand-in with a pool of connections, each executing a statement by sleeping for as
+// many milliseconds as the statement is long
+class SleepServer : public IAsyncSQLProvider {
+public:
+    explicit SleepServer(size_t connections) : connections_(connections) {
+        for (size_t k = 0; k < connections; k++) workers_.emplace_back([this] { Work(); });
+    }
+    ~SleepServer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto &worker : workers_) worker.join();
+    }
+    std::string name() const override { return "sleep server"; }
+    size_t max_in_flight() const override { return connections_; }
+
+    void Submit(std::string_view sql, Clock::time_point deadline, Callback callback) override {
+        auto request = std::make_shared<Request>();
+        request->duration = std::chrono::milliseconds(sql.size());
+        request->deadline = deadline;
+        request->submitted = Clock::now();
+        request->callback = std::move(callback);
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(request);
+        in_flight_.push_back(request);
+        max_in_flight_seen = std::max(max_in_flight_seen, in_flight_.size());
+        work_cv_.notify_all();
+    }
+
+    void Poll(std::chrono::milliseconds timeout) override {
+        std::vector<std::shared_ptr<Request>> ready;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            const auto until = Clock::now() + timeout;
+            for (;;) {
+                const auto now = Clock::now();
+                auto wake = until;
+                for (auto it = in_flight_.begin(); it != in_flight_.end();) {
+                    auto &request = *it;
+                    if (!request->done && now >= request->deadline) {
+                        request->cancelled = request->done = true;
+                        request->status = Status(Status::TIMEOUT);
+                        request->latency =
+                                std::chrono::duration_cast<std::chrono::microseconds>(now - request->submitted);
+                        work_cv_.notify_all();
+                    }
+                    if (request->done) {
+                        ready.push_back(request);
+                        it = in_flight_.erase(it);
+                    } else {
+                        wake = std::min(wake, request->deadline);
+                        ++it;
+                    }
+                }
+                if (!ready.empty() || now >= until) break;
+                done_cv_.wait_until(lock, wake);
+            }
+        }
+        for (auto &request : ready) request->callback(request->status, request->latency);
+    }
+
+    size_t max_in_flight_seen = 0;
+
+private:
+    struct Request {
+        std::chrono::milliseconds duration;
+        Clock::time_point deadline;
+        Clock::time_point submitted;
+        Callback callback;
+        bool cancelled = false;
+        bool done = false;
+        Status status;
+        std::chrono::microseconds latency;
+    };
+
+    void Work() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            work_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+            if (stop_) return;
+            auto request = queue_.front();
+            queue_.pop_front();
+            if (work_cv_.wait_for(lock, request->duration, [&] { return stop_ || request->cancelled; })) continue;
+            request->done = true;
+            request->latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - request->submitted);
+            done_cv_.notify_all();
+        }
+    }
+
+    const size_t connections_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<std::shared_ptr<Request>> queue_;
+    std::list<std::shared_ptr<Request>> in_flight_;
+    bool stop_ = false;
+    std::vector<std::thread> workers_;
+};
+
+TEST(AsyncProvider, RunAll) {
+    SleepServer server(64);
+    std::vector<std::string> sqls(64, std::string(30, 'x'));
+    sqls.push_back(std::string(1000, 'x'));
+    std::vector<Status> statuses;
+    std::vector<std::chrono::microseconds> latencies;
+    const auto start = std::chrono::steady_clock::now();
+    server.RunAll(std::vector<std::string_view>(sqls.begin(), sqls.end()), std::chrono::milliseconds(200), &statuses,
+                  &latencies);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_EQ(sqls.size(), statuses.size());
+    for (size_t i = 0; i + 1 < sqls.size(); i++) {
+        EXPECT_EQ(Status::SUCCESS, statuses[i].code()) << i;
+        EXPECT_GE(latencies[i], std::chrono::milliseconds(30));
+    }
+    // The long statement is cancelled at its deadline
+    EXPECT_EQ(Status::TIMEOUT, statuses.back().code());
+    EXPECT_LT(elapsed, std::chrono::milliseconds(900));
+    EXPECT_EQ(64, server.max_in_flight_seen);
+}
+
+// Misbehaving server: never reports statements longer than 10 bytes, and reports the others
+// twice, the second time as an error
+class UnreliableServer : public IAsyncSQLProvider {
+public:
+    std::string name() const override { return "unreliable server"; }
+    void Submit(std::string_view sql, Clock::time_point deadline, Callback callback) override {
+        if (sql.size() <= 10) ready_.push_back(std::move(callback));
+    }
+    void Poll(std::chrono::milliseconds timeout) override {
+        for (auto &callback : ready_) {
+            callback(Status(), std::chrono::microseconds(1));
+            callback(Status(Status::ERROR, "reported twice"), std::chrono::microseconds(2));
+        }
+        ready_.clear();
+        std::this_thread::sleep_for(timeout);
+    }
+
+private:
+    std::vector<Callback> ready_;
+};
+
+TEST(AsyncProvider, MissedDeadlines) {
+    UnreliableServer server;
+    std::vector<std::string> sqls = {"x", std::string(20, 'x'), "xx", "xxx"};
+    std::vector<Status> statuses;
+    std::vector<std::chrono::microseconds> latencies;
+    server.RunAll(std::vector<std::string_view>(sqls.begin(), sqls.end()), std::chrono::milliseconds(50), &statuses,
+                  &latencies);
+    ASSERT_EQ(4, statuses.size());
+    EXPECT_EQ(Status::SUCCESS, statuses[0].code());
+    EXPECT_EQ(Status::TIMEOUT, statuses[1].code());
+    EXPECT_GE(latencies[1], std::chrono::milliseconds(50));
+    EXPECT_EQ(Status::SUCCESS, statuses[2].code());
+    EXPECT_EQ(Status::SUCCESS, statuses[3].code());
+    EXPECT_EQ(std::chrono::microseconds(1), latencies[3]);
+}
+
+TEST(AsyncProvider, Driver) {
+    Driver d;
+    TestFeature f;
+    SleepServer server(8);
+    auto results = d.Run(&server, &f);
+    ASSERT_EQ(1, results.size());
+    EXPECT_EQ(Status::TIMEOUT, results[0].status.code());
+    EXPECT_GE(results[0].limit, 64);
+    EXPECT_LE(results[0].limit, 100);
+    // Explore-beyond waves are in flight at once
+    EXPECT_EQ(4, server.max_in_flight_seen);
+}
+
+TEST(Driver, Frontier) {
+    Driver d;
+    d.set_check_crash(false);
+    TestMultiFeature f;
+    ErrorProvider e(100);
+    auto result = d.RunFrontier(&e, &f);
+    EXPECT_EQ(Status::ERROR, result.status.code());
+    std::vector<std::vector<size_t>> expected = {{1, 100}, {2, 50}, {4, 25}, {8, 12}, {16, 6}, {32, 3}, {100, 1}};
+    EXPECT_EQ(expected, result.frontier);
+    // A full grid up to the one-dimensional limits would take 100 * 100 probes
+    EXPECT_LT(result.probes, 60);
+}
+
+// @n characters followed by @holes_ hole tokens, for nesting TestFragment into.
+template <size_t holes_>
+class TestHoleFeature : public ISQLFeature {
+public:
+    std::string name() override { return std::to_string(holes_) + " holes"; }
+    std::string_view GenerateSQL(size_t n) override {
+        sql_.assign(n, 'a');
+        sql_.append(holes_, 'h');
+        return sql_;
+    }
+    Hole hole() const override { return {FragmentKind::QUERY, "h"}; }
+};
+
+class TestFragment : public TestFeature {
+public:
+    FragmentKind fragment_kind() const override { return FragmentKind::QUERY; }
+};
+
+std::vector<std::unique_ptr<ISQLFeature>> MakeInteractionFeatures() {
+    std::vector<std::unique_ptr<ISQLFeature>> features;
+    features.emplace_back(std::make_unique<TestHoleFeature<1>>());
+    features.emplace_back(std::make_unique<TestHoleFeature<20>>());
+    features.emplace_back(std::make_unique<TestFragment>());
+    return features;
+}
+
+TEST(Driver, Interactions) {
+    Driver d;
+    d.set_check_crash(false);
+    d.set_explore_beyond_first_failure(false);
+    ErrorProvider e(100);
+    auto results = d.RunInteractions(&e, 10, 0, MakeInteractionFeatures);
+    // Only the fragment fits into the holes
+    ASSERT_EQ(2, results.size());
+    std::map<std::string, InteractionResult> by_name;
+    for (auto &result : results) by_name[result.nested.feature] = result;
+
+    const auto &one = by_name.at("1 holes x Test");
+    EXPECT_EQ(99, one.outer_limit);
+    EXPECT_EQ(100, one.inner_limit);
+    EXPECT_EQ(99, one.nested.frontier.front()[1]);
+    EXPECT_FALSE(one.blowup);
+
+    // Twenty copies of the fragment leave it a twentieth of its own limit
+    const auto &twenty = by_name.at("20 holes x Test");
+    EXPECT_EQ(80, twenty.outer_limit);
+    EXPECT_EQ(100, twenty.inner_limit);
+    EXPECT_EQ(4, twenty.nested.frontier.front()[1]);
+    EXPECT_TRUE(twenty.blowup);
+}
+
+class CountingFeature : public TestFeature {
+public:
+    std::string_view GenerateSQL(size_t n) override {
+        generated++;
+        return TestFeature::GenerateSQL(n);
+    }
+    size_t generated = 0;
+};
+
+TEST(Driver, Lockstep) {
+    SyntheticProvider::Model model;
+    model.unit_us = 0;
+    model.fail_at = 101;
+    SyntheticProvider a("a", model), b("b", model);
+    model.fail_at = 38;
+    SyntheticProvider c("c", model);
+    Driver d;
+    d.set_check_crash(false);
+    std::vector<Probe> probes;
+    d.AddProbeListener(std::make_unique<ProbeCollector>(&probes));
+    CountingFeature f;
+    auto result = d.RunLockstep({&a, &b, &c}, &f);
+    ASSERT_EQ(3, result.limits.size());
+    EXPECT_EQ(100, result.limits[0].limit);
+    EXPECT_EQ(100, result.limits[1].limit);
+    EXPECT_EQ(37, result.limits[2].limit);
+    EXPECT_EQ(Status::ERROR, result.limits[2].status.code());
+    EXPECT_EQ(std::vector<std::string>({"a", "b", "c"}), result.providers);
+
+    // Same limits as searching one provider at a time, which generates 14 + 14 + 12 statements
+    Driver single;
+    single.set_check_crash(false);
+    single.set_explore_beyond_first_failure(false);
+    TestFeature g;
+    EXPECT_EQ(37, single.Run(&c, &g)[0].limit);
+    EXPECT_EQ(19, f.generated);
+    EXPECT_EQ(19, result.generated);
+    EXPECT_EQ(40, result.checked);
+    EXPECT_EQ(40, probes.size());
+
+    // Rows by size, with only the providers which needed the size checked
+    ASSERT_EQ(19, result.rows.size());
+    EXPECT_EQ(1, result.rows[0].n);
+    EXPECT_EQ(std::vector<bool>({true, true, true}), result.rows[0].checked);
+    const auto &row = *std::find_if(result.rows.begin(), result.rows.end(), [](const auto &r) { return r.n == 96; });
+    EXPECT_EQ(std::vector<bool>({true, true, false}), row.checked);
+    EXPECT_EQ(Status::SUCCESS, row.statuses[0].code());
+    const auto &last = result.rows.back();
+    EXPECT_EQ(128, last.n);
+    EXPECT_EQ(Status::ERROR, last.statuses[0].code());
+}
+
+// Feature whose statements grow exponentially in @n, here a byte per n for brevity
+class ExponentialFeature : public TestFeature {
+public:
+    bool is_exponential() const override { return true; }
+};
+
+TEST(Driver, LockstepExponential) {
+    SyntheticProvider::Model model;
+    model.unit_us = 0;
+    model.fail_at = 6;
+    SyntheticProvider a("a", model);
+    model.fail_at = 4;
+    SyntheticProvider b("b", model);
+    Driver d;
+    d.set_check_crash(false);
+    d.set_explore_beyond_first_failure(false);
+    ExponentialFeature f;
+    auto result = d.RunLockstep({&a, &b}, &f);
+    ASSERT_EQ(2, result.limits.size());
+    // Run reports the first size which fails for exponential features, and so does lockstep
+    EXPECT_EQ(d.Run(&a, &f)[0].limit, result.limits[0].limit);
+    EXPECT_EQ(d.Run(&b, &f)[0].limit, result.limits[1].limit);
+    EXPECT_EQ(6, result.limits[0].limit);
+    EXPECT_EQ(4, result.limits[1].limit);
+}
+
+TEST(Driver, SLO) {
+    // 10us a byte, failing past 800 bytes
+    SyntheticProvider::Model model;
+    model.unit_us = 10;
+    model.fail_at = 800;
+    SyntheticProvider provider("p", model);
+    Driver d;
+    d.set_check_crash(false);
+    d.set_latency_thresholds({std::chrono::milliseconds(4), std::chrono::milliseconds(1)});
+    std::vector<Probe> probes;
+    d.AddProbeListener(std::make_unique<ProbeCollector>(&probes));
+    TestFeature f;
+    auto result = d.RunSLO(&provider, &f);
+    EXPECT_EQ(std::vector<std::chrono::milliseconds>({std::chrono::milliseconds(1), std::chrono::milliseconds(4)}),
+              result.thresholds);
+    ASSERT_EQ(2, result.limits.size());
+    // Sleeps overshoot, so the limits fall a little short of 100 and 400
+    EXPECT_LE(result.limits[0], 100);
+    EXPECT_GE(result.limits[0], 60);
+    EXPECT_LE(result.limits[1], 400);
+    EXPECT_GE(result.limits[1], 300);
+    EXPECT_EQ(799, result.hard_limit);
+    EXPECT_EQ(Status::ERROR, result.status.code());
+
+    // Sizes double up to 1024, then each check narrows every interval it falls in, so no size is
+    // checked twice and the intervals cost no more than bisecting each on its own
+    EXPECT_EQ(probes.size(), result.probes);
+    EXPECT_LE(result.probes, 11 + 6 + 8 + 9);
+    std::set<size_t> sizes;
+    for (const auto &probe : probes) sizes.insert(probe.dims[0]);
+    EXPECT_EQ(probes.size(), sizes.size());
+
+    // Run gives a result per threshold, next to the hard limit
+    const char *argv[] = {"test", "--slo_ms=4,1", "--features=parenthesis", nullptr};
+    Driver all(3, const_cast<char **>(argv));
+    all.set_check_crash(false);
+    all.AddProvider(std::make_unique<SyntheticProvider>("p", model));
+    auto results = all.Run();
+    ASSERT_EQ(3, results.size());
+    EXPECT_EQ("parenthesis@<=1ms", results[0].feature);
+    EXPECT_EQ("parenthesis@<=4ms", results[1].feature);
+    EXPECT_EQ("parenthesis", results[2].feature);
+    EXPECT_LE(results[0].limit, results[1].limit);
+    EXPECT_LE(results[1].limit, results[2].limit);
+    EXPECT_LT(results[1].limit, 395);
+    EXPECT_EQ(Status::TIMEOUT, results[1].status.code());
+    EXPECT_EQ("latency over <=4ms", results[1].status.message());
+    EXPECT_EQ(Status::ERROR, results[2].status.code());
+}
+
+TEST(Driver, AB) {
+    // B is 50% slower than A and both fail past 1000 bytes
+    SyntheticProvider::Model model;
+    model.unit_us = 1;
+    model.fail_at = 1000;
+    const char *argv[] = {"test", "--ab=a,b", "--ab_repetitions=8", "--features=parenthesis", nullptr};
+    Driver d(4, const_cast<char **>(argv));
+    d.set_check_crash(false);
+    d.AddProvider(std::make_unique<SyntheticProvider>("a", model));
+    model.unit_us = 1.5;
+    d.AddProvider(std::make_unique<SyntheticProvider>("b", model));
+    std::vector<Probe> probes;
+    d.AddProbeListener(std::make_unique<ProbeCollector>(&probes));
+    auto results = d.Run();
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ("a", results[0].provider);
+    EXPECT_EQ("b", results[1].provider);
+    EXPECT_EQ(results[0].limit, results[1].limit);
+    EXPECT_EQ(Status::ERROR, results[0].status.code());
+
+    // Providers alternate at every size, each checking the same statements
+    ASSERT_GE(probes.size(), 4);
+    EXPECT_EQ("a", probes[0].provider);
+    EXPECT_EQ("b", probes[1].provider);
+    EXPECT_EQ("b", probes[2].provider);
+    EXPECT_EQ("a", probes[3].provider);
+    EXPECT_EQ(2 * 8 * 10, probes.size());
+
+    Driver direct;
+    direct.set_check_crash(false);
+    direct.set_ab_providers("a", "b", 8);
+    SyntheticProvider a("a", model);
+    model.unit_us = 3;
+    SyntheticProvider slow("slow", model);
+    TestFeature f;
+    auto sizes = direct.RunAB(&a, &slow, &f);
+    ASSERT_FALSE(sizes.empty());
+    const ABResult &last = sizes.back();
+    EXPECT_EQ(Status::ERROR, last.status_a.code());
+    // Sleeps overshoot, so the ratio of the largest successful size is not quite 2
+    const ABResult &largest = sizes[sizes.size() - 2];
+    EXPECT_EQ(8, largest.comparison.pairs);
+    EXPECT_GT(largest.comparison.change, 0.5);
+    EXPECT_TRUE(largest.comparison.significant());
+    EXPECT_GT(largest.median_b, largest.median_a);
+
+    // Under perftrace the output is only trace lines, one per probe
+    std::stringstream output;
+    std::streambuf *saved = std::cout.rdbuf(output.rdbuf());
+    direct.set_perftrace(true);
+    sizes = direct.RunAB(&a, &slow, &f);
+    std::cout.rdbuf(saved);
+    size_t lines = 0;
+    for (std::string line; std::getline(output, line); lines++) {
+        EXPECT_THAT(line, testing::AnyOf(testing::StartsWith("a,Test,"), testing::StartsWith("slow,Test,")));
+    }
+    EXPECT_EQ(2 * 8 * sizes.size(), lines);
+}
+
+TEST(Driver, ABExponential) {
+    // Exponential features grow by one, and the limit is the first size which fails, as in Run
+    SyntheticProvider::Model model;
+    model.unit_us = 0;
+    model.fail_at = 5;
+    Driver d;
+    d.set_check_crash(false);
+    d.set_ab_providers("a", "b", 2);
+    SyntheticProvider a("a", model), b("b", model);
+    ExponentialFeature f;
+    auto sizes = d.RunAB(&a, &b, &f);
+    ASSERT_EQ(5, sizes.size());
+    for (size_t k = 0; k < sizes.size(); k++) EXPECT_EQ(k + 1, sizes[k].n);
+    EXPECT_EQ(Status::ERROR, sizes.back().status_a.code());
+
+    const char *argv[] = {"test", "--ab=a,b", "--ab_repetitions=2", "--features=replace", nullptr};
+    Driver all(4, const_cast<char **>(argv));
+    all.set_check_crash(false);
+    model.fail_at = 100;
+    all.AddProvider(std::make_unique<SyntheticProvider>("a", model));
+    all.AddProvider(std::make_unique<SyntheticProvider>("b", model));
+    Driver single;
+    single.set_check_crash(false);
+    single.set_explore_beyond_first_failure(false);
+    SyntheticProvider c("c", model);
+    auto results = all.Run();
+    ASSERT_EQ(2, results.size());
+    EXPECT_EQ(single.Run(&c, GetFeature("replace").get())[0].limit, results[0].limit);
+}
+
 }  // namespace
 }  // namespace tensile
 
@@ -0,0 +1,133 @@
+#include "timeline.h"
+#include "results_writer.h"
+#include "trace_ring.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace tensile {
+
+namespace {
+
+// Appends @ns relative to @origin_ns in microseconds, the unit of the format
+void AppendMicros(int64_t ns, std::string *out) {
+    char micros[32];
+    std::snprintf(micros, sizeof(micros), "%.3f", ns / 1e3);
+    *out += micros;
+}
+
+}  // namespace
+
+TimelineWriter::Scope::Scope(TimelineWriter *timeline, std::string_view name) : timeline_(timeline), name_(name) {
+    if (timeline_ != nullptr) start_ns_ = MonotonicNanos();
+}
+
+TimelineWriter::Scope::~Scope() {
+    if (timeline_ != nullptr) timeline_->Slice(name_, start_ns_, MonotonicNanos());
+}
+
+TimelineWriter::~TimelineWriter() {
+    std::string error;
+    if (is_open() && !Close(&error)) {
+        std::cerr << "timeline: " << error << std::endl;
+    }
+}
+
+bool TimelineWriter::Open(const std::string &path, std::string *error) {
+    file_.open(path, std::ios::out | std::ios::trunc);
+    if (!file_) {
+        *error = "cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    path_ = path;
+    origin_ns_ = MonotonicNanos();
+    first_event_ = true;
+    slots_.clear();
+    file_ << "{\"traceEvents\":[";
+    return true;
+}
+
+void TimelineWriter::Slice(std::string_view name, int64_t start_ns, int64_t end_ns, const Args &args) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_open()) return;
+    std::string event = "{\"ph\":\"X\",\"name\":";
+    AppendJsonString(name, &event);
+    event += ",\"pid\":" + std::to_string(getpid()) + ",\"tid\":" + std::to_string(Slot()) + ",\"ts\":";
+    AppendMicros(start_ns - origin_ns_, &event);
+    event += ",\"dur\":";
+    AppendMicros(std::max<int64_t>(end_ns - start_ns, 0), &event);
+    if (!args.empty()) {
+        event += ",\"args\":{";
+        for (size_t k = 0; k < args.size(); k++) {
+            if (k > 0) event += ',';
+            AppendJsonString(args[k].first, &event);
+            event += ':';
+            AppendJsonString(args[k].second, &event);
+        }
+        event += '}';
+    }
+    event += '}';
+    Append(event);
+}
+
+void TimelineWriter::Counter(std::string_view name, int64_t ns, double value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_open()) return;
+    std::string event = "{\"ph\":\"C\",\"name\":";
+    AppendJsonString(name, &event);
+    event += ",\"pid\":" + std::to_string(getpid()) + ",\"ts\":";
+    AppendMicros(ns - origin_ns_, &event);
+    char number[32];
+    std::snprintf(number, sizeof(number), "%g", value);
+    event += ",\"args\":{\"value\":";
+    event += number;
+    event += "}}";
+    Append(event);
+}
+
+bool TimelineWriter::Close(std::string *error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_open()) return true;
+    file_ << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    file_.close();
+    if (file_.fail()) {
+        *error = "cannot write " + path_;
+        return false;
+    }
+    return true;
+}
+
+size_t TimelineWriter::Slot() {
+    auto [slot, added] = slots_.emplace(std::this_thread::get_id(), slots_.size());
+    if (added) {
+        Append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + std::to_string(getpid()) + ",\"tid\":" +
+               std::to_string(slot->second) + ",\"args\":{\"name\":\"worker " + std::to_string(slot->second) +
+               "\"}}");
+    }
+    return slot->second;
+}
+
+void TimelineWriter::Append(const std::string &event) {
+    file_ << (first_event_ ? "\n" : ",\n") << event;
+    first_event_ = false;
+}
+
+size_t ResidentSetBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+size_t PeakResidentSetBytes() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // Linux reports kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+}  // namespace tensile
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tensile {
+
+// Writes a timeline in the Chrome Trace Event JSON format, which Perfetto and chrome://tracing
+// load. Every thread which records slices gets a track of its own, a worker slot numbered in the
+// order the threads first record. Slices on a track must nest. Times are CLOCK_MONOTONIC
+// nanoseconds as from MonotonicNanos, written relative to opening the file. Events are written
+// as they are recorded, from any thread.
+class TimelineWriter {
+public:
+    // Names and values of the details of a slice
+    using Args = std::vector<std::pair<std::string, std::string>>;
+
+    // Records a slice on the calling thread's track for the lifetime of the scope, if @timeline
+    // is not null
+    class Scope {
+    public:
+        Scope(TimelineWriter *timeline, std::string_view name);
+        ~Scope();
+
+    private:
+        TimelineWriter *timeline_;
+        std::string_view name_;
+        int64_t start_ns_ = 0;
+    };
+
+    TimelineWriter() {}
+
+    // Closes the file, reporting write errors to stderr
+    ~TimelineWriter();
+
+    // Creates the file at @path. Returns false with the reason in @error on failure.
+    bool Open(const std::string &path, std::string *error);
+
+    // Records slice @name from @start_ns to @end_ns on the calling thread's track
+    void Slice(std::string_view name, int64_t start_ns, int64_t end_ns, const Args &args = {});
+
+    // Records @value of counter @name at @ns
+    void Counter(std::string_view name, int64_t ns, double value);
+
+    // Ends the JSON and closes the file. Returns false with the reason in @error if writing
+    // failed.
+    bool Close(std::string *error);
+
+    bool is_open() const { return file_.is_open(); }
+
+private:
+    // Slot of the calling thread, naming its track when it is new. Requires mutex_.
+    size_t Slot();
+
+    // Appends @event, a JSON object, to the array of events. Requires mutex_.
+    void Append(const std::string &event);
+
+    std::ofstream file_;
+    std::string path_;
+    std::mutex mutex_;
+    std::map<std::thread::id, size_t> slots_;
+    int64_t origin_ns_ = 0;
+    bool first_event_ = true;
+};
+
+// Resident set size of this process in bytes, or 0 if it cannot be read
+size_t ResidentSetBytes();
+
+// Peak resident set size of this process in bytes
+size_t PeakResidentSetBytes();
+
+}  // namespace tensile
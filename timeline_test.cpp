@@ -0,0 +1,121 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include "reference_parser.h"
+#include "timeline.h"
+#include "trace_ring.h"
+
+#include <algorithm>
+#include <fstream>
+#include <regex>
+
+namespace tensile {
+namespace {
+
+std::string Path(const std::string &name) { return testing::TempDir() + name; }
+
+struct Slice {
+    std::string name;
+    int tid;
+    double start_us;
+    double end_us;
+};
+
+// Slices of a timeline file, which has one event per line
+std::vector<Slice> ReadSlices(const std::string &path) {
+    const std::regex slice(R"re(\{"ph":"X","name":"([^"]*)","pid":\d+,"tid":(\d+),"ts":([-0-9.]+),"dur":([0-9.]+))re");
+    std::vector<Slice> slices;
+    std::ifstream file(path);
+    std::smatch match;
+    for (std::string line; std::getline(file, line);) {
+        if (!std::regex_search(line, match, slice)) continue;
+        const double start = std::stod(match[3]);
+        slices.push_back({match[1], std::stoi(match[2]), start, start + std::stod(match[4])});
+    }
+    return slices;
+}
+
+std::string Contents(const std::string &path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+TEST(TimelineWriter, TracksAndCounters) {
+    const std::string path = Path("timeline_tracks");
+    TimelineWriter timeline;
+    std::string error;
+    ASSERT_TRUE(timeline.Open(path, &error)) << error;
+    const int64_t start = MonotonicNanos();
+    timeline.Slice("outer", start, start + 3000, {{"key", "quoted \"value\""}});
+    std::thread([&] { timeline.Slice("other", start, start + 1000); }).join();
+    timeline.Counter("in_flight", start, 2);
+    {
+        TimelineWriter::Scope scope(&timeline, "scoped");
+    }
+    TimelineWriter::Scope ignored(nullptr, "ignored");
+    ASSERT_TRUE(timeline.Close(&error)) << error;
+
+    const std::string contents = Contents(path);
+    EXPECT_EQ(0, contents.find("{\"traceEvents\":[\n"));
+    EXPECT_THAT(contents, testing::EndsWith("\n],\"displayTimeUnit\":\"ns\"}\n"));
+    EXPECT_THAT(contents, testing::HasSubstr("\"args\":{\"name\":\"worker 0\"}"));
+    EXPECT_THAT(contents, testing::HasSubstr("\"args\":{\"name\":\"worker 1\"}"));
+    EXPECT_THAT(contents, testing::HasSubstr("\"args\":{\"key\":\"quoted \\\"value\\\"\"}"));
+    EXPECT_THAT(contents, testing::HasSubstr("{\"ph\":\"C\",\"name\":\"in_flight\""));
+    EXPECT_THAT(contents, testing::HasSubstr("\"args\":{\"value\":2}}"));
+    EXPECT_THAT(contents, testing::Not(testing::HasSubstr("ignored")));
+
+    const auto slices = ReadSlices(path);
+    ASSERT_EQ(3, slices.size());
+    EXPECT_EQ("outer", slices[0].name);
+    EXPECT_EQ(0, slices[0].tid);
+    EXPECT_NEAR(3, slices[0].end_us - slices[0].start_us, 1e-9);
+    EXPECT_EQ("other", slices[1].name);
+    EXPECT_EQ(1, slices[1].tid);
+    EXPECT_EQ("scoped", slices[2].name);
+    EXPECT_EQ(0, slices[2].tid);
+}
+
+TEST(TimelineWriter, Driver) {
+    const std::string path = Path("timeline_driver");
+    {
+        const std::string flag = "--timeline=" + path;
+        const char *argv[] = {"test", flag.c_str(), nullptr};
+        Driver driver(2, const_cast<char **>(argv));
+        ASSERT_NE(nullptr, driver.timeline());
+        driver.set_check_crash(true);
+        ReferenceParser::Limits limits;
+        limits.max_depth = 40;
+        ReferenceParser provider(limits);
+        for (auto &feature : GetBuiltinFeatures()) {
+            if (feature->name() == "parenthesis") driver.Run(&provider, feature.get());
+        }
+    }
+    const std::string contents = Contents(path);
+    for (const char *counter : {"probes_in_flight", "rss_mib", "checker_peak_rss_mib"}) {
+        EXPECT_THAT(contents, testing::HasSubstr(std::string("\"name\":\"") + counter + "\""));
+    }
+    auto slices = ReadSlices(path);
+    std::vector<std::string> names;
+    for (const auto &slice : slices) names.push_back(slice.name);
+    for (const char *name : {"generate", "probe", "fork", "parse", "ipc"}) {
+        EXPECT_THAT(names, testing::Contains(name));
+    }
+
+    // Slices of the track nest, as the format requires, up to rounding of the times
+    constexpr double kRoundingUs = 0.002;
+    std::sort(slices.begin(), slices.end(), [](const Slice &a, const Slice &b) {
+        return a.start_us < b.start_us || (a.start_us == b.start_us && a.end_us > b.end_us);
+    });
+    std::vector<Slice> open;
+    for (const auto &slice : slices) {
+        EXPECT_EQ(0, slice.tid);
+        while (!open.empty() && open.back().end_us <= slice.start_us + kRoundingUs) open.pop_back();
+        if (!open.empty()) {
+            EXPECT_LE(slice.end_us, open.back().end_us + kRoundingUs) << slice.name << " overlaps " << open.back().name;
+        }
+        open.push_back(slice);
+    }
+}
+
+}  // namespace
+}  // namespace tensile
@@ -0,0 +1,96 @@
+#include "trace_ring.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <time.h>
+
+namespace tensile {
+
+// Atomics in shared memory only work across processes if they never fall back to a lock
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "trace ring needs lock-free 64-bit atomics");
+
+struct TraceRing::Header {
+    // Count of slots ever reserved
+    std::atomic<uint64_t> head{0};
+    // Count of slots ever consumed
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+struct TraceRing::Slot {
+    // Reservation count of the event plus one once it is published
+    std::atomic<uint64_t> sequence{0};
+    TraceEvent event;
+};
+
+TraceRing::~TraceRing() {
+    if (header_ != nullptr) munmap(header_, mapped_bytes_);
+}
+
+bool TraceRing::Open(size_t capacity, std::string *error) {
+    if (header_ != nullptr) {
+        *error = "trace ring is already open";
+        return false;
+    }
+    if (capacity == 0) {
+        *error = "trace ring needs a capacity";
+        return false;
+    }
+    const size_t bytes = sizeof(Header) + capacity * sizeof(Slot);
+    void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        *error = std::string("cannot map trace ring: ") + std::strerror(errno);
+        return false;
+    }
+    header_ = new (memory) Header();
+    slots_ = reinterpret_cast<Slot *>(static_cast<char *>(memory) + sizeof(Header));
+    for (size_t i = 0; i < capacity; i++) new (&slots_[i]) Slot();
+    capacity_ = capacity;
+    mapped_bytes_ = bytes;
+    return true;
+}
+
+bool TraceRing::Push(const TraceEvent &event) {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    do {
+        if (head - header_->tail.load(std::memory_order_acquire) >= capacity_) {
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!header_->head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                                  std::memory_order_relaxed));
+    Slot &slot = slots_[head % capacity_];
+    slot.event = event;
+    slot.sequence.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+uint64_t TraceRing::reserved() const { return header_->head.load(std::memory_order_acquire); }
+
+void TraceRing::Drain(std::vector<TraceEvent> *events, uint64_t abandoned) {
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    const uint64_t head = header_->head.load(std::memory_order_acquire);
+    for (; tail < head; tail++) {
+        Slot &slot = slots_[tail % capacity_];
+        if (slot.sequence.load(std::memory_order_acquire) == tail + 1) {
+            events->push_back(slot.event);
+        } else if (tail >= abandoned) {
+            break;
+        }
+        // Producers may reuse the slot from here on
+        header_->tail.store(tail + 1, std::memory_order_release);
+    }
+}
+
+uint64_t TraceRing::dropped() const { return header_->dropped.load(std::memory_order_relaxed); }
+
+int64_t MonotonicNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+}  // namespace tensile
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tensile {
+
+// Event of one statement checked with perftrace on, written by the process which ran it
+struct TraceEvent {
+    // Check the statement belongs to, assigned by the driver
+    uint64_t check = 0;
+    // CLOCK_MONOTONIC times, which forked processes share, in nanoseconds
+    int64_t start_ns = 0;
+    int64_t end_ns = 0;
+    int32_t pid = 0;
+    // Last phase the statement started, as a Phase
+    uint8_t phase = 0;
+    // SUCCESS or ERROR as a Status::Code
+    uint8_t status = 0;
+};
+
+// Bounded multi-producer, single-consumer ring of TraceEvents in memory shared with the processes
+// forked after it is opened, so that checkers report timings without stdio. Producers reserve a
+// slot by advancing the head, write the event and publish it with the slot's sequence number; the
+// consumer takes published events in the order of reservation. Nothing blocks: events pushed to a
+// full ring are dropped and counted.
+class TraceRing {
+public:
+    TraceRing() {}
+    TraceRing(const TraceRing &) = delete;
+    TraceRing &operator=(const TraceRing &) = delete;
+    ~TraceRing();
+
+    // Maps a ring of @capacity events. Returns false with the reason in @error on failure.
+    bool Open(size_t capacity, std::string *error);
+
+    // Adds @event, from any thread or process. Returns false if the ring is full.
+    bool Push(const TraceEvent &event);
+
+    // Count of slots reserved so far
+    uint64_t reserved() const;
+
+    // Appends the published events to @events, stopping at the first slot reserved but not yet
+    // published. Slots among the first @abandoned reservations are skipped instead: the caller
+    // knows that the processes which reserved them were killed before publishing, e.g. because
+    // no checker was running when it read reserved().
+    void Drain(std::vector<TraceEvent> *events, uint64_t abandoned = 0);
+
+    // Events dropped because the ring was full
+    uint64_t dropped() const;
+
+    bool is_open() const { return header_ != nullptr; }
+
+private:
+    struct Header;
+    struct Slot;
+
+    Header *header_ = nullptr;
+    Slot *slots_ = nullptr;
+    size_t capacity_ = 0;
+    size_t mapped_bytes_ = 0;
+};
+
+// Current CLOCK_MONOTONIC time in nanoseconds, the clock of TraceEvent
+int64_t MonotonicNanos();
+
+}  // namespace tensile
@@ -0,0 +1,117 @@
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include "reference_parser.h"
+#include "trace_ring.h"
+
+#include <map>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace tensile {
+namespace {
+
+TraceEvent Event(uint64_t check) {
+    TraceEvent event;
+    event.check = check;
+    event.start_ns = MonotonicNanos();
+    event.end_ns = event.start_ns + 1;
+    event.pid = getpid();
+    return event;
+}
+
+// Provider, feature and size of a perftrace line
+std::string Key(const std::string &line) {
+    size_t end = 0;
+    for (int k = 0; k < 3 && end != std::string::npos; k++) end = line.find(',', end + 1);
+    return line.substr(0, end);
+}
+
+TEST(TraceRing, Full) {
+    TraceRing ring;
+    std::string error;
+    ASSERT_TRUE(ring.Open(4, &error)) << error;
+    for (uint64_t check = 0; check < 6; check++) EXPECT_EQ(check < 4, ring.Push(Event(check)));
+    EXPECT_EQ(2, ring.dropped());
+    std::vector<TraceEvent> events;
+    ring.Drain(&events);
+    ASSERT_EQ(4, events.size());
+    for (uint64_t check = 0; check < 4; check++) EXPECT_EQ(check, events[check].check);
+
+    // Drained slots are reused
+    EXPECT_TRUE(ring.Push(Event(6)));
+    events.clear();
+    ring.Drain(&events);
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ(6, events[0].check);
+    EXPECT_EQ(5, ring.reserved());
+}
+
+TEST(TraceRing, ForkedProducers) {
+    constexpr int kProducers = 4;
+    constexpr uint64_t kEvents = 1000;
+    TraceRing ring;
+    std::string error;
+    ASSERT_TRUE(ring.Open(kProducers * kEvents, &error)) << error;
+    std::vector<pid_t> pids;
+    for (int k = 0; k < kProducers; k++) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            for (uint64_t check = 0; check < kEvents; check++) ring.Push(Event(check));
+            _exit(0);
+        }
+        pids.push_back(pid);
+    }
+    for (pid_t pid : pids) waitpid(pid, nullptr, 0);
+
+    std::vector<TraceEvent> events;
+    ring.Drain(&events);
+    EXPECT_EQ(0, ring.dropped());
+    ASSERT_EQ(kProducers * kEvents, events.size());
+    // Every producer's events arrive complete and in the order it pushed them
+    std::map<int32_t, std::vector<uint64_t>> checks;
+    for (const auto &event : events) checks[event.pid].push_back(event.check);
+    ASSERT_EQ(kProducers, checks.size());
+    for (const auto &[pid, pushed] : checks) {
+        ASSERT_EQ(kEvents, pushed.size());
+        for (uint64_t check = 0; check < kEvents; check++) EXPECT_EQ(check, pushed[check]);
+    }
+}
+
+TEST(TraceRing, DriverPerftrace) {
+    // Forked checkers print nothing themselves, so every probe has exactly one line, timed to
+    // the nanosecond, in every mode
+    for (bool check_crash : {false, true}) {
+        std::stringstream output;
+        std::streambuf *saved = std::cout.rdbuf(output.rdbuf());
+        {
+            Driver driver;
+            driver.set_check_crash(check_crash);
+            driver.set_perftrace(true);
+            ReferenceParser::Limits limits;
+            limits.max_depth = 40;
+            ReferenceParser provider(limits);
+            for (auto &feature : GetBuiltinFeatures()) {
+                if (feature->name() == "parenthesis") driver.Run(&provider, feature.get());
+            }
+        }
+        std::cout.rdbuf(saved);
+        std::map<std::string, int> lines;
+        for (std::string line; std::getline(output, line);) lines[Key(line)]++;
+        // Perftrace only doubles the size, past the limit too
+        EXPECT_THAT(lines, testing::Contains(testing::Key("reference parser,parenthesis,32")));
+        EXPECT_THAT(lines, testing::Contains(testing::Key("reference parser,parenthesis,64")));
+        for (const auto &[key, count] : lines) EXPECT_EQ(1, count) << key;
+        output.clear();
+        output.seekg(0);
+        std::string line;
+        std::getline(output, line);
+        EXPECT_THAT(line, testing::MatchesRegex("reference parser,parenthesis,1,[0-9]+\\.[0-9]{6},OK,parse"));
+        while (std::getline(output, line) && Key(line) != "reference parser,parenthesis,64") {
+        }
+        EXPECT_THAT(line, testing::EndsWith(",ERROR,parse"));
+    }
+}
+
+}  // namespace
+}  // namespace tensile